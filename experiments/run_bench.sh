@@ -0,0 +1,26 @@
+#!/bin/bash
+# Sweep MPI rank counts with bench_ist and collect one CSV (plus one JSON per rank count)
+#
+# Usage: experiments/run_bench.sh [ranks...] -- [bench_ist options]
+# Example: experiments/run_bench.sh 1 2 4 -- --dims 5-9 --threads 1,2,4 --repeat 5
+
+set -e
+
+RANKS=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    RANKS+=("$1")
+    shift
+done
+[ "$1" = "--" ] && shift
+[ ${#RANKS[@]} -eq 0 ] && RANKS=(1 2 4)
+
+OUT_DIR=${OUT_DIR:-data/bench/$(date +%Y%m%d-%H%M%S)}
+MPIRUN=${MPIRUN:-mpirun}
+mkdir -p "$OUT_DIR"
+
+for np in "${RANKS[@]}"; do
+    echo "== $np rank(s) =="
+    $MPIRUN -np "$np" ./bench_ist "$@" --csv "$OUT_DIR/results.csv" --json "$OUT_DIR/results_np$np.json"
+done
+
+echo "Results written to $OUT_DIR"
@@ -27,9 +27,12 @@
 #ifndef BUBBLE_SORT_NETWORK_H
 #define BUBBLE_SORT_NETWORK_H
 
+// elements and inverse are kept consistent by every function below; code that
+// writes elements directly must call update_inverse afterwards
 typedef struct {
     int n;              // Dimension of permutation
     int* elements;      // Array of elements [1...n]
+    int* inverse;       // Position (1-based) of each symbol: inverse[s-1]
 } Permutation;
 
 typedef struct {
@@ -41,13 +44,21 @@ typedef struct {
 
 // Function prototypes
 BubbleSortNetwork* create_bubble_sort_network(int dimension);
+BubbleSortNetwork* create_bubble_sort_network_shape(int dimension);
+void fill_bubble_sort_network(BubbleSortNetwork* network, int start_vertex, int end_vertex);
 void free_bubble_sort_network(BubbleSortNetwork* network);
 Permutation* index_to_permutation(int index, int dimension);
 int permutation_to_index(Permutation* perm, int dimension);
 int is_identity_permutation(Permutation* perm);
 int right_position(Permutation* perm);
 int find_position(Permutation* perm, int value);
+Permutation* create_permutation(int dimension);
 Permutation* copy_permutation(Permutation* perm);
+void update_inverse(Permutation* perm);
+void swap_adjacent(Permutation* perm, int position);
+int next_permutation(Permutation* perm);
+int adjacent_swap_index(int index, int position, int dimension);
+int adjacent_swap_position(int index, int neighbor, int dimension);
 void free_permutation(Permutation* perm);
 
 #endif // BUBBLE_SORT_NETWORK_H
\ No newline at end of file
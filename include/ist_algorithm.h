@@ -51,6 +51,7 @@
 #define IST_ALGORITHM_H
 
 #include "bubble_sort_network.h"
+#include <stdint.h>
 
 typedef struct {
     int vertex_count;   // Number of vertices
@@ -62,18 +63,103 @@ typedef struct {
     SpanningTree* trees; // Array of spanning trees
 } IndependentSpanningTrees;
 
+// Branches of Parent1, named after the cases of the paper
+typedef enum {
+    PARENT_CASE_A111,   // Last symbol n, t != n-1, second-to-last symbol t or n-1
+    PARENT_CASE_A112,   // Last symbol n, t != n-1, any other second-to-last symbol
+    PARENT_CASE_A12,    // Last symbol n, t = 2 and Swap(v, t) = identity
+    PARENT_CASE_A2,     // Last symbol n, t = n-1
+    PARENT_CASE_B11,    // Last symbol n-1 (not B.2), t = n-1
+    PARENT_CASE_B12,    // Last symbol n-1 (not B.2), t != n-1
+    PARENT_CASE_B21,    // Last symbols n, n-1 and Swap(v, n) != identity, t != 1
+    PARENT_CASE_B22,    // Last symbols n, n-1 and Swap(v, n) != identity, t = 1
+    PARENT_CASE_C1,     // Last symbol in 1..n-2 and equal to t
+    PARENT_CASE_C2,     // Last symbol in 1..n-2 and not equal to t
+    PARENT_CASE_COUNT
+} ParentCase;
+
+// Time split of a kernel call, accumulated if passed to the kernel
+typedef struct {
+    double unrank;      // Seconds turning indices into permutations
+    double parent;      // Seconds computing and ranking parents
+} KernelTimes;
+
+// Fills the parents of vertices [start, end) in all trees (ist_kernels.h)
+typedef void (*ParentKernel)(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times);
+
 // Function prototypes for sequential implementation
 Permutation* Parent1(Permutation* v, int t, int n);
+int parent_swap_position(Permutation* v, int t, int n);
+ParentCase parent1_case(Permutation* v, int t, int n);
+const char* parent_case_name(ParentCase c);
 int is_swap_identity(Permutation* perm, int t);
 IndependentSpanningTrees* construct_sequential_ists(BubbleSortNetwork* network);
 
+struct ISTCheckpoint;
+struct SharedISTs;
+
+// Time spent in each phase of a parallel construction
+typedef struct {
+    double compute;     // Seconds computing the local vertex range
+    double exchange;    // Seconds exchanging results between ranks
+} ConstructionTimes;
+
+// Where the trees end up after a parallel construction
+typedef enum {
+    PLACEMENT_ALL,          // Every rank holds every tree (MPI_Allgatherv)
+    PLACEMENT_ROOT,         // Only rank 0 holds the trees (MPI_Gatherv)
+    PLACEMENT_DISTRIBUTED,  // Each rank keeps only the vertices it computed
+    PLACEMENT_COUNT
+} ResultPlacement;
+
+// Options for the MPI and hybrid engines
+typedef struct {
+    struct ISTCheckpoint* checkpoint;   // Per-rank checkpoints, NULL to disable
+    ConstructionTimes* times;           // Filled with per-phase times if not NULL
+    int chunk_size;                     // Vertices per dynamically claimed chunk, 0 for the static split
+    int* chunks_taken;                  // Set to the chunks this rank computed if not NULL
+    struct SharedISTs* shared;          // Node-shared trees to fill, NULL for private copies
+    ResultPlacement placement;          // Where the trees are gathered, PLACEMENT_ALL by default
+    uint64_t* digest;                   // Set to the digest of this rank's vertices if not NULL (ist_digest.h)
+} ParallelOptions;
+
+// Computes the parents of vertices [start, end) into ists with kernel
+// kernel is selected once per construction and passed to every range
+typedef void (*RangeKernel)(ParentKernel kernel, IndependentSpanningTrees* ists,
+                            int start, int end);
+
+// Chunks are claimed from a shared counter on rank 0 (MPI_Fetch_and_op), so
+// faster or less loaded ranks take more of them; the owner of every chunk is
+// recorded and the chunks are then exchanged so that all ranks hold all trees
+#define IST_DEFAULT_CHUNK 16384
+
 // Function prototypes for parallel implementation
+void init_parallel_options(ParallelOptions* options);
+int holds_all_trees(const ParallelOptions* options, int rank);
+int parse_result_placement(const char* name, ResultPlacement* placement);
+const char* result_placement_name(ResultPlacement placement);
+void vertex_range(int vertex_count, int rank, int size, int* start, int* end);
+void allgather_ists(IndependentSpanningTrees* ists, int vertex_count);
+void gather_ists_to_root(IndependentSpanningTrees* ists, int vertex_count);
+void exchange_ists(IndependentSpanningTrees* ists, int vertex_count, ResultPlacement placement);
+int compute_dynamic_chunks(BubbleSortNetwork* network, IndependentSpanningTrees* ists, int chunk_size,
+                           ResultPlacement placement, RangeKernel compute_range, ParentKernel kernel,
+                           double* compute_time, uint64_t* digest);
+void report_chunk_counts(int chunks, double compute_time);
 void construct_parallel_ists_mpi(BubbleSortNetwork* network, IndependentSpanningTrees* ists);
+void construct_parallel_ists_mpi_with_options(BubbleSortNetwork* network, IndependentSpanningTrees* ists,
+                                              const ParallelOptions* options);
 IndependentSpanningTrees* mpi_construct_ists(BubbleSortNetwork* network);
+IndependentSpanningTrees* mpi_construct_ists_with_options(BubbleSortNetwork* network,
+                                                          const ParallelOptions* options);
 
 // Function prototypes for hybrid implementation
 void construct_hybrid_ists(BubbleSortNetwork* network, IndependentSpanningTrees* ists);
+void construct_hybrid_ists_with_options(BubbleSortNetwork* network, IndependentSpanningTrees* ists,
+                                        const ParallelOptions* options);
 IndependentSpanningTrees* hybrid_construct_ists(BubbleSortNetwork* network);
+IndependentSpanningTrees* hybrid_construct_ists_with_options(BubbleSortNetwork* network,
+                                                             const ParallelOptions* options);
 
 // Memory management functions
 void free_spanning_tree(SpanningTree* tree);
@@ -0,0 +1,71 @@
+#ifndef IST_ARCHIVE_H
+#define IST_ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Block-compressed IST archive (version 1)
+//
+//   [ISTArchiveHeader][ISTArchiveBlock index][block data]
+//
+// Every parent is an adjacent swap of its vertex, so it is stored as the swap
+// position (1..n-1, 0 for the root) and rebuilt with adjacent_swap_index.
+// Each tree is cut into blocks of block_vertices vertices; a block is either
+// bit-packed or run-length encoded, whichever is smaller. The index gives the
+// location of every block, so a single lookup decodes a single block.
+
+#define IST_ARCHIVE_MAGIC "BSNISTZ\0"
+#define IST_ARCHIVE_VERSION 1
+#define IST_ARCHIVE_DEFAULT_BLOCK 4096
+
+// Block encodings
+#define IST_BLOCK_PACKED 0      // symbol_bits bits per vertex, LSB first
+#define IST_BLOCK_RLE 1         // (symbol byte, LEB128 run length) pairs
+
+typedef struct {
+    char magic[8];              // IST_ARCHIVE_MAGIC
+    uint32_t version;           // IST_ARCHIVE_VERSION
+    uint32_t byte_order;        // IST_FILE_BYTE_ORDER as written by the producer
+    uint32_t header_size;       // sizeof(ISTArchiveHeader)
+    uint32_t dimension;         // Dimension n of B_n
+    uint32_t tree_count;        // Number of trees (n-1)
+    uint32_t block_vertices;    // Vertices per block
+    uint32_t symbol_bits;       // Bits per packed swap position
+    uint32_t reserved;
+    uint64_t vertex_count;      // Number of vertices (n!)
+    uint64_t blocks_per_tree;   // Number of blocks in each tree
+    uint64_t index_offset;      // File offset of the block index
+    uint64_t data_offset;       // File offset of the block data
+    uint64_t data_size;         // Total size of the block data
+    uint64_t checksum;          // FNV-1a over the index and the block data
+} ISTArchiveHeader;
+
+// Index entry, blocks are ordered tree-major
+typedef struct {
+    uint64_t offset;            // Offset of the block relative to data_offset
+    uint32_t size;              // Encoded size in bytes
+    uint32_t encoding;          // IST_BLOCK_*
+} ISTArchiveBlock;
+
+// An open, memory-mapped archive
+typedef struct {
+    ISTArchiveHeader* header;   // Header inside the mapping
+    ISTArchiveBlock* index;     // Block index inside the mapping
+    const unsigned char* data;  // Block data inside the mapping
+    void* mapping;              // Start of the mapping
+    size_t mapping_size;        // Length of the mapping
+    int* cache;                 // Last decoded block (parent indices)
+    int64_t cache_block;        // Index entry held in cache, -1 if none
+} ISTArchive;
+
+// Function prototypes
+int write_ist_archive(const char* path, IndependentSpanningTrees* ists,
+                      int dimension, int block_vertices);
+ISTArchive* open_ist_archive(const char* path, int verify_checksum);
+int ist_archive_decode_block(ISTArchive* archive, int tree, int block, int* parents);
+int ist_archive_parent(ISTArchive* archive, int tree, int vertex);
+IndependentSpanningTrees* ist_archive_extract(ISTArchive* archive);
+void close_ist_archive(ISTArchive* archive);
+
+#endif // IST_ARCHIVE_H
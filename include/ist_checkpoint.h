@@ -0,0 +1,55 @@
+#ifndef IST_CHECKPOINT_H
+#define IST_CHECKPOINT_H
+
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Per-rank checkpoints of completed vertex ranges
+//
+// Each rank writes the parents of a completed range [start, end) to
+// <dir>/rank<R>_<start>_<end>.chk and then records the range in
+// <dir>/manifest_rank<R>.txt. A resumed run with the same dimension and
+// rank count reloads every recorded range and only computes the rest.
+
+#define IST_CHECKPOINT_MAGIC "BSNCHK\0\0"
+#define IST_CHECKPOINT_DEFAULT_INTERVAL 60.0
+#define IST_CHECKPOINT_DIR_MAX 1024
+#define IST_CHECKPOINT_PATH_MAX 4096
+
+// Vertices computed between two checks of the checkpoint interval
+#define IST_CHECKPOINT_SEGMENT 4096
+
+typedef struct {
+    int start;                  // First vertex of the range
+    int end;                    // One past the last vertex of the range
+} VertexRange;
+
+typedef struct ISTCheckpoint {
+    char dir[IST_CHECKPOINT_DIR_MAX];   // Checkpoint directory
+    int dimension;              // Dimension n of B_n
+    int rank;                   // Rank owning this checkpoint
+    int size;                   // Number of ranks in the run
+    double interval;            // Minimum seconds between checkpoints
+    double last_time;           // Time of the last checkpoint (or start)
+    VertexRange* ranges;        // Completed ranges, sorted by start
+    int range_count;            // Number of completed ranges
+    int range_capacity;         // Allocated entries in ranges
+    int checkpoints_written;    // Number of range files written
+    int checkpoints_failed;     // Number of range files that could not be written
+    double write_time;          // Seconds spent writing checkpoints
+    int vertices_restored;      // Vertices reloaded on resume
+} ISTCheckpoint;
+
+// Function prototypes
+ISTCheckpoint* open_checkpoint(const char* dir, int dimension, int rank, int size,
+                               double interval, int resume);
+int checkpoint_restore(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists);
+int checkpoint_next_gap(ISTCheckpoint* checkpoint, int from, int end, int* gap_end);
+int checkpoint_due(ISTCheckpoint* checkpoint);
+int checkpoint_save_range(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists,
+                          int start, int end);
+void compute_with_checkpoints(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists,
+                              int start, int end, RangeKernel compute_range, ParentKernel kernel);
+void close_checkpoint(ISTCheckpoint* checkpoint);
+
+#endif // IST_CHECKPOINT_H
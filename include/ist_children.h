@@ -0,0 +1,45 @@
+#ifndef IST_CHILDREN_H
+#define IST_CHILDREN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Child lists of a spanning tree for top-down traversal from the root
+//
+// The parent array is inverted into CSR form with a counting sort: children
+// are counted per parent, the counts are turned into offsets and every vertex
+// is placed in its parent's group, all in parallel (OpenMP). A vertex of B_n
+// has at most n-1 neighbors, so the groups are tiny and are sorted afterwards
+// to make the lists independent of the thread schedule.
+//
+// build_level_order then lists the vertices reachable from the root level by
+// level, each level expanded in parallel from the previous one. Vertices whose
+// parent chain never reaches the root are not listed.
+
+typedef struct {
+    int vertex_count;           // Number of vertices in the tree
+    int root;                   // Root vertex
+    int* offsets;               // Children of v are children[offsets[v] .. offsets[v+1]-1]
+    int* children;              // Children grouped by parent, ascending within a group
+    int* order;                 // Reachable vertices in level order, NULL until built
+    int* level_start;           // Level d is order[level_start[d] .. level_start[d+1]-1]
+    int level_count;            // Number of levels (height + 1)
+    int reachable;              // Number of vertices in order
+} ChildLists;
+
+// Called once per tree edge in level order; edges of one level may be
+// visited concurrently, so the visitor must only touch data of child
+typedef void (*ChildVisitor)(int parent, int child, int level, void* user_data);
+
+// Function prototypes
+ChildLists* build_child_lists(SpanningTree* tree, int root);
+int build_level_order(ChildLists* lists);
+void free_child_lists(ChildLists* lists);
+ChildLists** build_all_child_lists(IndependentSpanningTrees* ists, int root);
+void free_all_child_lists(ChildLists** lists, int tree_count);
+void traverse_level_order(const ChildLists* lists, ChildVisitor visit, void* user_data);
+void broadcast_values(const ChildLists* lists, uint64_t* values);
+int report_broadcast(FILE* out, IndependentSpanningTrees* ists);
+
+#endif // IST_CHILDREN_H
@@ -0,0 +1,74 @@
+#ifndef IST_CONGESTION_H
+#define IST_CONGESTION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Vertex and link load of the n-1 trees rooted at the identity
+//
+// A message from v to the root travels up v's root path, so in tree t every
+// vertex relays the paths of its strict descendants and the link from v to
+// its parent carries the paths of v's whole subtree. The pass builds the child
+// lists and level order of one tree at a time (ist_children.h), computes the
+// subtree sizes bottom-up one level at a time in parallel (OpenMP) and adds
+// them to per-vertex and per-link totals before moving to the next tree.
+// Within a tree every vertex and every link is touched by one vertex only, so
+// the totals need no atomics.
+//
+// Per vertex, relay counts the trees in which it has children and load the
+// root paths crossing it over all trees; per link (an adjacent swap, stored at
+// its smaller endpoint) load counts the root paths using it. The root ends
+// every path and is left out of the hot spots and distributions. Vertices
+// whose parent chain never reaches the root are counted and skipped.
+//
+// A link carries at most (n-1) n! paths, which fits in 32 bits up to n = 11;
+// the link totals then take half the memory of the trees.
+
+#define IST_CONGESTION_DEFAULT_TOP 10
+#define IST_CONGESTION_MAX_DIMENSION 11
+#define IST_CONGESTION_BUCKETS 33       // Loads 0 and [2^(b-1), 2^b) for b = 1..32
+
+// One hot vertex (second = -1) or link
+typedef struct {
+    uint64_t load;              // Root paths crossing the vertex or link
+    int first;                  // Vertex, or smaller endpoint of the link
+    int second;                 // Larger endpoint of the link, -1 for a vertex
+} HotSpot;
+
+typedef struct {
+    int dimension;              // Dimension n of B_n
+    int vertex_count;           // Number of vertices
+    int tree_count;             // Number of trees
+    int root;                   // Root of every tree
+    uint8_t* relay;             // Trees in which each vertex has children
+    uint64_t* load;             // Root paths crossing each vertex over all trees
+    uint32_t* link_load;        // Root paths over the link at position p of vertex v, at v * (n-1) + p - 1
+    long long unreachable;      // Vertices (over all trees) whose parent chain misses the root
+    double seconds;             // Time of compute_congestion
+} CongestionStats;
+
+// Distributions and hot spots derived from CongestionStats
+typedef struct {
+    int top;                                    // Entries in hot_vertices and hot_links
+    HotSpot* hot_vertices;                      // Most loaded vertices, most loaded first
+    HotSpot* hot_links;                         // Most loaded links, most loaded first
+    int* relay_histogram;                       // Vertices internal in k trees, k = 0..tree_count
+    long long vertex_buckets[IST_CONGESTION_BUCKETS];  // Vertices by load (log2 buckets)
+    long long link_buckets[IST_CONGESTION_BUCKETS];    // Links of B_n by load (log2 buckets)
+    uint64_t vertex_total;                      // Sum of the vertex loads
+    uint64_t link_total;                        // Sum of the link loads
+    long long link_count;                       // Links of B_n
+    long long links_used;                       // Links used by at least one tree
+} CongestionSummary;
+
+// Function prototypes
+int compute_congestion(IndependentSpanningTrees* ists, int dimension, int root, CongestionStats* stats);
+void free_congestion(CongestionStats* stats);
+int summarize_congestion(const CongestionStats* stats, int top, CongestionSummary* summary);
+void free_congestion_summary(CongestionSummary* summary);
+void print_congestion(FILE* out, const CongestionStats* stats, const CongestionSummary* summary);
+int write_congestion_json(const char* path, const CongestionStats* stats, const CongestionSummary* summary);
+int report_congestion(FILE* out, IndependentSpanningTrees* ists, int dimension, int top, const char* json_path);
+
+#endif // IST_CONGESTION_H
@@ -0,0 +1,52 @@
+#ifndef IST_CONTEXT_H
+#define IST_CONTEXT_H
+
+#include <stddef.h>
+#include "ist_algorithm.h"
+#include "ist_kernels.h"
+
+// Reusable state for building and querying ISTs from a long-running program
+//
+// libist (make lib) packages the sequential engine, the kernels, file I/O and
+// the tree analyses as libist.a and libist.so; programs link it with -fopenmp.
+// An ISTContext keeps everything that a single call would otherwise set up
+// and tear down:
+//   - the parent arrays of all n-1 trees in one arena, reused by later
+//     constructions and only reallocated when a larger dimension needs more
+//   - the kernel selected for the current dimension
+//   - the bubble-sort network, built on first request and kept while the
+//     dimension does not change
+//   - scratch space for path queries
+// Construction runs on the OpenMP threads of the calling thread, whose pool
+// the runtime keeps alive between calls. The trees returned by
+// ist_context_construct belong to the context and stay valid until the next
+// construction or free_ist_context. A context must not be used by two threads
+// at once.
+
+#define IST_CONTEXT_MAX_DIMENSION 12    // Largest n whose vertex indices fit in an int
+#define IST_CONTEXT_BLOCK 4096          // Vertices per OpenMP work item
+
+typedef struct {
+    int threads;                        // OpenMP threads per construction, 0 for the runtime default
+    int dimension;                      // Dimension of the trees, 0 before the first construction
+    IndependentSpanningTrees ists;      // Trees of the last construction, parents in arena
+    SpanningTree trees[IST_CONTEXT_MAX_DIMENSION - 1];
+    int* arena;                         // Parent arrays of all trees, tree t at t * vertex_count
+    size_t arena_capacity;              // Ints allocated in arena
+    ParentKernel kernel;                // Kernel for dimension
+    BubbleSortNetwork* network;         // Network of dimension, NULL until requested
+    int* path;                          // Scratch for ist_context_path
+    int path_capacity;                  // Ints allocated in path
+    int constructions;                  // Completed constructions
+    int arena_allocations;              // Times the arena was (re)allocated
+} ISTContext;
+
+// Function prototypes
+ISTContext* create_ist_context(int threads);
+void free_ist_context(ISTContext* context);
+IndependentSpanningTrees* ist_context_construct(ISTContext* context, int dimension);
+BubbleSortNetwork* ist_context_network(ISTContext* context);
+int ist_context_parent(ISTContext* context, int tree, int vertex);
+int ist_context_path(ISTContext* context, int tree, int vertex, const int** path);
+
+#endif // IST_CONTEXT_H
@@ -0,0 +1,39 @@
+#ifndef IST_DEPTH_H
+#define IST_DEPTH_H
+
+#include <stdio.h>
+#include "ist_algorithm.h"
+
+// Depth of every vertex in a spanning tree and the distribution of the
+// root-path lengths, which bound the latency of a broadcast along the tree
+//
+// Depths are memoized in O(V) per tree: the walk up from a vertex stops at the
+// first vertex of known depth, so every vertex is walked once. Vertices are
+// taken in index order, where parents are mostly close by, which keeps the
+// walks cache friendly. The trees are done in parallel (OpenMP). A vertex
+// whose parent chain never reaches the root (a cycle, or an invalid parent)
+// gets IST_DEPTH_UNREACHABLE.
+
+#define IST_DEPTH_UNREACHABLE -1
+
+typedef struct {
+    int* depth;                 // Hops from each vertex to the root
+    int* histogram;             // Vertices at each depth 0..height
+    int vertex_count;           // Number of vertices in the tree
+    int root;                   // Root vertex
+    int reachable;              // Vertices whose parent chain reaches the root
+    int height;                 // Largest depth
+    double mean_depth;          // Mean depth over the reachable vertices
+} TreeDepths;
+
+// Function prototypes
+int compute_tree_depths(SpanningTree* tree, int root, TreeDepths* depths);
+void free_tree_depths(TreeDepths* depths);
+TreeDepths* compute_ists_depths(IndependentSpanningTrees* ists, int root);
+void free_ists_depths(TreeDepths* depths, int tree_count);
+void print_depth_stats(FILE* out, const TreeDepths* depths, int tree_count);
+void write_depths_json(FILE* out, const TreeDepths* depths, int tree_count);
+int write_depth_json(const char* path, const TreeDepths* depths, int tree_count, int dimension);
+int report_tree_depths(FILE* out, IndependentSpanningTrees* ists, int dimension, const char* json_path);
+
+#endif // IST_DEPTH_H
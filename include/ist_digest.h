@@ -0,0 +1,39 @@
+#ifndef IST_DIGEST_H
+#define IST_DIGEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+#include "ist_stream.h"
+
+// Order-independent digest of the parent arrays
+//
+// The digest is the sum modulo 2^64 of a 64-bit mix of every (tree, vertex,
+// parent) entry, the root entries (-1) included. Addition is commutative, so
+// partial digests of any split of the entries (threads, blocks, MPI ranks,
+// dynamic chunks, streamed blocks) add up to the same value, and two engines
+// that build the same trees print the same digest whatever their layout. The
+// MPI engines digest each rank's vertices right after computing them and sum
+// the partial digests with MPI_Reduce. Comparing digests (--expect-digest)
+// replaces diffing the trees; it is a regression check, not a cryptographic hash.
+
+#define IST_DIGEST_BLOCK 65536      // Vertices per OpenMP work item
+
+// Forwards blocks to sink after adding them to digest
+typedef struct {
+    ISTBlockSink sink;          // Sink the blocks are passed on to
+    void* user_data;            // User data of sink
+    uint64_t digest;            // Digest of the blocks so far
+} DigestSink;
+
+// Function prototypes
+uint64_t digest_tree_range(const int* parent, int tree, int start, int end);
+uint64_t digest_ists_range(IndependentSpanningTrees* ists, int start, int end);
+uint64_t digest_ists(IndependentSpanningTrees* ists);
+uint64_t digest_block(const ISTBlock* block);
+int digest_block_sink(const ISTBlock* block, void* user_data);
+int parse_digest(const char* text, uint64_t* digest);
+int report_digest(FILE* out, uint64_t digest, const uint64_t* expected);
+uint64_t reduce_digest(uint64_t local);    // MPI engines only (mpi_reports.c)
+
+#endif // IST_DIGEST_H
@@ -0,0 +1,68 @@
+#ifndef IST_FAULT_H
+#define IST_FAULT_H
+
+#include "ist_algorithm.h"
+
+// Fault-injection simulator for routing along the independent spanning trees
+//
+// A message from vertex v reaches the root along tree T unless a faulty vertex
+// lies on the path from v to the root, i.e. unless a fault is an ancestor of v
+// (or v itself). Every tree is numbered in preorder once, so that the
+// descendants of f are the positions [preorder[f], preorder[f] + subtree[f]).
+// A fault set then removes at most k intervals per tree, and the surviving
+// paths of all vertices are counted in O(V) per tree. The numbering is built
+// from the tree depths without child lists. Vertices whose parent chain never
+// reaches the root get no position and never deliver.
+//
+// The stretch of a delivered vertex is the length of its shortest surviving
+// tree path divided by its distance to the root in B_n (its inversion count).
+
+#define IST_FAULT_MAX_FAULTS 16
+#define IST_FAULT_MAX_TREES 16
+
+typedef struct {
+    int fault_count;
+    int faults[IST_FAULT_MAX_FAULTS];   // Faulty vertices (never the root)
+} FaultSet;
+
+typedef struct {
+    int dimension;              // Dimension n of B_n
+    int tree_count;             // Number of trees (n-1)
+    int vertex_count;           // Number of vertices (n!)
+    int root;                   // Common root of the trees (the identity)
+    int* distance;              // Distance of each vertex to the root in B_n
+    int** preorder;             // Preorder position of each vertex, -1 if unreachable
+    int** subtree;              // Subtree size of each vertex
+    int** order;                // Vertex at each preorder position
+    int** depth;                // Depth of each vertex
+    int* reachable;             // Number of positions in each tree
+} FaultModel;
+
+// Outcome of one fault set
+typedef struct {
+    int sources;                // Non-faulty vertices other than the root
+    int delivered;              // Sources with at least one surviving path
+    int min_paths;              // Fewest surviving paths over the sources
+    int paths[IST_FAULT_MAX_TREES + 1];  // Sources by number of surviving paths
+    double mean_stretch;        // Mean stretch over the delivered sources
+    double max_stretch;         // Largest stretch over the delivered sources
+} FaultResult;
+
+// Per-thread working memory of evaluate_fault_set
+typedef struct {
+    unsigned char* paths;       // Surviving paths of each vertex
+    int* best;                  // Shortest surviving path of each vertex
+} FaultScratch;
+
+// Function prototypes
+FaultModel* create_fault_model(IndependentSpanningTrees* ists, int dimension);
+void free_fault_model(FaultModel* model);
+FaultScratch* create_fault_scratch(FaultModel* model);
+void free_fault_scratch(FaultScratch* scratch);
+int is_tree_ancestor(FaultModel* model, int tree, int ancestor, int vertex);
+void evaluate_fault_set(FaultModel* model, const FaultSet* set, FaultScratch* scratch, FaultResult* result);
+int simulate_fault_sets(FaultModel* model, const FaultSet* sets, int set_count, FaultResult* results);
+void adversarial_fault_set(FaultModel* model, int fault_count, FaultSet* set);
+int read_fault_sets(const char* path, int vertex_count, int root, FaultSet** sets, int* set_count);
+
+#endif // IST_FAULT_H
@@ -0,0 +1,78 @@
+#ifndef IST_IO_H
+#define IST_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+#include "ist_stream.h"
+
+// Binary IST file format (version 1)
+//
+//   [ISTFileHeader, padded to IST_FILE_ALIGNMENT]
+//   [tree section T_1][padding] ... [tree section T_{n-1}][padding]
+//
+// Every tree section starts on an IST_FILE_ALIGNMENT boundary and holds the
+// parent array of one tree, so a mapped file can be used in place as an
+// IndependentSpanningTrees. All fields are stored in host byte order;
+// byte_order lets a reader detect a file written on a foreign host.
+
+#define IST_FILE_MAGIC "BSNIST\0\0"
+#define IST_FILE_VERSION 1
+#define IST_FILE_BYTE_ORDER 0x01020304u
+#define IST_FILE_ALIGNMENT 4096
+
+// Parent encodings
+#define IST_ENCODING_INT32 0    // One int32 parent index per vertex, -1 for the root
+
+// Section layouts
+#define IST_LAYOUT_TREE_MAJOR 0 // One contiguous section per tree
+
+typedef struct {
+    char magic[8];              // IST_FILE_MAGIC
+    uint32_t version;           // IST_FILE_VERSION
+    uint32_t byte_order;        // IST_FILE_BYTE_ORDER as written by the producer
+    uint32_t header_size;       // sizeof(ISTFileHeader)
+    uint32_t dimension;         // Dimension n of B_n
+    uint32_t tree_count;        // Number of trees (n-1)
+    uint32_t encoding;          // IST_ENCODING_*
+    uint32_t layout;            // IST_LAYOUT_*
+    uint32_t alignment;         // Section alignment in bytes
+    uint64_t vertex_count;      // Number of vertices (n!)
+    uint64_t section_offset;    // File offset of the first tree section
+    uint64_t section_stride;    // Distance between consecutive tree sections
+    uint64_t checksum;          // FNV-1a over the per-tree section hashes
+} ISTFileHeader;
+
+// A view of a mapped IST file
+// ists.trees[t].parent points into a private mapping, so the trees can be
+// used like constructed ones: pages are shared with the page cache until
+// written, and a write copies the page for this process only (the file is
+// never modified). Release with unmap_ists_file
+typedef struct {
+    IndependentSpanningTrees ists;  // Zero-copy view of the trees
+    ISTFileHeader* header;          // Header inside the mapping
+    void* mapping;                  // Start of the mapping
+    size_t mapping_size;            // Length of the mapping
+} MappedISTs;
+
+// Incremental writer, used for both in-memory and streamed trees
+typedef struct {
+    int fd;                     // Output file
+    ISTFileHeader header;       // Header written on close
+    uint64_t* tree_hashes;      // Running FNV-1a hash per tree section
+    int64_t* next_vertex;       // Next expected vertex per tree (enforces order)
+    int* scratch;               // Transpose buffer for vertex-major blocks
+    int scratch_count;          // Capacity of scratch in vertices
+} ISTFileWriter;
+
+// Function prototypes
+ISTFileWriter* open_ists_file_writer(const char* path, int dimension);
+int write_ists_tree_range(ISTFileWriter* writer, int tree, int first_vertex,
+                          int vertex_count, const int* parents);
+int close_ists_file_writer(ISTFileWriter* writer);
+int ists_file_block_sink(const ISTBlock* block, void* user_data);
+int write_ists_file(const char* path, IndependentSpanningTrees* ists, int dimension);
+MappedISTs* map_ists_file(const char* path, int verify_checksum);
+void unmap_ists_file(MappedISTs* mapped);
+
+#endif // IST_IO_H
@@ -0,0 +1,45 @@
+#ifndef IST_KERNELS_H
+#define IST_KERNELS_H
+
+#include "ist_algorithm.h"
+
+// Dimension-specialized parent kernels
+//
+// A kernel fills the parents of vertices [start, end) in all n-1 trees and
+// computes exactly what Parent1 followed by permutation_to_index computes.
+// For IST_KERNEL_MIN_DIMENSION..IST_KERNEL_MAX_DIMENSION there is a variant
+// compiled for that n: the permutation lives in a fixed-size array, every loop
+// over positions is fully unrolled, factorial weights are constants and the
+// parent index is derived from the two Lehmer digits the swap changes. Other
+// dimensions use the generic kernel built on Parent1.
+//
+// The batch kernels (src/sequential/ist_batch.c) compute the same parents for
+// a group of vertices at once, one vertex per SIMD lane, with the cases of
+// Parent1 evaluated as selects. select_parent_kernel uses them when the CPU
+// has AVX2 or AVX-512; select_scalar_parent_kernel always returns the scalar
+// kernel.
+
+#define IST_KERNEL_MIN_DIMENSION 4
+#define IST_KERNEL_MAX_DIMENSION 12     // Largest n whose vertex indices fit in an int
+
+// KernelTimes and ParentKernel are declared in ist_algorithm.h
+
+// Instruction sets of the batch kernels
+typedef enum {
+    BATCH_ISA_SCALAR,   // Baseline target, 8 lanes
+    BATCH_ISA_AVX2,     // 8 lanes
+    BATCH_ISA_AVX512,   // 16 lanes
+    BATCH_ISA_COUNT
+} BatchISA;
+
+// Function prototypes
+ParentKernel select_parent_kernel(int dimension);
+ParentKernel select_scalar_parent_kernel(int dimension);
+ParentKernel select_batch_parent_kernel(int dimension, BatchISA isa);
+BatchISA batch_kernel_isa(void);
+const char* batch_isa_name(BatchISA isa);
+int parent_kernel_is_specialized(int dimension);
+void generic_parent_kernel(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times);
+void runtime_parent_kernel(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times);
+
+#endif // IST_KERNELS_H
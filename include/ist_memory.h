@@ -0,0 +1,84 @@
+#ifndef IST_MEMORY_H
+#define IST_MEMORY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Memory planning before a construction
+//
+// The network (n-1 neighbors per vertex plus offsets), the n-1 parent arrays
+// and the verification and analysis buffers all grow with n!, so a run that
+// does not fit is better refused up front than killed halfway. The planner
+// estimates the bytes each storage mode adds to the current RSS, compares the
+// total over the ranks of a node with the memory available there (the
+// smaller of MemAvailable and the cgroup limit, or --memory-limit) and
+// picks the first mode that fits:
+//   full   - network and trees in memory, trees verified
+//   trees  - trees only: no network and no verification (half the memory)
+//   stream - blocks streamed into the output file (sequential engine with
+//            --output and no in-memory analyses)
+// The estimates cover the allocations of this code base; the allocator and
+// the MPI runtime add some slack on top. The peak RSS reported after the run
+// comes from getrusage.
+//
+// With --shared only the node leader allocates the trees and network, so the
+// other ranks of the node add only their analysis and verification buffers.
+//
+// With --placement root or distributed, a rank that keeps only its own
+// vertices touches 1/ranks of the parent arrays and needs no network.
+//
+// reduce_memory_plan (mpi_reports.c) sums the estimates over the
+// ranks of each node and makes all ranks agree on one mode; reduce_peak_rss
+// reports the largest peak of any rank.
+
+typedef enum {
+    STORAGE_AUTO = -1,  // First mode that fits
+    STORAGE_FULL,       // Network and trees, verified
+    STORAGE_TREES,      // Trees only, not verified
+    STORAGE_STREAM,     // Streamed to the output file
+    STORAGE_COUNT
+} StorageMode;
+
+// What a run needs in memory
+typedef struct {
+    int dimension;      // Dimension n of B_n
+    int threads;        // OpenMP threads of the analyses, 0 for the runtime default
+    int verify;         // This process verifies the trees in full mode
+    int depth;          // Tree depths are reported
+    int broadcast;      // Child lists and a broadcast are built
+    int reroot;         // The trees are rerooted
+    int congestion;     // Vertex and link loads are reported
+    int stream_block;   // Vertices per streamed block, 0 if streaming is not possible
+    int shared_copy;    // Trees and network are mapped from another rank's node-shared window
+    int tree_ranks;     // Ranks the trees are split over if this process keeps only its share
+                        // (and then builds no network edges), else 1
+} MemoryNeeds;
+
+typedef struct {
+    uint64_t baseline;                  // RSS of this process when planning
+    uint64_t local[STORAGE_COUNT];      // Bytes each mode adds in this process
+    uint64_t bytes[STORAGE_COUNT];      // Bytes each mode adds in the planned scope (process or node)
+    int possible[STORAGE_COUNT];        // Whether the mode can run at all
+    uint64_t available;                 // Bytes available in the scope
+    int ranks;                          // Processes in the scope
+    StorageMode mode;                   // Chosen mode
+    int fits;                           // Chosen mode fits in available
+} MemoryPlan;
+
+// Function prototypes
+void init_memory_needs(MemoryNeeds* needs, int dimension);
+void estimate_memory(const MemoryNeeds* needs, MemoryPlan* plan);
+uint64_t available_memory(void);
+uint64_t current_rss(void);
+uint64_t peak_rss(void);
+int choose_storage_mode(MemoryPlan* plan, StorageMode requested);
+void plan_memory(const MemoryNeeds* needs, StorageMode requested, uint64_t limit, MemoryPlan* plan);
+void reduce_memory_plan(MemoryPlan* plan, StorageMode requested, uint64_t limit);
+void reduce_peak_rss(const MemoryPlan* plan);
+int accept_memory_plan(FILE* out, const MemoryPlan* plan, StorageMode requested, int dimension);
+void print_memory_plan(FILE* out, const MemoryPlan* plan);
+void report_peak_rss(FILE* out, const MemoryPlan* plan, uint64_t peak);
+int parse_storage_mode(const char* name, StorageMode* mode);
+const char* storage_mode_name(StorageMode mode);
+
+#endif // IST_MEMORY_H
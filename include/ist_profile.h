@@ -0,0 +1,40 @@
+#ifndef IST_PROFILE_H
+#define IST_PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Hot-path counters for Parent1 (build with make PROFILE=1)
+//
+// With IST_PROFILE_CASES defined, every thread counts the cases of Parent1
+// and the calls to is_swap_identity and right_position in its own counter
+// block. ist_profile_collect sums the blocks of all threads of a process and
+// reduce_profile_counts sums the totals over MPI ranks. Without the flag,
+// IST_PROFILE_COUNT expands to nothing and the totals stay zero.
+
+// Counter slots: one per ParentCase, then the helper calls
+#define IST_PROFILE_IS_SWAP_IDENTITY PARENT_CASE_COUNT
+#define IST_PROFILE_RIGHT_POSITION (PARENT_CASE_COUNT + 1)
+#define IST_PROFILE_COUNTERS (PARENT_CASE_COUNT + 2)
+
+#ifdef IST_PROFILE_CASES
+uint64_t* ist_profile_thread_counters(void);
+#define IST_PROFILE_COUNT(slot) (ist_profile_thread_counters()[slot]++)
+#else
+#define IST_PROFILE_COUNT(slot) ((void)0)
+#endif
+
+// Function prototypes
+int ist_profile_enabled(void);
+int ist_profile_collect(uint64_t* totals);
+void ist_profile_reset(void);
+const char* ist_profile_counter_name(int slot);
+void ist_profile_print(FILE* out, const uint64_t* totals);
+int ist_profile_write_json(const char* path, const uint64_t* totals, int dimension,
+                           int ranks, int threads);
+
+// Defined with the MPI engine
+void reduce_profile_counts(uint64_t* totals, int* threads);
+
+#endif // IST_PROFILE_H
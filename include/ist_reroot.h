@@ -0,0 +1,34 @@
+#ifndef IST_REROOT_H
+#define IST_REROOT_H
+
+#include <stdio.h>
+#include "ist_algorithm.h"
+
+// Independent spanning trees rooted at any vertex of B_n
+//
+// B_n is a Cayley graph: two vertices are adjacent when they differ by a swap
+// of two adjacent positions. Renaming the symbols of every vertex by the same
+// permutation g (v -> g*v, i.e. symbol s becomes g(s)) does not move
+// positions, so it commutes with the swaps and is an automorphism of B_n. It
+// maps the trees rooted at the identity to trees rooted at g, and these are
+// still independent. For the root r:
+//
+//     parent_r(v, t) = r * parent(r^-1 * v, t)
+//
+// so parent_r(v, t) is v with the same two positions swapped as between
+// w = r^-1 * v and its parent in the identity-rooted tree. Only w is ranked;
+// the parent of v follows from v's index and the swap position, so nothing is
+// constructed afresh.
+
+// Largest dimension whose vertex indices fit in an int
+#define IST_REROOT_MAX_DIMENSION 12
+
+// Function prototypes
+Permutation* relabel_permutation(Permutation* root, Permutation* v);
+Permutation* Parent1_rooted(Permutation* v, Permutation* root, int t, int n);
+int rooted_parent(IndependentSpanningTrees* ists, int dimension, int root, int vertex, int t);
+int materialize_rooted_tree(IndependentSpanningTrees* ists, int dimension, int root, int t, int* parent);
+IndependentSpanningTrees* reroot_ists(IndependentSpanningTrees* ists, int dimension, int root);
+int report_reroot(FILE* out, IndependentSpanningTrees* ists, int dimension, int root);
+
+#endif // IST_REROOT_H
@@ -0,0 +1,76 @@
+#ifndef IST_SAMPLE_H
+#define IST_SAMPLE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Sampling verification for dimensions where full verification is out of reach
+//
+// Full verification walks every vertex of every tree and compares the paths of
+// every pair of trees, which is quadratic in n! and infeasible from n = 12 on.
+// The sampler checks K random vertices plus a fixed set of edge cases, and for
+// each vertex v and each tree t it walks the path from v to the root, checking:
+//   - every parent is a vertex of B_n and adjacent to its child
+//   - every parent is the one Parent1 gives (when the trees are in memory)
+//   - the walk reaches the root within IST_SAMPLE_MAX_PATH(n) steps
+// It then checks that the n-1 paths from v share no vertex but v and the root.
+// Without trees in memory (streamed or distributed runs) the parents are
+// computed on the fly. A step unranks one vertex in O(n^2) and a path has
+// O(n^2) steps, so a sampled vertex costs O(n^5) over its n-1 paths: the
+// sampler is polynomial in n and independent of n!.
+//
+// If all K random vertices pass, the fraction f of failing vertices satisfies
+// (1 - f)^K >= 1 - c only for f <= 1 - (1 - c)^(1/K), which is reported as the
+// bound at confidence c (about 3/K for c = 95%).
+//
+// The edge cases are the n-1 neighbors of the root, the reversal n...1
+// (farthest from the root), and for every symbol s the vertex ending in s
+// with the other symbols in order, plus any vertices given with
+// --sample-vertex.
+
+#define IST_SAMPLE_DEFAULT 1000                 // Random vertices checked by default
+#define IST_SAMPLE_CONFIDENCE 0.95              // Confidence of the reported bound
+#define IST_SAMPLE_MAX_VERTICES 64              // Vertices that can be given with --sample-vertex
+#define IST_SAMPLE_MAX_PATH(n) ((n) * (n))      // Twice the diameter n(n-1)/2, plus n
+
+typedef enum {
+    VERIFY_AUTO = -1,   // Full when the network edges are in memory, sampling otherwise
+    VERIFY_FULL,        // Every vertex of every tree (report_verification)
+    VERIFY_SAMPLE,      // Random vertices and edge cases
+    VERIFY_NONE,        // No verification
+    VERIFY_COUNT
+} VerifyMode;
+
+typedef struct {
+    int samples;                                // Random vertices to check
+    uint64_t seed;                              // Seed of the sampler
+    int edge_cases;                             // Check the built-in edge cases
+    int vertices[IST_SAMPLE_MAX_VERTICES];      // Extra vertices to check
+    int vertex_count;                           // Entries in vertices
+} SampleOptions;
+
+typedef struct {
+    int random_checked;         // Random vertices checked
+    int random_failed;          // Random vertices that failed
+    int fixed_checked;          // Edge cases and given vertices checked
+    int fixed_failed;           // Edge cases and given vertices that failed
+    int first_failure;          // First vertex that failed, -1 if none
+    double failure_bound;       // Bound on the failing fraction at IST_SAMPLE_CONFIDENCE, if none failed
+    double seconds;             // Time spent checking
+} SampleReport;
+
+// Function prototypes
+void init_sample_options(SampleOptions* options);
+int add_sample_vertex(SampleOptions* options, int vertex);
+int check_sampled_vertex(IndependentSpanningTrees* ists, int dimension, int vertex, FILE* out);
+int sample_verify(IndependentSpanningTrees* ists, int dimension, const SampleOptions* options,
+                  SampleReport* report, FILE* out);
+int report_sample_verification(FILE* out, IndependentSpanningTrees* ists, int dimension,
+                               const SampleOptions* options);
+int verify_ists(FILE* out, VerifyMode mode, IndependentSpanningTrees* ists, BubbleSortNetwork* network,
+                int dimension, const SampleOptions* options);
+int parse_verify_mode(const char* name, VerifyMode* mode);
+const char* verify_mode_name(VerifyMode mode);
+
+#endif // IST_SAMPLE_H
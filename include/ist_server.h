@@ -0,0 +1,108 @@
+#ifndef IST_SERVER_H
+#define IST_SERVER_H
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ist_algorithm.h"
+
+// Local query service for the trees (ist_server and the ist_query load generator)
+//
+// The server holds one source of parents for a dimension and answers batched
+// lookups from other processes on the host over a Unix domain socket, so they
+// neither link the engines nor rebuild the trees:
+//   - mapped:   an IST file mapped in place (--input), shared with the page
+//               cache of every other reader of the file
+//   - built:    trees constructed once at startup (--construct, ISTContext)
+//   - computed: no trees at all; every parent is computed on demand with
+//               Parent1 in O(n^2), which works for any n the ranks fit in
+// Each connection is served by its own thread; the source is read-only.
+//
+// Protocol, all fields in host byte order (the socket never leaves the host).
+// A request is an ISTQueryHeader followed by count int32 vertices; the reply is
+// an ISTReplyHeader followed by words int32 values:
+//   IST_OP_INFO         count 0; words: dimension, vertices, trees, source
+//   IST_OP_PARENT       parent of each vertex in tree (0-based), -1 for the root
+//   IST_OP_ALL_PARENTS  parents of each vertex in all trees, vertex-major
+//   IST_OP_PATH         per vertex in tree: the length L, then the L vertices
+//                       from the vertex to the root; L = -1 if the parents do
+//                       not reach the root within IST_QUERY_MAX_PATH(n) steps
+// A reply with a status other than IST_STATUS_OK has no words. After a bad
+// header or an oversized batch the server closes the connection, since the
+// rest of the stream can no longer be framed.
+
+#define IST_QUERY_MAGIC 0x51545349u                 // "ISTQ" on little-endian hosts
+#define IST_QUERY_MAX_BATCH 4096                    // Vertices per request
+#define IST_QUERY_MAX_PATH(n) ((n) * (n))           // Steps of a path query, as for sampling
+#define IST_QUERY_MAX_WORDS(n) ((size_t)IST_QUERY_MAX_BATCH * (IST_QUERY_MAX_PATH(n) + 2))
+
+typedef enum {
+    IST_OP_INFO,
+    IST_OP_PARENT,
+    IST_OP_ALL_PARENTS,
+    IST_OP_PATH,
+    IST_OP_COUNT
+} ISTQueryOp;
+
+typedef enum {
+    IST_STATUS_OK,
+    IST_STATUS_BAD_REQUEST,     // Unknown magic or operation
+    IST_STATUS_BAD_TREE,        // Tree out of range
+    IST_STATUS_BAD_VERTEX,      // Vertex out of range
+    IST_STATUS_TOO_LARGE,       // More than IST_QUERY_MAX_BATCH vertices
+    IST_STATUS_COUNT
+} ISTQueryStatus;
+
+typedef enum {
+    IST_SOURCE_MAPPED,
+    IST_SOURCE_BUILT,
+    IST_SOURCE_COMPUTED,
+    IST_SOURCE_COUNT
+} ISTSourceKind;
+
+typedef struct {
+    uint32_t magic;             // IST_QUERY_MAGIC
+    uint16_t op;                // ISTQueryOp
+    uint16_t tree;              // Tree (0-based) for parent and path queries
+    uint32_t count;             // Vertices following the header
+} ISTQueryHeader;
+
+typedef struct {
+    uint32_t magic;             // IST_QUERY_MAGIC
+    uint16_t status;            // ISTQueryStatus
+    uint16_t dimension;         // Dimension of the served trees
+    uint32_t words;             // int32 values following the header
+} ISTReplyHeader;
+
+// Where the server takes its parents from
+typedef struct {
+    ISTSourceKind kind;
+    int dimension;                      // Dimension n of B_n
+    int vertex_count;                   // n!
+    int tree_count;                     // n-1
+    IndependentSpanningTrees* ists;     // Trees in memory, NULL when computed
+} ISTQuerySource;
+
+// Totals of a server run, updated by all connection threads
+typedef struct {
+    uint64_t connections;       // Connections accepted
+    uint64_t requests;          // Requests answered
+    uint64_t lookups;           // Vertices looked up
+    uint64_t errors;            // Replies with an error status
+} ISTServerStats;
+
+// Function prototypes
+int ist_source_parent(const ISTQuerySource* source, int tree, int vertex);
+ISTQueryStatus answer_ist_query(const ISTQuerySource* source, const ISTQueryHeader* request,
+                                const int32_t* vertices, int32_t* words, uint32_t* word_count);
+int open_ist_server(const char* path);
+int run_ist_server(int listen_fd, const ISTQuerySource* source, const volatile sig_atomic_t* stop, ISTServerStats* stats);
+int connect_ist_server(const char* path);
+int call_ist_server(int fd, ISTQueryOp op, int tree, const int32_t* vertices, uint32_t count,
+                    ISTReplyHeader* reply, int32_t* words, size_t capacity);
+const char* ist_query_op_name(ISTQueryOp op);
+int parse_ist_query_op(const char* name, ISTQueryOp* op);
+const char* ist_query_status_name(ISTQueryStatus status);
+const char* ist_source_kind_name(ISTSourceKind kind);
+
+#endif // IST_SERVER_H
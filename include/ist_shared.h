@@ -0,0 +1,52 @@
+#ifndef IST_SHARED_H
+#define IST_SHARED_H
+
+#include <stddef.h>
+#include <mpi.h>
+#include "ist_algorithm.h"
+
+// Trees and network in node-level shared memory (--shared)
+//
+// Without it every rank holds its own copy of all n-1 parent arrays (and, in
+// full mode, of the network), so a node with k ranks needs k copies. Here the
+// ranks of a node (MPI_Comm_split_type with MPI_COMM_TYPE_SHARED) map one
+// copy allocated by the node leader with MPI_Win_allocate_shared:
+//   - the vertices are split node by node, so each node owns one contiguous
+//     range, and within a node rank by rank
+//   - every rank writes the parents of its range in place
+//   - the node leaders then exchange the node ranges with one
+//     MPI_Allgatherv per tree (MPI_Gatherv to the node of rank 0 with
+//     --placement root); the other ranks see the result through the window
+//     and send nothing across nodes
+//   - the network is filled the same way, each rank of a node building a
+//     slice of the vertices
+// The windows stay in a passive epoch (lock_all) for their lifetime, and
+// sync_shared_ists makes the stores of every rank of the node visible.
+// Shared pages count towards the RSS of every rank that touches them.
+
+typedef struct SharedISTs {
+    IndependentSpanningTrees ists;  // Trees whose parents point into the tree window
+    BubbleSortNetwork network;      // Network in the network window, or only its shape
+    MPI_Comm node;                  // Ranks on this node
+    MPI_Comm leaders;               // Leaders (node rank 0) of all nodes, MPI_COMM_NULL elsewhere
+    int node_rank;                  // Rank within node
+    int node_size;                  // Ranks on this node
+    int node_index;                 // Index of this node among the leaders
+    int node_count;                 // Number of nodes
+    int first_rank;                 // Ranks on the nodes before this one
+    int node_start;                 // First vertex of this node's range
+    int node_end;                   // One past the last vertex of this node's range
+    MPI_Win tree_window;            // Parents of all trees, tree t at t * vertex_count
+    MPI_Win network_window;         // Adjacency then offsets, MPI_WIN_NULL without edges
+    size_t bytes;                   // Bytes of both windows, allocated once per node
+} SharedISTs;
+
+// Function prototypes
+SharedISTs* create_shared_ists(int dimension, int with_network);
+void free_shared_ists(SharedISTs* shared);
+void shared_vertex_range(const SharedISTs* shared, int* start, int* end);
+void sync_shared_ists(SharedISTs* shared);
+void exchange_shared_ists(SharedISTs* shared, ResultPlacement placement);
+int shared_node_rank(void);
+
+#endif // IST_SHARED_H
@@ -0,0 +1,33 @@
+#ifndef IST_STREAM_H
+#define IST_STREAM_H
+
+#include <stdio.h>
+#include "bubble_sort_network.h"
+
+// Default number of vertices per streamed block
+#define IST_STREAM_DEFAULT_BLOCK 65536
+
+// Largest dimension whose vertex indices fit in an int
+#define IST_STREAM_MAX_DIMENSION 12
+
+// A block of parent records for vertices [first_vertex, first_vertex + vertex_count)
+// Records are vertex-major: parents[i * tree_count + t] is the parent of vertex
+// first_vertex + i in tree T_{t+1}, or -1 for the root
+typedef struct {
+    int dimension;      // Dimension n of B_n
+    int tree_count;     // Number of trees (n-1)
+    int first_vertex;   // Index of the first vertex in the block
+    int vertex_count;   // Number of vertices in the block
+    int* parents;       // vertex_count * tree_count parent indices
+} ISTBlock;
+
+// Sink callback, called once per block in vertex order from the writer thread
+// Returns 1 on success, 0 to abort the stream
+typedef int (*ISTBlockSink)(const ISTBlock* block, void* user_data);
+
+// Function prototypes
+int construct_streaming_ists(int dimension, int block_vertices,
+                             ISTBlockSink sink, void* user_data);
+int file_block_sink(const ISTBlock* block, void* user_data);
+
+#endif // IST_STREAM_H
@@ -0,0 +1,63 @@
+#ifndef IST_TIMELINE_H
+#define IST_TIMELINE_H
+
+#include <stdio.h>
+
+// Per-rank, per-thread timeline of a construction run
+//
+// Between timeline_start and timeline_stop every thread records its spans in
+// its own buffer. Compute spans cover one chunk of vertices and carry the time
+// spent unranking and computing parents inside it (timing every vertex as a
+// separate span would dwarf the work). Exchange, checkpoint and verification
+// are recorded as single spans. Times are seconds since timeline_start, which
+// the MPI programs call right after a barrier so that ranks line up.
+
+#define TIMELINE_MAX_SPANS 65536    // Spans kept per thread, later ones are dropped
+
+typedef enum {
+    SPAN_COMPUTE,       // A chunk of vertices
+    SPAN_UNRANK,        // index_to_permutation inside compute spans
+    SPAN_PARENT,        // Parent1 and permutation_to_index inside compute spans
+    SPAN_ALLGATHER,     // Exchange of the trees between ranks
+    SPAN_CHECKPOINT,    // Writing a checkpoint
+    SPAN_VERIFY,        // Verification of the trees
+    SPAN_KIND_COUNT
+} SpanKind;
+
+typedef struct {
+    int rank;           // MPI rank (filled in when collected)
+    int thread;         // Thread number within the rank
+    int kind;           // SpanKind
+    int vertices;       // Vertices processed (compute spans)
+    double start;       // Seconds since timeline_start
+    double end;
+    double unrank;      // Seconds unranking (compute spans)
+    double parent;      // Seconds computing parents (compute spans)
+} TimelineSpan;
+
+// Accumulated time of one thread of one rank
+typedef struct {
+    int rank;
+    int thread;
+    int dropped;                        // Spans that did not fit in the buffer
+    double totals[SPAN_KIND_COUNT];     // Seconds per kind
+} TimelineWorker;
+
+// Function prototypes
+void timeline_start(void);
+void timeline_stop(void);
+int timeline_enabled(void);
+double timeline_now(void);
+void timeline_span(SpanKind kind, double start, double end);
+void timeline_compute_span(double start, double end, int vertices, double unrank, double parent);
+const char* timeline_kind_name(SpanKind kind);
+int timeline_collect(int rank, TimelineWorker** workers, int* worker_count,
+                     TimelineSpan** spans, int* span_count);
+void timeline_print_stats(FILE* out, const TimelineWorker* workers, int worker_count);
+int timeline_write_trace(const char* path, const TimelineWorker* workers, int worker_count,
+                         const TimelineSpan* spans, int span_count);
+
+// Defined with the MPI engine; collective over MPI_COMM_WORLD
+void timeline_report(const char* trace_path);
+
+#endif // IST_TIMELINE_H
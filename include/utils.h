@@ -19,9 +19,15 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "bubble_sort_network.h"
 #include "ist_algorithm.h"
 
+// FNV-1a 64-bit parameters (start a hash with FNV_OFFSET_BASIS)
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
 // Function prototypes for utility functions
 int factorial(int n);
 void swap(int* a, int* b);
@@ -29,6 +35,9 @@ int verify_spanning_tree(SpanningTree* tree, BubbleSortNetwork* network);
 int verify_independence(IndependentSpanningTrees* ists, BubbleSortNetwork* network);
 void print_permutation(Permutation* perm);
 void print_spanning_tree(SpanningTree* tree, BubbleSortNetwork* network);
+int report_verification(IndependentSpanningTrees* ists, BubbleSortNetwork* network);
+void print_example_paths(IndependentSpanningTrees* ists, int dimension);
 double measure_time();
+uint64_t fnv1a_hash(uint64_t hash, const void* data, size_t length);
 
 #endif // UTILS_H
\ No newline at end of file
@@ -0,0 +1,467 @@
+#include "bubble_sort_network.h"
+#include "ist_algorithm.h"
+#include "utils.h"
+#include "ist_depth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <mpi.h>
+#include <omp.h>
+
+// Benchmark harness for the sequential, MPI and hybrid engines
+//
+// Sweeps dimension and OpenMP thread count within one MPI job (the rank
+// count is swept by launching the harness with different -np, see
+// experiments/run_bench.sh). Every configuration is run warmup + repeat
+// times; each phase is timed on every rank and the slowest rank counts.
+
+#define MAX_SWEEP 64
+#define MAX_REPEAT 1000
+
+enum { ENGINE_SEQUENTIAL, ENGINE_MPI, ENGINE_HYBRID, ENGINE_COUNT };
+static const char* engine_names[ENGINE_COUNT] = { "sequential", "mpi", "hybrid" };
+
+enum { PHASE_NETWORK, PHASE_CONSTRUCTION, PHASE_EXCHANGE, PHASE_VERIFICATION, PHASE_DEPTH, PHASE_COUNT };
+static const char* phase_names[PHASE_COUNT] = { "network", "construction", "exchange", "verification", "depth" };
+
+typedef struct {
+    int values[MAX_SWEEP];
+    int count;
+} IntList;
+
+typedef struct {
+    double median;
+    double min;
+    double max;
+    double mean;
+    double stddev;
+} PhaseStats;
+
+// One benchmarked configuration
+typedef struct {
+    int engine;
+    int dimension;
+    int ranks;
+    int threads;
+    int valid;                      // 1 valid, 0 invalid, -1 not verified
+    PhaseStats phases[PHASE_COUNT];
+    TreeDepths* depths;             // Depths of the last run (rank 0, with --depth)
+} BenchResult;
+
+// Parse "4-9", "1,2,4" or a mix such as "4,6-8"
+static int parse_int_list(const char* text, IntList* list) {
+    list->count = 0;
+    const char* p = text;
+    
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p) return 0;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1) return 0;
+            p = end;
+        }
+        for (long v = first; v <= last; v++) {
+            if (list->count == MAX_SWEEP) return 0;
+            list->values[list->count++] = (int)v;
+        }
+        if (*p == ',') p++;
+        else if (*p) return 0;
+    }
+    
+    return list->count > 0;
+}
+
+// Parse a comma-separated list of engine names into flags
+static int parse_engines(const char* text, int* enabled) {
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        enabled[e] = 0;
+    }
+    
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (char* name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            if (strcmp(name, engine_names[e]) == 0) {
+                enabled[e] = 1;
+                found = 1;
+            }
+        }
+        if (!found) return 0;
+    }
+    
+    return 1;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Median, range, mean and standard deviation of count samples
+static void summarize(double* samples, int count, PhaseStats* stats) {
+    qsort(samples, count, sizeof(double), compare_doubles);
+    
+    stats->min = samples[0];
+    stats->max = samples[count - 1];
+    stats->median = count % 2 ? samples[count / 2]
+                              : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+    
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    stats->mean = sum / count;
+    
+    double squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        squares += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+    }
+    stats->stddev = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+}
+
+// Full verification of all trees; returns 1 if valid and independent
+static int verify_all(IndependentSpanningTrees* ists, BubbleSortNetwork* network) {
+    for (int t = 0; t < ists->tree_count; t++) {
+        if (!verify_spanning_tree(&ists->trees[t], network)) return 0;
+    }
+    return verify_independence(ists, network);
+}
+
+// Largest height and mean of the per-tree mean depths
+static void summarize_depths(const TreeDepths* depths, int tree_count, int* height, double* mean_depth) {
+    *height = 0;
+    *mean_depth = 0.0;
+    for (int t = 0; t < tree_count; t++) {
+        if (depths[t].height > *height) *height = depths[t].height;
+        *mean_depth += depths[t].mean_depth / tree_count;
+    }
+}
+
+// Run one configuration once; phase times are the maximum over ranks (valid on rank 0)
+// With depth set, rank 0 also returns the tree depths in *depths
+// Returns 0 if construction failed on any rank
+static int run_once(int engine, int dimension, int verify, int depth, double* phases, int* valid,
+                    TreeDepths** depths) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    double local[PHASE_COUNT] = { 0.0 };
+    int ok = 1;
+    *valid = -1;
+    
+    // Network build (every rank builds its own copy)
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    BubbleSortNetwork* network = create_bubble_sort_network(dimension);
+    local[PHASE_NETWORK] = MPI_Wtime() - start;
+    if (!network) ok = 0;
+    
+    // Construction (and exchange for the distributed engines)
+    IndependentSpanningTrees* ists = NULL;
+    ConstructionTimes times = { 0.0, 0.0 };
+    ParallelOptions options;
+    init_parallel_options(&options);
+    options.times = &times;
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (network && engine == ENGINE_SEQUENTIAL) {
+        if (rank == 0) {
+            start = MPI_Wtime();
+            ists = construct_sequential_ists(network);
+            local[PHASE_CONSTRUCTION] = MPI_Wtime() - start;
+            if (!ists) ok = 0;
+        }
+    } else if (network) {
+        ists = engine == ENGINE_MPI ? mpi_construct_ists_with_options(network, &options)
+                                    : hybrid_construct_ists_with_options(network, &options);
+        local[PHASE_CONSTRUCTION] = times.compute;
+        local[PHASE_EXCHANGE] = times.exchange;
+        if (!ists) ok = 0;
+    }
+    
+    // Verification on rank 0
+    if (verify && rank == 0 && ists) {
+        start = MPI_Wtime();
+        *valid = verify_all(ists, network);
+        local[PHASE_VERIFICATION] = MPI_Wtime() - start;
+    }
+    
+    // Depth statistics on rank 0
+    if (depth && rank == 0 && ists) {
+        start = MPI_Wtime();
+        *depths = compute_ists_depths(ists, 0);
+        local[PHASE_DEPTH] = MPI_Wtime() - start;
+        if (!*depths) ok = 0;
+    }
+    
+    MPI_Reduce(local, phases, PHASE_COUNT, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    int all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    
+    free_ists(ists);
+    free_bubble_sort_network(network);
+    return all_ok;
+}
+
+// Benchmark one configuration with warmup and repeats
+static int bench_configuration(int engine, int dimension, int threads, int warmup, int repeat,
+                               int verify, int depth, BenchResult* result) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    omp_set_num_threads(threads);
+    
+    double samples[PHASE_COUNT][MAX_REPEAT];
+    double phases[PHASE_COUNT];
+    int valid = -1;
+    
+    result->depths = NULL;
+    for (int i = 0; i < warmup; i++) {
+        if (!run_once(engine, dimension, 0, 0, phases, &valid, NULL)) return 0;
+    }
+    for (int i = 0; i < repeat; i++) {
+        // Depths are the same on every run; only the last set is kept
+        TreeDepths* depths = NULL;
+        int ok = run_once(engine, dimension, verify, depth, phases, &valid, &depths);
+        free_ists_depths(result->depths, dimension - 1);
+        result->depths = depths;
+        if (!ok) {
+            free_ists_depths(result->depths, dimension - 1);
+            result->depths = NULL;
+            return 0;
+        }
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            samples[p][i] = phases[p];
+        }
+    }
+    
+    result->engine = engine;
+    result->dimension = dimension;
+    result->ranks = engine == ENGINE_SEQUENTIAL ? 1 : size;
+    result->threads = threads;
+    result->valid = valid;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        summarize(samples[p], repeat, &result->phases[p]);
+    }
+    
+    return 1;
+}
+
+// Write results as CSV, adding the header only to a new or empty file
+static int write_csv(const char* path, BenchResult* results, int count, int repeat) {
+    FILE* out = fopen(path, "a");
+    if (!out) return 0;
+    
+    if (ftell(out) == 0) {
+        fprintf(out, "engine,dimension,vertices,ranks,threads,repeat,valid");
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, ",%s_median,%s_min,%s_max,%s_stddev",
+                    phase_names[p], phase_names[p], phase_names[p], phase_names[p]);
+        }
+        fprintf(out, ",max_height,mean_depth\n");
+    }
+    
+    for (int i = 0; i < count; i++) {
+        BenchResult* r = &results[i];
+        fprintf(out, "%s,%d,%d,%d,%d,%d,%d", engine_names[r->engine], r->dimension,
+                factorial(r->dimension), r->ranks, r->threads, repeat, r->valid);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, ",%.9f,%.9f,%.9f,%.9f", r->phases[p].median, r->phases[p].min,
+                    r->phases[p].max, r->phases[p].stddev);
+        }
+        if (r->depths) {
+            int height;
+            double mean_depth;
+            summarize_depths(r->depths, r->dimension - 1, &height, &mean_depth);
+            fprintf(out, ",%d,%.6f\n", height, mean_depth);
+        } else {
+            fprintf(out, ",,\n");
+        }
+    }
+    
+    return fclose(out) == 0;
+}
+
+// Write results as a JSON document with run metadata
+static int write_json(const char* path, BenchResult* results, int count, int warmup, int repeat) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    time_t now = time(NULL);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    
+    fprintf(out, "{\n  \"host\": \"%s\",\n  \"timestamp\": \"%s\",\n", host, timestamp);
+    fprintf(out, "  \"compiler\": \"%s\",\n  \"warmup\": %d,\n  \"repeat\": %d,\n", __VERSION__, warmup, repeat);
+    fprintf(out, "  \"results\": [\n");
+    for (int i = 0; i < count; i++) {
+        BenchResult* r = &results[i];
+        fprintf(out, "    {\"engine\": \"%s\", \"dimension\": %d, \"vertices\": %d, "
+                "\"ranks\": %d, \"threads\": %d, \"valid\": %d, \"phases\": {",
+                engine_names[r->engine], r->dimension, factorial(r->dimension),
+                r->ranks, r->threads, r->valid);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, "%s\"%s\": {\"median\": %.9f, \"min\": %.9f, \"max\": %.9f, "
+                    "\"mean\": %.9f, \"stddev\": %.9f}", p ? ", " : "", phase_names[p],
+                    r->phases[p].median, r->phases[p].min, r->phases[p].max,
+                    r->phases[p].mean, r->phases[p].stddev);
+        }
+        fprintf(out, "}");
+        if (r->depths) {
+            int height;
+            double mean_depth;
+            summarize_depths(r->depths, r->dimension - 1, &height, &mean_depth);
+            fprintf(out, ", \"depth\": {\"max_height\": %d, \"mean_depth\": %.6f, \"trees\": ",
+                    height, mean_depth);
+            write_depths_json(out, r->depths, r->dimension - 1);
+            fprintf(out, "}");
+        }
+        fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    
+    return fclose(out) == 0;
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--dims <list>] [--threads <list>] [--engines <list>]\n"
+           "       [--warmup <runs>] [--repeat <runs>] [--verify] [--depth]\n"
+           "       [--csv <file>] [--json <file>]\n"
+           "Lists accept ranges, e.g. --dims 4-9 --threads 1,2,4 --engines mpi,hybrid\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    int rank, size, provided;
+    
+    // Initialize MPI with thread support
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    IntList dims, threads;
+    parse_int_list("4-7", &dims);
+    parse_int_list("1", &threads);
+    int engines[ENGINE_COUNT] = { 1, 1, 1 };
+    int warmup = 1;
+    int repeat = 5;
+    int verify = 0;
+    int depth = 0;
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    
+    int ok = 1;
+    for (int i = 1; i < argc && ok; i++) {
+        if (strcmp(argv[i], "--dims") == 0 && i + 1 < argc) {
+            ok = parse_int_list(argv[++i], &dims);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            ok = parse_int_list(argv[++i], &threads);
+        } else if (strcmp(argv[i], "--engines") == 0 && i + 1 < argc) {
+            ok = parse_engines(argv[++i], engines);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if (strcmp(argv[i], "--depth") == 0) {
+            depth = 1;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            ok = 0;
+        }
+    }
+    for (int i = 0; i < dims.count && ok; i++) {
+        if (dims.values[i] < 3 || dims.values[i] > 12) ok = 0;
+    }
+    for (int i = 0; i < threads.count && ok; i++) {
+        if (threads.values[i] < 1) ok = 0;
+    }
+    if (warmup < 0 || repeat < 1 || repeat > MAX_REPEAT) ok = 0;
+    
+    if (!ok) {
+        if (rank == 0) {
+            print_usage(argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    BenchResult* results = (BenchResult*)malloc(ENGINE_COUNT * MAX_SWEEP * MAX_SWEEP * sizeof(BenchResult));
+    int result_count = 0;
+    
+    if (rank == 0) {
+        printf("%-10s %4s %6s %7s %12s %12s %12s %12s %12s %6s %6s\n", "engine", "n", "ranks", "threads",
+               "network", "construct", "exchange", "verify", "spread", "valid", "height");
+    }
+    
+    for (int d = 0; d < dims.count; d++) {
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            if (!engines[e]) continue;
+            
+            // Only the hybrid engine uses threads
+            int thread_count = e == ENGINE_HYBRID ? threads.count : 1;
+            for (int th = 0; th < thread_count; th++) {
+                BenchResult* result = &results[result_count];
+                int thread_value = e == ENGINE_HYBRID ? threads.values[th] : 1;
+                
+                if (!bench_configuration(e, dims.values[d], thread_value, warmup, repeat, verify, depth, result)) {
+                    if (rank == 0) {
+                        printf("Benchmark failed for %s engine on B_%d\n", engine_names[e], dims.values[d]);
+                    }
+                    continue;
+                }
+                result_count++;
+                
+                if (rank == 0) {
+                    // Spread is the range of the construction time relative to its median
+                    double median = result->phases[PHASE_CONSTRUCTION].median;
+                    double range = result->phases[PHASE_CONSTRUCTION].max - result->phases[PHASE_CONSTRUCTION].min;
+                    int height = -1;
+                    double mean_depth;
+                    if (result->depths) summarize_depths(result->depths, result->dimension - 1, &height, &mean_depth);
+                    char height_text[16] = "-";
+                    if (height >= 0) snprintf(height_text, sizeof(height_text), "%d", height);
+                    printf("%-10s %4d %6d %7d %12.6f %12.6f %12.6f %12.6f %11.1f%% %6s %6s\n",
+                           engine_names[e], result->dimension, result->ranks, result->threads,
+                           result->phases[PHASE_NETWORK].median,
+                           result->phases[PHASE_CONSTRUCTION].median,
+                           result->phases[PHASE_EXCHANGE].median,
+                           result->phases[PHASE_VERIFICATION].median,
+                           median > 0 ? 100.0 * range / median : 0.0,
+                           result->valid < 0 ? "-" : (result->valid ? "yes" : "no"), height_text);
+                }
+            }
+        }
+    }
+    
+    if (rank == 0) {
+        if (csv_path && !write_csv(csv_path, results, result_count, repeat)) {
+            printf("Failed to write %s\n", csv_path);
+        }
+        if (json_path && !write_json(json_path, results, result_count, warmup, repeat)) {
+            printf("Failed to write %s\n", json_path);
+        }
+    }
+    
+    for (int i = 0; i < result_count; i++) {
+        free_ists_depths(results[i].depths, results[i].dimension - 1);
+    }
+    free(results);
+    MPI_Finalize();
+    return 0;
+}
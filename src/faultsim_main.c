@@ -0,0 +1,308 @@
+#include "bubble_sort_network.h"
+#include "ist_algorithm.h"
+#include "utils.h"
+#include "ist_io.h"
+#include "ist_archive.h"
+#include "ist_fault.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Fault-injection simulator for routing along the independent spanning trees
+//
+// Every fault set is applied to all n-1 trees at once; for each source vertex
+// the simulator counts the trees whose path to the root avoids the faults and
+// the stretch of the shortest such path. Fault sets are random, adversarial
+// (the vertices with the largest subtrees) or read from a file.
+
+enum { MODE_RANDOM, MODE_ADVERSARIAL, MODE_FILE };
+
+static uint64_t random_state = 88172645463325252ULL;
+
+// xorshift64
+static uint64_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+// fault_count distinct vertices other than the root (vertex 0)
+static void random_fault_set(int vertex_count, int fault_count, FaultSet* set) {
+    set->fault_count = 0;
+    while (set->fault_count < fault_count) {
+        int v = 1 + (int)(next_random() % (uint64_t)(vertex_count - 1));
+        int duplicate = 0;
+        for (int i = 0; i < set->fault_count; i++) {
+            if (set->faults[i] == v) duplicate = 1;
+        }
+        if (!duplicate) set->faults[set->fault_count++] = v;
+    }
+}
+
+// Trees from a file (IST file or archive) or constructed from scratch
+static IndependentSpanningTrees* load_trees(int dimension, const char* input_path, MappedISTs** mapped) {
+    *mapped = NULL;
+    
+    if (!input_path) {
+        BubbleSortNetwork* network = create_bubble_sort_network(dimension);
+        if (!network) return NULL;
+        IndependentSpanningTrees* ists = construct_sequential_ists(network);
+        free_bubble_sort_network(network);
+        return ists;
+    }
+    
+    *mapped = map_ists_file(input_path, 1);
+    if (*mapped) return &(*mapped)->ists;
+    
+    // Not a plain IST file, try a compressed archive
+    IndependentSpanningTrees* ists = NULL;
+    ISTArchive* archive = open_ist_archive(input_path, 1);
+    if (archive) {
+        ists = ist_archive_extract(archive);
+        close_ist_archive(archive);
+    }
+    return ists;
+}
+
+// Write one line per fault set
+static int write_csv(const char* path, const FaultSet* sets, const FaultResult* results, int count) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    fprintf(out, "set,faults,sources,delivered,min_paths,mean_stretch,max_stretch\n");
+    for (int s = 0; s < count; s++) {
+        fprintf(out, "%d,", s);
+        for (int i = 0; i < sets[s].fault_count; i++) {
+            fprintf(out, "%s%d", i ? " " : "", sets[s].faults[i]);
+        }
+        fprintf(out, ",%d,%d,%d,%.6f,%.6f\n", results[s].sources, results[s].delivered,
+                results[s].min_paths, results[s].mean_stretch, results[s].max_stretch);
+    }
+    
+    return fclose(out) == 0;
+}
+
+// Totals over all fault sets
+typedef struct {
+    double mean_delivery;       // Mean fraction of sources delivered
+    double worst_delivery;      // Smallest fraction of sources delivered
+    int worst_set;              // Set with the smallest fraction
+    int disconnected_sets;      // Sets in which some source lost every path
+    long long paths[IST_FAULT_MAX_TREES + 1];
+    long long sources;
+    double mean_stretch;        // Over all delivered sources of all sets
+    double max_stretch;
+} FaultSummary;
+
+static void summarize(const FaultResult* results, int count, int tree_count, FaultSummary* summary) {
+    memset(summary, 0, sizeof(FaultSummary));
+    summary->worst_delivery = 1.0;
+    
+    double stretch_sum = 0.0;
+    long long delivered = 0;
+    for (int s = 0; s < count; s++) {
+        const FaultResult* r = &results[s];
+        double delivery = r->sources ? (double)r->delivered / r->sources : 1.0;
+        summary->mean_delivery += delivery / count;
+        if (delivery < summary->worst_delivery) {
+            summary->worst_delivery = delivery;
+            summary->worst_set = s;
+        }
+        if (r->min_paths == 0) summary->disconnected_sets++;
+        
+        for (int p = 0; p <= tree_count; p++) {
+            summary->paths[p] += r->paths[p];
+        }
+        summary->sources += r->sources;
+        stretch_sum += r->mean_stretch * r->delivered;
+        delivered += r->delivered;
+        if (r->max_stretch > summary->max_stretch) summary->max_stretch = r->max_stretch;
+    }
+    summary->mean_stretch = delivered ? stretch_sum / delivered : 0.0;
+}
+
+static int write_json(const char* path, const FaultSummary* summary, int dimension, int tree_count,
+                      int fault_count, int set_count, const char* mode, double seconds) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    fprintf(out, "{\n  \"dimension\": %d,\n  \"trees\": %d,\n  \"faults\": %d,\n  \"sets\": %d,\n",
+            dimension, tree_count, fault_count, set_count);
+    fprintf(out, "  \"mode\": \"%s\",\n  \"seconds\": %.6f,\n  \"sets_per_second\": %.1f,\n",
+            mode, seconds, seconds > 0 ? set_count / seconds : 0.0);
+    fprintf(out, "  \"mean_delivery\": %.6f,\n  \"worst_delivery\": %.6f,\n  \"worst_set\": %d,\n",
+            summary->mean_delivery, summary->worst_delivery, summary->worst_set);
+    fprintf(out, "  \"disconnected_sets\": %d,\n  \"mean_stretch\": %.6f,\n  \"max_stretch\": %.6f,\n",
+            summary->disconnected_sets, summary->mean_stretch, summary->max_stretch);
+    fprintf(out, "  \"surviving_paths\": [");
+    for (int p = 0; p <= tree_count; p++) {
+        fprintf(out, "%s%lld", p ? ", " : "", summary->paths[p]);
+    }
+    fprintf(out, "]\n}\n");
+    
+    return fclose(out) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <dimension> [--input <file.ist|file.istz>] [--faults <k>] [--sets <count>]\n"
+               "       [--mode random|adversarial] [--fault-file <file>] [--seed <n>]\n"
+               "       [--csv <file>] [--json <file>]\n", argv[0]);
+        return 1;
+    }
+    
+    int dimension = atoi(argv[1]);
+    if (dimension < 3 || dimension - 1 > IST_FAULT_MAX_TREES) {
+        printf("Dimension must be between 3 and %d\n", IST_FAULT_MAX_TREES + 1);
+        return 1;
+    }
+    
+    const char* input_path = NULL;
+    const char* fault_path = NULL;
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    int mode = MODE_RANDOM;
+    int fault_count = dimension - 2;
+    int set_count = 1000;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--faults") == 0 && i + 1 < argc) {
+            fault_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sets") == 0 && i + 1 < argc) {
+            set_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "random") == 0) {
+                mode = MODE_RANDOM;
+            } else if (strcmp(argv[i], "adversarial") == 0) {
+                mode = MODE_ADVERSARIAL;
+            } else {
+                printf("Unknown mode: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--fault-file") == 0 && i + 1 < argc) {
+            fault_path = argv[++i];
+            mode = MODE_FILE;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            random_state = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    if (fault_count < 0 || fault_count > IST_FAULT_MAX_FAULTS || fault_count >= factorial(dimension) ||
+        set_count < 1) {
+        printf("Invalid number of faults or sets\n");
+        return 1;
+    }
+    
+    double start_time = measure_time();
+    MappedISTs* mapped;
+    IndependentSpanningTrees* ists = load_trees(dimension, input_path, &mapped);
+    if (!ists || ists->tree_count != dimension - 1) {
+        printf("Failed to %s ISTs for B_%d\n", input_path ? "load" : "construct", dimension);
+        if (mapped) {
+            unmap_ists_file(mapped);
+        } else {
+            free_ists(ists);
+        }
+        return 1;
+    }
+    printf("ISTs of B_%d ready in %.6f seconds\n", dimension, measure_time() - start_time);
+    
+    start_time = measure_time();
+    FaultModel* model = create_fault_model(ists, dimension);
+    if (!model) {
+        printf("Failed to build the fault model\n");
+        if (mapped) {
+            unmap_ists_file(mapped);
+        } else {
+            free_ists(ists);
+        }
+        return 1;
+    }
+    printf("Fault model built in %.6f seconds\n", measure_time() - start_time);
+    
+    // Fault sets
+    FaultSet* sets = NULL;
+    const char* mode_name = mode == MODE_FILE ? "file" : (mode == MODE_ADVERSARIAL ? "adversarial" : "random");
+    if (mode == MODE_FILE) {
+        if (!read_fault_sets(fault_path, model->vertex_count, model->root, &sets, &set_count) || set_count == 0) {
+            printf("No fault sets read from %s\n", fault_path);
+            set_count = 0;
+        }
+    } else {
+        // An adversarial set is deterministic, so there is only one
+        if (mode == MODE_ADVERSARIAL) set_count = 1;
+        sets = (FaultSet*)malloc(set_count * sizeof(FaultSet));
+        for (int s = 0; sets && s < set_count; s++) {
+            if (mode == MODE_ADVERSARIAL) {
+                adversarial_fault_set(model, fault_count, &sets[s]);
+            } else {
+                random_fault_set(model->vertex_count, fault_count, &sets[s]);
+            }
+        }
+    }
+    
+    FaultResult* results = set_count ? (FaultResult*)malloc(set_count * sizeof(FaultResult)) : NULL;
+    int status = 1;
+    
+    if (sets && results) {
+        printf("\nSimulating %d %s fault set%s on %d trees (%d vertices)...\n", set_count, mode_name,
+               set_count == 1 ? "" : "s", model->tree_count, model->vertex_count);
+        
+        start_time = measure_time();
+        int ok = simulate_fault_sets(model, sets, set_count, results);
+        double seconds = measure_time() - start_time;
+        
+        if (ok) {
+            FaultSummary summary;
+            summarize(results, set_count, model->tree_count, &summary);
+            
+            printf("Evaluated in %.6f seconds (%.1f sets/s)\n", seconds, set_count / seconds);
+            printf("Delivery: mean %.4f%% of sources, worst %.4f%% (set %d)\n",
+                   100.0 * summary.mean_delivery, 100.0 * summary.worst_delivery, summary.worst_set);
+            printf("Sets in which some source lost every path: %d\n", summary.disconnected_sets);
+            printf("Sources by surviving paths:\n");
+            for (int p = 0; p <= model->tree_count; p++) {
+                printf("  %2d: %12lld (%.4f%%)\n", p, summary.paths[p],
+                       summary.sources ? 100.0 * summary.paths[p] / summary.sources : 0.0);
+            }
+            printf("Stretch of the shortest surviving path: mean %.4f, max %.4f\n",
+                   summary.mean_stretch, summary.max_stretch);
+            
+            if (csv_path && !write_csv(csv_path, sets, results, set_count)) {
+                printf("Failed to write %s\n", csv_path);
+            }
+            if (json_path && !write_json(json_path, &summary, dimension, model->tree_count,
+                                         fault_count, set_count, mode_name, seconds)) {
+                printf("Failed to write %s\n", json_path);
+            }
+            status = 0;
+        } else {
+            printf("Fault simulation failed\n");
+        }
+    } else if (set_count) {
+        printf("Failed to allocate fault sets\n");
+    }
+    
+    // Clean up
+    free(results);
+    free(sets);
+    free_fault_model(model);
+    if (mapped) {
+        unmap_ists_file(mapped);
+    } else {
+        free_ists(ists);
+    }
+    
+    return status;
+}
@@ -8,13 +8,13 @@
 
 // int main(int argc, char* argv[]) {
 //     int rank, size;
-    
+
 //     // Initialize MPI
 //     int provided;
 //     MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
 //     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 //     MPI_Comm_size(MPI_COMM_WORLD, &size);
-    
+
 //     // Check command line arguments
 //     if (argc < 3) {
 //         if (rank == 0) {
@@ -23,10 +23,10 @@
 //         MPI_Finalize();
 //         return 1;
 //     }
-    
+
 //     int dimension = atoi(argv[1]);
 //     int num_threads = atoi(argv[2]);
-    
+
 //     if (dimension < 3) {
 //         if (rank == 0) {
 //             printf("Dimension must be at least 3\n");
@@ -34,15 +34,15 @@
 //         MPI_Finalize();
 //         return 1;
 //     }
-    
+
 //     // Set number of OpenMP threads
 //     omp_set_num_threads(num_threads);
-    
+
 //     if (rank == 0) {
 //         printf("Creating bubble-sort network B_%d...\n", dimension);
 //         printf("Using %d MPI processes with %d threads each\n", size, num_threads);
 //     }
-    
+
 //     BubbleSortNetwork* network = create_bubble_sort_network(dimension);
 //     if (!network) {
 //         if (rank == 0) {
@@ -51,26 +51,26 @@
 //         MPI_Finalize();
 //         return 1;
 //     }
-    
+
 //     if (rank == 0) {
 //         printf("Constructing %d independent spanning trees with hybrid parallelism...\n", 
 //                dimension - 1);
 //     }
-    
+
 //     double start_time = MPI_Wtime();
-    
+
 //     // Construct ISTs with hybrid parallelism
 //     construct_hybrid_ists(network);
-    
+
 //     double end_time = MPI_Wtime();
-    
+
 //     if (rank == 0) {
 //         printf("Construction completed in %.6f seconds\n", end_time - start_time);
 //     }
-    
+
 //     // Clean up
 //     free_bubble_sort_network(network);
-    
+
 //     MPI_Finalize();
 //     return 0;
 // }
@@ -78,8 +78,21 @@
 #include "bubble_sort_network.h"
 #include "ist_algorithm.h"
 #include "utils.h"
+#include "ist_io.h"
+#include "ist_checkpoint.h"
+#include "ist_profile.h"
+#include "ist_timeline.h"
+#include "ist_depth.h"
+#include "ist_children.h"
+#include "ist_reroot.h"
+#include "ist_memory.h"
+#include "ist_shared.h"
+#include "ist_sample.h"
+#include "ist_digest.h"
+#include "ist_congestion.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <mpi.h>
 #include <omp.h>
 
@@ -97,7 +110,184 @@ int main(int argc, char* argv[]) {
     // Check command line arguments
     if (argc < 3) {
         if (rank == 0) {
-            printf("Usage: %s <dimension> <num_threads>\n", argv[0]);
+            printf("Usage: %s <dimension> <num_threads> [--output <file.ist>]\n"
+                   "       [--checkpoint-dir <dir>] [--checkpoint-interval <seconds>] [--resume]\n"
+                   "       [--dynamic] [--chunk-size <vertices>] [--shared]\n"
+                   "       [--placement all|root|distributed]\n"
+                   "       [--profile-json <file>] [--timeline] [--trace <file.json>]\n"
+                   "       [--depth] [--depth-json <file>] [--broadcast] [--root <vertex>]\n"
+                   "       [--congestion] [--congestion-top <k>] [--congestion-json <file>]\n"
+                   "       [--verify auto|full|sample|none] [--samples <K>] [--seed <S>] [--sample-vertex <v>]\n"
+                   "       [--expect-digest <hex>]\n"
+                   "       [--storage auto|full|trees] [--memory-limit <MiB per node>] [--plan]\n", argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    const char* output_path = NULL;
+    const char* checkpoint_dir = NULL;
+    double checkpoint_interval = IST_CHECKPOINT_DEFAULT_INTERVAL;
+    int resume = 0;
+    const char* profile_path = NULL;
+    const char* trace_path = NULL;
+    int timeline = 0;
+    const char* depth_path = NULL;
+    const char* congestion_path = NULL;
+    int congestion = 0;
+    int congestion_top = IST_CONGESTION_DEFAULT_TOP;
+    int depth = 0;
+    int broadcast = 0;
+    int root = -1;
+    StorageMode storage = STORAGE_AUTO;
+    uint64_t memory_limit = 0;
+    int plan_only = 0;
+    int chunk_size = 0;
+    int shared = 0;
+    ResultPlacement placement = PLACEMENT_ROOT;
+    VerifyMode verify = VERIFY_AUTO;
+    SampleOptions sample_options;
+    init_sample_options(&sample_options);
+    int verify_given = 0;
+    int sampling = 0;
+    uint64_t expected_digest;
+    int expect_digest = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-dir") == 0 && i + 1 < argc) {
+            checkpoint_dir = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc) {
+            checkpoint_interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            resume = 1;
+        } else if (strcmp(argv[i], "--profile-json") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--timeline") == 0) {
+            timeline = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+            timeline = 1;
+        } else if (strcmp(argv[i], "--depth") == 0) {
+            depth = 1;
+        } else if (strcmp(argv[i], "--depth-json") == 0 && i + 1 < argc) {
+            depth_path = argv[++i];
+            depth = 1;
+        } else if (strcmp(argv[i], "--broadcast") == 0) {
+            broadcast = 1;
+        } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--congestion") == 0) {
+            congestion = 1;
+        } else if (strcmp(argv[i], "--congestion-top") == 0 && i + 1 < argc) {
+            congestion_top = atoi(argv[++i]);
+            congestion = 1;
+        } else if (strcmp(argv[i], "--congestion-json") == 0 && i + 1 < argc) {
+            congestion_path = argv[++i];
+            congestion = 1;
+        } else if (strcmp(argv[i], "--storage") == 0 && i + 1 < argc) {
+            if (!parse_storage_mode(argv[++i], &storage)) {
+                if (rank == 0) {
+                    printf("Unknown storage mode: %s\n", argv[i]);
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc) {
+            memory_limit = (uint64_t)atof(argv[++i]) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--plan") == 0) {
+            plan_only = 1;
+        } else if (strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            if (!parse_verify_mode(argv[++i], &verify)) {
+                if (rank == 0) {
+                    printf("Unknown verification mode: %s\n", argv[i]);
+                }
+                MPI_Finalize();
+                return 1;
+            }
+            verify_given = 1;
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            sample_options.samples = atoi(argv[++i]);
+            sampling = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            sample_options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--sample-vertex") == 0 && i + 1 < argc) {
+            if (!add_sample_vertex(&sample_options, atoi(argv[++i]))) {
+                if (rank == 0) {
+                    printf("At most %d vertices can be given with --sample-vertex\n", IST_SAMPLE_MAX_VERTICES);
+                }
+                MPI_Finalize();
+                return 1;
+            }
+            sampling = 1;
+        } else if (strcmp(argv[i], "--expect-digest") == 0 && i + 1 < argc) {
+            if (!parse_digest(argv[++i], &expected_digest)) {
+                if (rank == 0) {
+                    printf("Invalid digest: %s\n", argv[i]);
+                }
+                MPI_Finalize();
+                return 1;
+            }
+            expect_digest = 1;
+        } else if (strcmp(argv[i], "--dynamic") == 0) {
+            if (chunk_size == 0) chunk_size = IST_DEFAULT_CHUNK;
+        } else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) {
+            chunk_size = atoi(argv[++i]);
+            if (chunk_size < 1) {
+                if (rank == 0) {
+                    printf("Chunk size must be positive\n");
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--shared") == 0) {
+            shared = 1;
+        } else if (strcmp(argv[i], "--placement") == 0 && i + 1 < argc) {
+            if (!parse_result_placement(argv[++i], &placement)) {
+                if (rank == 0) {
+                    printf("Unknown placement: %s\n", argv[i]);
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else {
+            if (rank == 0) {
+                printf("Unknown option: %s\n", argv[i]);
+            }
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    
+    if (chunk_size > 0 && (checkpoint_dir || resume)) {
+        if (rank == 0) {
+            printf("Checkpoints need the static split and cannot be used with dynamic chunks\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    // --samples and --sample-vertex ask for sampling unless --verify says otherwise
+    if (sampling && !verify_given) verify = VERIFY_SAMPLE;
+    if (sample_options.samples < 0) {
+        if (rank == 0) {
+            printf("The number of samples must not be negative\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    if (placement == PLACEMENT_DISTRIBUTED && (output_path || depth || broadcast || root >= 0 || congestion)) {
+        if (rank == 0) {
+            printf("Distributed trees cannot be written or analysed; use --placement root\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    if (shared && (chunk_size > 0 || checkpoint_dir || resume)) {
+        if (rank == 0) {
+            printf("Shared windows need the static split and cannot be used with dynamic chunks or checkpoints\n");
         }
         MPI_Finalize();
         return 1;
@@ -119,14 +309,60 @@ int main(int argc, char* argv[]) {
     
     // Only rank 0 prints the initial information
     if (rank == 0) {
-        printf("Creating bubble-sort network B_%d with %d vertices...\n", 
-               dimension, factorial(dimension));
         printf("Using %d MPI processes with %d OpenMP threads each\n", size, num_threads);
     }
     
-    // Create the bubble-sort network
+    // Plan the memory of every node before anything large is allocated; rank 0
+    // also verifies and analyses the trees
+    MemoryNeeds needs;
+    init_memory_needs(&needs, dimension);
+    needs.threads = num_threads;
+    needs.verify = rank == 0 && placement != PLACEMENT_DISTRIBUTED && (verify == VERIFY_AUTO || verify == VERIFY_FULL);
+    needs.depth = rank == 0 && depth;
+    needs.broadcast = rank == 0 && broadcast;
+    needs.reroot = rank == 0 && root >= 0;
+    needs.congestion = rank == 0 && congestion;
+    needs.shared_copy = shared && shared_node_rank() > 0;
+    needs.tree_ranks = placement == PLACEMENT_ALL || (placement == PLACEMENT_ROOT && rank == 0) ? 1 : size;
+    
+    MemoryPlan plan;
+    estimate_memory(&needs, &plan);
+    reduce_memory_plan(&plan, storage, memory_limit);
+    int accepted = 1;
+    if (rank == 0) {
+        printf("\n");
+        print_memory_plan(stdout, &plan);
+        accepted = accept_memory_plan(stdout, &plan, storage, dimension);
+    }
+    MPI_Bcast(&accepted, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (plan_only || !accepted) {
+        MPI_Finalize();
+        return plan_only && plan.fits ? 0 : 1;
+    }
+    
+    if (rank == 0) {
+        if (plan.mode == STORAGE_FULL) {
+            printf("\nCreating bubble-sort network B_%d with %d vertices...\n", 
+                   dimension, factorial(dimension));
+        } else {
+            printf("\nUsing B_%d with %d vertices without building its edges...\n",
+                   dimension, factorial(dimension));
+        }
+    }
+    
+    // Create the bubble-sort network; in trees mode only the dimension is kept.
+    // With --shared the network and trees are allocated once per node
     double start_time = MPI_Wtime();
-    BubbleSortNetwork* network = create_bubble_sort_network(dimension);
+    SharedISTs* shared_ists = NULL;
+    BubbleSortNetwork* network;
+    if (shared) {
+        shared_ists = create_shared_ists(dimension, plan.mode == STORAGE_FULL);
+        network = shared_ists ? &shared_ists->network : NULL;
+    } else {
+        // Ranks that only keep their own vertices never verify, so they skip the edges
+        network = plan.mode == STORAGE_FULL && needs.tree_ranks == 1 ? create_bubble_sort_network(dimension)
+                                                                     : create_bubble_sort_network_shape(dimension);
+    }
     double end_time = MPI_Wtime();
     
     if (!network) {
@@ -139,13 +375,48 @@ int main(int argc, char* argv[]) {
     
     if (rank == 0) {
         printf("Network created in %.6f seconds\n", end_time - start_time);
+        if (shared_ists) {
+            printf("Shared windows: %.1f MiB per node, one copy for %d ranks\n",
+                   shared_ists->bytes / (1024.0 * 1024.0), shared_ists->node_size);
+        }
         printf("\nConstructing %d independent spanning trees using hybrid parallelism...\n", dimension - 1);
     }
     
+    // Set up per-rank checkpoints
+    ParallelOptions options;
+    init_parallel_options(&options);
+    options.placement = placement;
+    uint64_t local_digest = 0;
+    options.digest = &local_digest;
+    ConstructionTimes times = { 0.0, 0.0 };
+    int chunks_taken = 0;
+    if (chunk_size > 0) {
+        options.chunk_size = chunk_size;
+        options.chunks_taken = &chunks_taken;
+        options.times = &times;
+    }
+    if (checkpoint_dir || resume) {
+        options.checkpoint = open_checkpoint(checkpoint_dir ? checkpoint_dir : "ist_checkpoint",
+                                             dimension, rank, size, checkpoint_interval, resume);
+        if (!options.checkpoint) {
+            printf("Rank %d: failed to open checkpoint directory\n", rank);
+            free_bubble_sort_network(network);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    
     // Construct independent spanning trees with hybrid parallelism
     MPI_Barrier(MPI_COMM_WORLD);
+    if (timeline) timeline_start();
     start_time = MPI_Wtime();
-    IndependentSpanningTrees* ists = hybrid_construct_ists(network);
+    IndependentSpanningTrees* ists;
+    if (shared_ists) {
+        options.shared = shared_ists;
+        construct_hybrid_ists_with_options(network, &shared_ists->ists, &options);
+        ists = &shared_ists->ists;
+    } else {
+        ists = hybrid_construct_ists_with_options(network, &options);
+    }
     MPI_Barrier(MPI_COMM_WORLD);
     end_time = MPI_Wtime();
     
@@ -158,82 +429,108 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    if (rank == 0) {
-        printf("ISTs constructed in %.6f seconds\n", end_time - start_time);
+    if (options.checkpoint) {
+        // Report the slowest rank's checkpoint cost relative to construction
+        double local_stats[2] = { options.checkpoint->write_time, options.checkpoint->checkpoints_written };
+        double max_stats[2];
+        int counts[2] = { options.checkpoint->vertices_restored, options.checkpoint->checkpoints_failed };
+        int total_counts[2];
+        MPI_Reduce(local_stats, max_stats, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        MPI_Reduce(counts, total_counts, 2, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
         
-        // Verify the spanning trees
-        printf("\nVerifying spanning trees...\n");
-        int valid = 1;
-        for (int t = 0; t < dimension - 1; t++) {
-            if (!verify_spanning_tree(&ists->trees[t], network)) {
-                printf("Tree %d is not a valid spanning tree\n", t + 1);
-                valid = 0;
-                break;
+        if (rank == 0) {
+            if (resume) {
+                printf("Resumed %d of %d vertices from checkpoints\n", total_counts[0], network->vertex_count);
             }
+            printf("Checkpoints: up to %d per rank, %d failed, %.6f seconds max (%.2f%% of construction)\n",
+                   (int)max_stats[1], total_counts[1], max_stats[0], 100.0 * max_stats[0] / (end_time - start_time));
         }
+        close_checkpoint(options.checkpoint);
+    }
+    
+    if (chunk_size > 0) {
+        report_chunk_counts(chunks_taken, times.compute);
+    }
+    
+    // Each rank digested the vertices it computed, so the sum covers every vertex once
+    uint64_t digest = reduce_digest(local_digest);
+    int status = 0;
+    
+    // Report the Parent1 case counters of all threads and ranks
+    if (ist_profile_enabled()) {
+        uint64_t profile[IST_PROFILE_COUNTERS];
+        int profile_threads;
+        reduce_profile_counts(profile, &profile_threads);
         
-        if (valid) {
-            printf("All trees are valid spanning trees\n");
-            
-            // Verify independence
-            printf("\nVerifying independence...\n");
-            if (!verify_independence(ists, network)) {
-                printf("Trees are not independent\n");
-                valid = 0;
-            } else {
-                printf("All trees are independent\n");
+        if (rank == 0) {
+            printf("\n");
+            ist_profile_print(stdout, profile);
+            if (profile_path && !ist_profile_write_json(profile_path, profile, dimension, size, profile_threads)) {
+                printf("Failed to write profile to %s\n", profile_path);
             }
         }
+    } else if (profile_path && rank == 0) {
+        printf("Case profiling is not compiled in (build with make PROFILE=1)\n");
+    }
+    
+    if (rank == 0) {
+        printf("ISTs constructed in %.6f seconds\n", end_time - start_time);
+        if (!report_digest(stdout, digest, expect_digest ? &expected_digest : NULL)) status = 1;
         
-        if (valid) {
-            printf("\nSuccessfully constructed %d valid independent spanning trees\n", dimension - 1);
+        if (depth) {
+            report_tree_depths(stdout, ists, dimension, depth_path);
+        }
+        if (broadcast) {
+            report_broadcast(stdout, ists);
+        }
+        if (root >= 0) {
+            report_reroot(stdout, ists, dimension, root);
+        }
+        if (congestion) {
+            report_congestion(stdout, ists, dimension, congestion_top, congestion_path);
         }
         
-        // Example path from a specific vertex to root in each tree
-        if (dimension == 4) {
-            // Example vertex: 4231 (as in Fig. 3 of the paper)
-            int example_index = -1;
-            for (int i = 0; i < network->vertex_count; i++) {
-                Permutation* perm = index_to_permutation(i, dimension);
-                if (perm->elements[0] == 4 && perm->elements[1] == 2 && 
-                    perm->elements[2] == 3 && perm->elements[3] == 1) {
-                    example_index = i;
-                    free_permutation(perm);
-                    break;
-                }
-                free_permutation(perm);
-            }
-            
-            if (example_index != -1) {
-                printf("\nExample paths from vertex 4231 to root in each tree:\n");
-                for (int t = 0; t < dimension - 1; t++) {
-                    printf("Tree T_%d: ", t+1);
-                    
-                    // Trace path to root
-                    int current = example_index;
-                    while (current != 0) {  // 0 is the identity permutation
-                        Permutation* perm = index_to_permutation(current, dimension);
-                        print_permutation(perm);
-                        printf(" -> ");
-                        free_permutation(perm);
-                        
-                        current = ists->trees[t].parent[current];
-                    }
-                    
-                    // Print root
-                    Permutation* root = index_to_permutation(0, dimension);
-                    print_permutation(root);
-                    printf("\n");
-                    free_permutation(root);
-                }
+        // Verify the spanning trees
+        double verify_start = timeline_now();
+        // Without network edges the trees are sampled; distributed trees are
+        // not on rank 0, so the sampler recomputes their parents
+        if (placement == PLACEMENT_DISTRIBUTED) {
+            printf("\nThe trees stay distributed over %d ranks\n", size);
+        }
+        verify_ists(stdout, verify, placement == PLACEMENT_DISTRIBUTED ? NULL : ists, network,
+                    dimension, &sample_options);
+        timeline_span(SPAN_VERIFY, verify_start, timeline_now());
+        
+        if (placement != PLACEMENT_DISTRIBUTED) {
+            print_example_paths(ists, dimension);
+        }
+        
+        if (output_path) {
+            double write_start = MPI_Wtime();
+            if (write_ists_file(output_path, ists, dimension)) {
+                printf("\nISTs written to %s in %.6f seconds\n", output_path, MPI_Wtime() - write_start);
+            } else {
+                printf("\nFailed to write ISTs to %s\n", output_path);
             }
         }
     }
     
+    // Per-rank and per-thread breakdown of the run
+    if (timeline) {
+        timeline_stop();
+        timeline_report(trace_path);
+    }
+    
+    reduce_peak_rss(&plan);
+    
     // Clean up
-    free_ists(ists);
-    free_bubble_sort_network(network);
+    if (shared_ists) {
+        free_shared_ists(shared_ists);
+    } else {
+        free_ists(ists);
+        free_bubble_sort_network(network);
+    }
     
     MPI_Finalize();
-    return 0;
+    return status;
 }
\ No newline at end of file
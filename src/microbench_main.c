@@ -0,0 +1,769 @@
+#include "bubble_sort_network.h"
+#include "ist_algorithm.h"
+#include "utils.h"
+#include "ist_kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Microbenchmarks for the permutation primitives and Parent1
+//
+// Every primitive is timed in isolation over a pool of prepared inputs:
+//   random      - uniformly random permutations, tree indices and symbols
+//   sequential  - consecutive permutations in index order
+//   adversarial - inputs cycling through every case of Parent1, with the
+//                 looked-up symbol second to last (longest scan)
+// Results are reported as ns/op and ops/s (median of the repeats). Ranking
+// and unranking use int indices and are only measured up to MAX_RANK_DIMENSION.
+// With --compare, allocation-free alternatives are checked against the
+// library versions and timed alongside them. parent_kernel times the generic
+// and the dimension-specialized kernels per vertex (all n-1 trees) over the
+// first KERNEL_RANGE vertices, in order (sequential) or in short runs at
+// random offsets (random), followed by the batch kernels of every instruction
+// set the CPU supports (simd-scalar, simd-avx2, simd-avx512).
+
+#define POOL_SIZE 4096
+#define MAX_DIMENSION 16
+#define MAX_RANK_DIMENSION 12   // 13! does not fit in an int
+#define MAX_SWEEP 64
+#define MAX_REPEAT 1000
+#define KERNEL_RANGE 65536
+#define KERNEL_RUN 64           // Vertices per kernel call for random inputs
+
+enum { INPUT_RANDOM, INPUT_SEQUENTIAL, INPUT_ADVERSARIAL, INPUT_COUNT };
+static const char* input_names[INPUT_COUNT] = { "random", "sequential", "adversarial" };
+
+enum {
+    PRIM_INDEX_TO_PERMUTATION,
+    PRIM_PERMUTATION_TO_INDEX,
+    PRIM_PARENT1,
+    PRIM_IS_SWAP_IDENTITY,
+    PRIM_RIGHT_POSITION,
+    PRIM_FIND_POSITION,
+    PRIM_PARENT_KERNEL,
+    PRIM_COUNT
+};
+static const char* primitive_names[PRIM_COUNT] = {
+    "index_to_permutation", "permutation_to_index", "Parent1",
+    "is_swap_identity", "right_position", "find_position", "parent_kernel"
+};
+
+// Prepared inputs for one dimension and input kind
+typedef struct {
+    int dimension;
+    int count;
+    Permutation* perms[POOL_SIZE];  // Never the identity (Parent1 has no parent for it)
+    int tree[POOL_SIZE];            // Tree index t in 1..n-1 for Parent1
+    int symbol[POOL_SIZE];          // Symbol not in the last position
+    int index[POOL_SIZE];           // Index of perms[i], valid up to MAX_RANK_DIMENSION
+} InputPool;
+
+// Signature of a timed loop over a pool; returns a value derived from the
+// results so the compiler cannot drop the work
+typedef long (*BenchLoop)(InputPool* pool, int iterations);
+
+typedef struct {
+    int primitive;
+    const char* implementation;
+    BenchLoop loop;
+} BenchEntry;
+
+typedef struct {
+    int values[MAX_SWEEP];
+    int count;
+} IntList;
+
+static volatile long sink;
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// xorshift64*, seeded from the command line so runs are reproducible
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+static int random_below(int bound) {
+    return (int)(next_random() % (unsigned long long)bound);
+}
+
+// ---------------------------------------------------------------------------
+// Alternative implementations, compared against the library with --compare
+// ---------------------------------------------------------------------------
+
+// Index without the working copy: the Lehmer digit of position i is the
+// number of smaller symbols to its right, accumulated in Horner form
+static int permutation_to_index_direct(Permutation* perm, int dimension) {
+    int index = 0;
+    for (int i = 0; i < dimension; i++) {
+        int smaller_count = 0;
+        for (int j = i + 1; j < dimension; j++) {
+            if (perm->elements[j] < perm->elements[i]) smaller_count++;
+        }
+        index = index * (dimension - i) + smaller_count;
+    }
+    return index;
+}
+
+// Unrank into caller storage, selecting symbols from a bit mask
+static void index_to_elements_direct(int index, int dimension, int* elements) {
+    int digits[MAX_DIMENSION];
+    for (int i = dimension - 1; i >= 0; i--) {
+        digits[i] = index % (dimension - i);
+        index /= dimension - i;
+    }
+    
+    unsigned int available = (1u << dimension) - 1;
+    for (int i = 0; i < dimension; i++) {
+        unsigned int mask = available;
+        for (int d = digits[i]; d > 0; d--) {
+            mask &= mask - 1;
+        }
+        int bit = __builtin_ctz(mask);
+        elements[i] = bit + 1;
+        available &= ~(1u << bit);
+    }
+}
+
+// Linear scan for the position of value, as before the inverse was tracked
+static int find_position_scan(Permutation* perm, int value) {
+    for (int i = 0; i < perm->n; i++) {
+        if (perm->elements[i] == value) return i + 1;
+    }
+    return -1;
+}
+
+// Swap on a working copy and compare it with the identity, as before the
+// inverse was tracked
+static int is_swap_identity_copy(Permutation* perm, int t) {
+    Permutation* temp = copy_permutation(perm);
+    int pos = find_position_scan(temp, t);
+    if (pos < 1 || pos >= temp->n) {
+        free_permutation(temp);
+        return 0;
+    }
+    swap(&temp->elements[pos-1], &temp->elements[pos]);
+    int result = is_identity_permutation(temp);
+    free_permutation(temp);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Timed loops
+// ---------------------------------------------------------------------------
+
+static long loop_index_to_permutation(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        Permutation* perm = index_to_permutation(pool->index[i % pool->count], pool->dimension);
+        acc += perm->elements[0];
+        free_permutation(perm);
+    }
+    return acc;
+}
+
+static long loop_index_to_permutation_direct(InputPool* pool, int iterations) {
+    int elements[MAX_DIMENSION];
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        index_to_elements_direct(pool->index[i % pool->count], pool->dimension, elements);
+        acc += elements[0];
+    }
+    return acc;
+}
+
+static long loop_permutation_to_index(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        acc += permutation_to_index(pool->perms[i % pool->count], pool->dimension);
+    }
+    return acc;
+}
+
+static long loop_permutation_to_index_direct(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        acc += permutation_to_index_direct(pool->perms[i % pool->count], pool->dimension);
+    }
+    return acc;
+}
+
+static long loop_parent1(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        int k = i % pool->count;
+        Permutation* parent = Parent1(pool->perms[k], pool->tree[k], pool->dimension);
+        acc += parent->elements[pool->dimension - 1];
+        free_permutation(parent);
+    }
+    return acc;
+}
+
+static long loop_is_swap_identity(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        int k = i % pool->count;
+        acc += is_swap_identity(pool->perms[k], pool->symbol[k]);
+    }
+    return acc;
+}
+
+static long loop_is_swap_identity_copy(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        int k = i % pool->count;
+        acc += is_swap_identity_copy(pool->perms[k], pool->symbol[k]);
+    }
+    return acc;
+}
+
+static long loop_right_position(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        acc += right_position(pool->perms[i % pool->count]);
+    }
+    return acc;
+}
+
+static long loop_find_position(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        int k = i % pool->count;
+        acc += find_position(pool->perms[k], pool->symbol[k]);
+    }
+    return acc;
+}
+
+static long loop_find_position_scan(InputPool* pool, int iterations) {
+    long acc = 0;
+    for (int i = 0; i < iterations; i++) {
+        int k = i % pool->count;
+        acc += find_position_scan(pool->perms[k], pool->symbol[k]);
+    }
+    return acc;
+}
+
+static const BenchEntry entries[] = {
+    { PRIM_INDEX_TO_PERMUTATION, "library", loop_index_to_permutation },
+    { PRIM_INDEX_TO_PERMUTATION, "direct", loop_index_to_permutation_direct },
+    { PRIM_PERMUTATION_TO_INDEX, "library", loop_permutation_to_index },
+    { PRIM_PERMUTATION_TO_INDEX, "direct", loop_permutation_to_index_direct },
+    { PRIM_PARENT1, "library", loop_parent1 },
+    { PRIM_IS_SWAP_IDENTITY, "library", loop_is_swap_identity },
+    { PRIM_IS_SWAP_IDENTITY, "copy", loop_is_swap_identity_copy },
+    { PRIM_RIGHT_POSITION, "library", loop_right_position },
+    { PRIM_FIND_POSITION, "library", loop_find_position },
+    { PRIM_FIND_POSITION, "scan", loop_find_position_scan },
+};
+#define ENTRY_COUNT ((int)(sizeof(entries) / sizeof(entries[0])))
+
+// ---------------------------------------------------------------------------
+// Input generation
+// ---------------------------------------------------------------------------
+
+// Fisher-Yates shuffle, retried until the result is not the identity
+static void shuffle_permutation(Permutation* perm) {
+    do {
+        for (int i = perm->n - 1; i > 0; i--) {
+            swap(&perm->elements[i], &perm->elements[random_below(i + 1)]);
+        }
+    } while (is_identity_permutation(perm));
+    update_inverse(perm);
+}
+
+// Build one pool entry per case of Parent1 in turn; every case but A.1.2 is
+// found by sampling, A.1.2 has the single vertex (2, 1, 3, ..., n) in tree 2
+static int fill_adversarial(InputPool* pool) {
+    int n = pool->dimension;
+    Permutation* candidate = create_permutation(n);
+    if (!candidate) return 0;
+    
+    for (int k = 0; k < pool->count; k++) {
+        ParentCase wanted = (ParentCase)(k % PARENT_CASE_COUNT);
+        
+        if (wanted == PARENT_CASE_A12) {
+            for (int i = 0; i < n; i++) candidate->elements[i] = i + 1;
+            swap(&candidate->elements[0], &candidate->elements[1]);
+            memcpy(pool->perms[k]->elements, candidate->elements, n * sizeof(int));
+            update_inverse(pool->perms[k]);
+            pool->tree[k] = 2;
+            continue;
+        }
+        
+        int found = 0;
+        for (int attempt = 0; attempt < 1000000 && !found; attempt++) {
+            shuffle_permutation(candidate);
+            
+            // Bias the tail towards the rarer cases A and B
+            if (wanted <= PARENT_CASE_B22) {
+                int tail = wanted <= PARENT_CASE_A2 ? n : n - 1;
+                swap(&candidate->elements[find_position(candidate, tail) - 1], &candidate->elements[n - 1]);
+                update_inverse(candidate);
+                if (wanted >= PARENT_CASE_B21) {
+                    swap(&candidate->elements[find_position(candidate, n) - 1], &candidate->elements[n - 2]);
+                    update_inverse(candidate);
+                }
+                if (is_identity_permutation(candidate)) continue;
+            }
+            
+            int t = 1 + random_below(n - 1);
+            if (parent1_case(candidate, t, n) == wanted) {
+                memcpy(pool->perms[k]->elements, candidate->elements, n * sizeof(int));
+                update_inverse(pool->perms[k]);
+                pool->tree[k] = t;
+                found = 1;
+            }
+        }
+        if (!found) {
+            free_permutation(candidate);
+            return 0;
+        }
+    }
+    
+    free_permutation(candidate);
+    return 1;
+}
+
+static void free_pool(InputPool* pool) {
+    for (int k = 0; k < pool->count; k++) {
+        free_permutation(pool->perms[k]);
+    }
+    pool->count = 0;
+}
+
+// Prepare the inputs of one kind for dimension n
+static int build_pool(InputPool* pool, int dimension, int input) {
+    pool->dimension = dimension;
+    pool->count = 0;
+    
+    for (int k = 0; k < POOL_SIZE; k++) {
+        pool->perms[k] = create_permutation(dimension);
+        if (!pool->perms[k]) {
+            free_pool(pool);
+            return 0;
+        }
+        pool->count++;
+    }
+    
+    if (input == INPUT_RANDOM) {
+        for (int k = 0; k < pool->count; k++) {
+            shuffle_permutation(pool->perms[k]);
+            pool->tree[k] = 1 + random_below(dimension - 1);
+        }
+    } else if (input == INPUT_SEQUENTIAL) {
+        // Vertices 1, 2, ... in index order, wrapping before the identity
+        Permutation* current = create_permutation(dimension);
+        if (!current) {
+            free_pool(pool);
+            return 0;
+        }
+        for (int k = 0; k < pool->count; k++) {
+            if (!next_permutation(current)) {
+                for (int i = 0; i < dimension; i++) current->elements[i] = i + 1;
+                update_inverse(current);
+                next_permutation(current);
+            }
+            memcpy(pool->perms[k]->elements, current->elements, dimension * sizeof(int));
+            update_inverse(pool->perms[k]);
+            pool->tree[k] = 1 + k % (dimension - 1);
+        }
+        free_permutation(current);
+    } else if (!fill_adversarial(pool)) {
+        free_pool(pool);
+        return 0;
+    }
+    
+    for (int k = 0; k < pool->count; k++) {
+        Permutation* perm = pool->perms[k];
+        if (input == INPUT_RANDOM) {
+            pool->symbol[k] = perm->elements[random_below(dimension - 1)];
+        } else if (input == INPUT_SEQUENTIAL) {
+            pool->symbol[k] = perm->elements[k % (dimension - 1)];
+        } else {
+            pool->symbol[k] = perm->elements[dimension - 2];
+        }
+        pool->index[k] = dimension <= MAX_RANK_DIMENSION ? permutation_to_index(perm, dimension) : -1;
+    }
+    
+    return 1;
+}
+
+// Check an alternative implementation against the library on the pool
+static int check_alternative(const BenchEntry* entry, InputPool* pool) {
+    int n = pool->dimension;
+    int elements[MAX_DIMENSION];
+    
+    for (int k = 0; k < pool->count; k++) {
+        Permutation* perm = pool->perms[k];
+        switch (entry->primitive) {
+            case PRIM_INDEX_TO_PERMUTATION:
+                index_to_elements_direct(pool->index[k], n, elements);
+                if (memcmp(elements, perm->elements, n * sizeof(int)) != 0) return 0;
+                break;
+            case PRIM_PERMUTATION_TO_INDEX:
+                if (permutation_to_index_direct(perm, n) != pool->index[k]) return 0;
+                break;
+            case PRIM_IS_SWAP_IDENTITY:
+                if (is_swap_identity_copy(perm, pool->symbol[k]) != is_swap_identity(perm, pool->symbol[k])) return 0;
+                break;
+            case PRIM_FIND_POSITION:
+                if (find_position_scan(perm, pool->symbol[k]) != find_position(perm, pool->symbol[k])) return 0;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Parent kernels
+// ---------------------------------------------------------------------------
+
+static IndependentSpanningTrees* alloc_kernel_trees(int dimension, int vertices) {
+    IndependentSpanningTrees* ists = (IndependentSpanningTrees*)malloc(sizeof(IndependentSpanningTrees));
+    if (!ists) return NULL;
+    
+    ists->tree_count = dimension - 1;
+    ists->trees = (SpanningTree*)calloc(dimension - 1, sizeof(SpanningTree));
+    if (!ists->trees) {
+        free(ists);
+        return NULL;
+    }
+    
+    for (int t = 0; t < dimension - 1; t++) {
+        ists->trees[t].vertex_count = vertices;
+        ists->trees[t].parent = (int*)malloc(vertices * sizeof(int));
+        if (!ists->trees[t].parent) {
+            free_ists(ists);
+            return NULL;
+        }
+        for (int v = 0; v < vertices; v++) {
+            ists->trees[t].parent[v] = -1;
+        }
+    }
+    return ists;
+}
+
+// Run kernel over at least iterations vertices; returns the vertices done
+static long run_kernel(ParentKernel kernel, IndependentSpanningTrees* ists, int vertices,
+                       int input, int iterations) {
+    long done = 0;
+    while (done < iterations) {
+        if (input == INPUT_SEQUENTIAL || vertices <= KERNEL_RUN) {
+            kernel(ists, 0, vertices, NULL);
+            done += vertices;
+        } else {
+            int start = random_below(vertices - KERNEL_RUN + 1);
+            kernel(ists, start, start + KERNEL_RUN, NULL);
+            done += KERNEL_RUN;
+        }
+    }
+    return done;
+}
+
+// Time one kernel and return the median and minimum ns per vertex
+static void time_kernel(ParentKernel kernel, IndependentSpanningTrees* ists, int vertices,
+                        int input, int iterations, int repeat, double* median, double* min) {
+    double samples[MAX_REPEAT];
+    
+    run_kernel(kernel, ists, vertices, input, vertices);
+    for (int r = 0; r < repeat; r++) {
+        double start = measure_time();
+        long done = run_kernel(kernel, ists, vertices, input, iterations);
+        samples[r] = (measure_time() - start) * 1e9 / done;
+    }
+    
+    qsort(samples, repeat, sizeof(double), compare_doubles);
+    *median = repeat % 2 ? samples[repeat / 2] : 0.5 * (samples[repeat / 2 - 1] + samples[repeat / 2]);
+    *min = samples[0];
+}
+
+// Check the specialized kernel against the generic one on the whole range
+static int check_kernel(ParentKernel kernel, int dimension, int vertices) {
+    IndependentSpanningTrees* generic = alloc_kernel_trees(dimension, vertices);
+    IndependentSpanningTrees* specialized = alloc_kernel_trees(dimension, vertices);
+    int ok = generic && specialized;
+    
+    if (ok) {
+        generic_parent_kernel(generic, 0, vertices, NULL);
+        kernel(specialized, 0, vertices, NULL);
+        for (int t = 0; t < dimension - 1 && ok; t++) {
+            ok = memcmp(generic->trees[t].parent, specialized->trees[t].parent, vertices * sizeof(int)) == 0;
+        }
+    }
+    
+    free_ists(generic);
+    free_ists(specialized);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+
+// Run one loop repeat times and return the median and minimum ns/op
+static void time_loop(const BenchEntry* entry, InputPool* pool, int iterations, int repeat,
+                      double* median, double* min) {
+    double samples[MAX_REPEAT];
+    
+    sink += entry->loop(pool, iterations < POOL_SIZE ? iterations : POOL_SIZE);
+    for (int r = 0; r < repeat; r++) {
+        double start = measure_time();
+        sink += entry->loop(pool, iterations);
+        samples[r] = (measure_time() - start) * 1e9 / iterations;
+    }
+    
+    qsort(samples, repeat, sizeof(double), compare_doubles);
+    *median = repeat % 2 ? samples[repeat / 2] : 0.5 * (samples[repeat / 2 - 1] + samples[repeat / 2]);
+    *min = samples[0];
+}
+
+// Parse "4-16", "4,8,12" or a mix such as "4,6-8"
+static int parse_int_list(const char* text, IntList* list) {
+    list->count = 0;
+    const char* p = text;
+    
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p) return 0;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1) return 0;
+            p = end;
+        }
+        for (long v = first; v <= last; v++) {
+            if (list->count == MAX_SWEEP) return 0;
+            list->values[list->count++] = (int)v;
+        }
+        if (*p == ',') p++;
+        else if (*p) return 0;
+    }
+    
+    return list->count > 0;
+}
+
+// Parse a comma-separated list of names into flags
+static int parse_names(const char* text, const char** names, int count, int* enabled) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (int i = 0; i < count; i++) enabled[i] = 0;
+    
+    for (char* name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+        int matched = 0;
+        for (int i = 0; i < count; i++) {
+            if (strcmp(name, names[i]) == 0) {
+                enabled[i] = 1;
+                matched = 1;
+            }
+        }
+        if (!matched) return 0;
+    }
+    
+    return 1;
+}
+
+// Print one result line and append it to the CSV file if there is one
+static void report(FILE* csv, int primitive, const char* implementation, int dimension, int input,
+                   int iterations, int repeat, double median, double min) {
+    double ops = median > 0 ? 1e9 / median : 0.0;
+    
+    printf("%-22s %-11s %3d %-12s %10.2f %10.2f %14.0f\n", primitive_names[primitive], implementation,
+           dimension, input_names[input], median, min, ops);
+    if (csv) {
+        fprintf(csv, "%s,%s,%d,%s,%d,%d,%.3f,%.3f,%.0f\n", primitive_names[primitive], implementation,
+                dimension, input_names[input], iterations, repeat, median, min, ops);
+    }
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --dims LIST         Dimensions to run, e.g. 4-16 or 4,8,12 (default 4-16)\n");
+    printf("  --primitives LIST   Comma-separated subset of the primitives (default all)\n");
+    printf("  --inputs LIST       random,sequential,adversarial (default all)\n");
+    printf("  --iterations N      Operations per timed run (default 200000)\n");
+    printf("  --repeat N          Timed runs per measurement, median reported (default 5)\n");
+    printf("  --compare           Also time the allocation-free alternatives\n");
+    printf("  --seed N            Seed for the random inputs\n");
+    printf("  --csv FILE          Append results to a CSV file\n");
+}
+
+int main(int argc, char* argv[]) {
+    IntList dims;
+    parse_int_list("4-16", &dims);
+    int primitives[PRIM_COUNT];
+    int inputs[INPUT_COUNT];
+    for (int p = 0; p < PRIM_COUNT; p++) primitives[p] = 1;
+    for (int i = 0; i < INPUT_COUNT; i++) inputs[i] = 1;
+    int iterations = 200000;
+    int repeat = 5;
+    int compare = 0;
+    const char* csv_path = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        int ok = 1;
+        if (strcmp(argv[i], "--dims") == 0 && i + 1 < argc) {
+            ok = parse_int_list(argv[++i], &dims);
+        } else if (strcmp(argv[i], "--primitives") == 0 && i + 1 < argc) {
+            ok = parse_names(argv[++i], primitive_names, PRIM_COUNT, primitives);
+        } else if (strcmp(argv[i], "--inputs") == 0 && i + 1 < argc) {
+            ok = parse_names(argv[++i], input_names, INPUT_COUNT, inputs);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+            ok = iterations > 0;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+            ok = repeat > 0 && repeat <= MAX_REPEAT;
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rng_state = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            ok = 0;
+        }
+        if (!ok) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    for (int d = 0; d < dims.count; d++) {
+        if (dims.values[d] < 4 || dims.values[d] > MAX_DIMENSION) {
+            printf("Error: dimensions must be between 4 and %d\n", MAX_DIMENSION);
+            return 1;
+        }
+    }
+    
+    FILE* csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "a");
+        if (!csv) {
+            printf("Error: cannot open %s\n", csv_path);
+            return 1;
+        }
+        if (ftell(csv) == 0) {
+            fprintf(csv, "primitive,implementation,dimension,input,iterations,repeat,ns_per_op_median,ns_per_op_min,ops_per_sec\n");
+        }
+    }
+    
+    printf("%-22s %-11s %3s %-12s %10s %10s %14s\n",
+           "primitive", "impl", "n", "input", "ns/op", "min ns/op", "ops/s");
+    
+    InputPool* pool = (InputPool*)malloc(sizeof(InputPool));
+    if (!pool) {
+        printf("Error: cannot allocate input pool\n");
+        if (csv) fclose(csv);
+        return 1;
+    }
+    
+    BatchISA host_isa = batch_kernel_isa();
+    int status = 0;
+    for (int d = 0; d < dims.count && status == 0; d++) {
+        int n = dims.values[d];
+        
+        for (int input = 0; input < INPUT_COUNT && status == 0; input++) {
+            if (!inputs[input]) continue;
+            if (!build_pool(pool, n, input)) {
+                printf("Error: cannot build %s inputs for n=%d\n", input_names[input], n);
+                status = 1;
+                break;
+            }
+            
+            for (int e = 0; e < ENTRY_COUNT && status == 0; e++) {
+                const BenchEntry* entry = &entries[e];
+                int is_library = strcmp(entry->implementation, "library") == 0;
+                if (!primitives[entry->primitive] || (!is_library && !compare)) continue;
+                if ((entry->primitive == PRIM_INDEX_TO_PERMUTATION ||
+                     entry->primitive == PRIM_PERMUTATION_TO_INDEX) && n > MAX_RANK_DIMENSION) continue;
+                
+                if (!is_library && !check_alternative(entry, pool)) {
+                    printf("Error: %s/%s disagrees with the library for n=%d\n",
+                           primitive_names[entry->primitive], entry->implementation, n);
+                    status = 1;
+                    break;
+                }
+                
+                double median, min;
+                time_loop(entry, pool, iterations, repeat, &median, &min);
+                report(csv, entry->primitive, entry->implementation, n, input, iterations, repeat, median, min);
+            }
+            free_pool(pool);
+            
+            // Kernels work on ranges of vertex indices, there is no adversarial order
+            if (!primitives[PRIM_PARENT_KERNEL] || input == INPUT_ADVERSARIAL ||
+                n > MAX_RANK_DIMENSION || status != 0) continue;
+            
+            int vertices = factorial(n) < KERNEL_RANGE ? factorial(n) : KERNEL_RANGE;
+            if (parent_kernel_is_specialized(n) && !check_kernel(select_scalar_parent_kernel(n), n, vertices)) {
+                printf("Error: specialized kernel disagrees with the generic kernel for n=%d\n", n);
+                status = 1;
+                break;
+            }
+            for (int isa = 0; isa <= (int)host_isa && parent_kernel_is_specialized(n) && status == 0; isa++) {
+                if (!check_kernel(select_batch_parent_kernel(n, (BatchISA)isa), n, vertices)) {
+                    printf("Error: %s batch kernel disagrees with the generic kernel for n=%d\n",
+                           batch_isa_name((BatchISA)isa), n);
+                    status = 1;
+                }
+            }
+            if (status != 0) break;
+            
+            IndependentSpanningTrees* ists = alloc_kernel_trees(n, vertices);
+            if (!ists) {
+                printf("Error: cannot allocate kernel output for n=%d\n", n);
+                status = 1;
+                break;
+            }
+            
+            double median, min;
+            time_kernel(generic_parent_kernel, ists, vertices, input, iterations, repeat, &median, &min);
+            report(csv, PRIM_PARENT_KERNEL, "generic", n, input, iterations, repeat, median, min);
+            if (parent_kernel_is_specialized(n)) {
+                double generic_median = median;
+                time_kernel(runtime_parent_kernel, ists, vertices, input, iterations, repeat, &median, &min);
+                report(csv, PRIM_PARENT_KERNEL, "runtime-n", n, input, iterations, repeat, median, min);
+                time_kernel(select_scalar_parent_kernel(n), ists, vertices, input, iterations, repeat,
+                            &median, &min);
+                report(csv, PRIM_PARENT_KERNEL, "specialized", n, input, iterations, repeat, median, min);
+                printf("%-22s %-11s %3d %-12s %9.2fx\n", "", "speedup", n, input_names[input],
+                       median > 0 ? generic_median / median : 0.0);
+                
+                // Batch kernels, with the speedup over the scalar specialized kernel
+                double scalar_median = median;
+                for (int isa = 0; isa <= (int)host_isa; isa++) {
+                    char name[16];
+                    snprintf(name, sizeof(name), "simd-%s", batch_isa_name((BatchISA)isa));
+                    time_kernel(select_batch_parent_kernel(n, (BatchISA)isa), ists, vertices, input,
+                                iterations, repeat, &median, &min);
+                    report(csv, PRIM_PARENT_KERNEL, name, n, input, iterations, repeat, median, min);
+                    printf("%-22s %-11s %3d %-12s %9.2fx\n", "", "speedup", n, input_names[input],
+                           median > 0 ? scalar_median / median : 0.0);
+                }
+            }
+            free_ists(ists);
+        }
+    }
+    
+    if (dims.values[dims.count - 1] > MAX_RANK_DIMENSION) {
+        printf("(index_to_permutation, permutation_to_index and parent_kernel are limited to n <= %d)\n",
+               MAX_RANK_DIMENSION);
+    }
+    
+    free(pool);
+    if (csv) fclose(csv);
+    return status;
+}
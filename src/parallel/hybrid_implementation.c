@@ -1,68 +1,132 @@
 #include "bubble_sort_network.h"
 #include "ist_algorithm.h"
 #include "utils.h"
+#include "ist_checkpoint.h"
+#include "ist_timeline.h"
+#include "ist_kernels.h"
+#include "ist_shared.h"
+#include "ist_digest.h"
 #include <mpi.h>
 #include <omp.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+// Vertices handed to a thread at a time; each thread writes disjoint
+// entries of the parent arrays, so no synchronization is needed
+#define HYBRID_BLOCK 256
+
+// Compute the parents of vertices [start_vertex, end_vertex) with OpenMP threads
+static void hybrid_compute_range(ParentKernel kernel, IndependentSpanningTrees* ists,
+                                 int start_vertex, int end_vertex) {
+    int blocks = (end_vertex - start_vertex + HYBRID_BLOCK - 1) / HYBRID_BLOCK;
+    int timed = timeline_enabled();
+    
+    // Process blocks of vertices with OpenMP parallelism
+    #pragma omp parallel
+    {
+        // Per-thread split of the time between unranking and parent computation
+        KernelTimes times = { 0.0, 0.0 };
+        double chunk_start = timed ? timeline_now() : 0.0;
+        int vertices = 0;
+        
+        #pragma omp for schedule(static) nowait
+        for (int b = 0; b < blocks; b++) {
+            int start = start_vertex + b * HYBRID_BLOCK;
+            int end = end_vertex - start < HYBRID_BLOCK ? end_vertex : start + HYBRID_BLOCK;
+            kernel(ists, start, end, timed ? &times : NULL);
+            vertices += end - start;
+        }
+        
+        // Recorded before the implicit barrier so waiting threads show up as gaps
+        if (timed) {
+            timeline_compute_span(chunk_start, timeline_now(), vertices, times.unrank, times.parent);
+        }
+    }
+}
+
 // Construct independent spanning trees using hybrid MPI+OpenMP approach
 void construct_hybrid_ists(BubbleSortNetwork* network, IndependentSpanningTrees* ists) {
+    construct_hybrid_ists_with_options(network, ists, NULL);
+}
+
+// Construct independent spanning trees using hybrid MPI+OpenMP approach with the given options
+void construct_hybrid_ists_with_options(BubbleSortNetwork* network, IndependentSpanningTrees* ists,
+                                        const ParallelOptions* options) {
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     
-    int n = network->dimension;
     int vertex_count = network->vertex_count;
+    ParentKernel kernel = select_parent_kernel(network->dimension);
     
-    // Calculate the portion of vertices each process will handle
-    int vertices_per_proc = vertex_count / size;
-    int remainder = vertex_count % size;
+    // Claim chunks dynamically instead of the fixed split
+    if (options && options->chunk_size > 0) {
+        double compute = 0.0;
+        double start = MPI_Wtime();
+        int taken = compute_dynamic_chunks(network, ists, options->chunk_size, options->placement,
+                                           hybrid_compute_range, kernel, &compute, options->digest);
+        if (options->chunks_taken) *options->chunks_taken = taken;
+        if (options->times) {
+            options->times->compute = compute;
+            options->times->exchange = MPI_Wtime() - start - compute;
+        }
+        return;
+    }
     
     // Calculate start and end vertices for this process
-    int start_vertex = rank * vertices_per_proc + (rank < remainder ? rank : remainder);
-    int end_vertex = start_vertex + vertices_per_proc + (rank < remainder ? 1 : 0);
+    int start_vertex, end_vertex;
+    if (options && options->shared) {
+        shared_vertex_range(options->shared, &start_vertex, &end_vertex);
+    } else {
+        vertex_range(vertex_count, rank, size, &start_vertex, &end_vertex);
+    }
     
-    // Process each vertex in the local range with OpenMP parallelism
-    #pragma omp parallel
-    {
-        #pragma omp for collapse(2)
-        for (int v = start_vertex; v < end_vertex; v++) {
-            for (int t = 0; t < n - 1; t++) {
-                Permutation* perm = index_to_permutation(v, n);
-                
-                // Skip the root (identity permutation)
-                if (is_identity_permutation(perm)) {
-                    free_permutation(perm);
-                    continue;
-                }
-                
-                // Determine parent in the tree
-                Permutation* parent = Parent1(perm, t + 1, n); // t+1 because tree indices start at 1
-                int parent_index = permutation_to_index(parent, n);
-                
-                #pragma omp critical
-                {
-                    ists->trees[t].parent[v] = parent_index;
-                }
-                
-                free_permutation(parent);
-                free_permutation(perm);
-            }
-        }
+    double compute_start = MPI_Wtime();
+    
+    // Process the local range, skipping checkpointed ranges
+    if (options && options->checkpoint) {
+        compute_with_checkpoints(options->checkpoint, ists, start_vertex, end_vertex,
+                                 hybrid_compute_range, kernel);
+    } else {
+        hybrid_compute_range(kernel, ists, start_vertex, end_vertex);
     }
     
-    // Gather all results to all processes
-    for (int t = 0; t < n - 1; t++) {
-        MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
-                     ists->trees[t].parent, vertex_count, MPI_INT, MPI_COMM_WORLD);
+    // Digest the local range while it is still the only one in place
+    if (options && options->digest) {
+        *options->digest = digest_ists_range(ists, start_vertex, end_vertex);
+    }
+    
+    double exchange_start = MPI_Wtime();
+    
+    // Gather the results where the placement wants them; shared trees only
+    // travel between node leaders
+    ResultPlacement placement = options ? options->placement : PLACEMENT_ALL;
+    if (options && options->shared) {
+        exchange_shared_ists(options->shared, placement);
+    } else {
+        exchange_ists(ists, vertex_count, placement);
+    }
+    
+    if (options && options->times) {
+        options->times->compute = exchange_start - compute_start;
+        options->times->exchange = MPI_Wtime() - exchange_start;
     }
 }
 
 // Function to handle the hybrid MPI+OpenMP process for IST construction
 IndependentSpanningTrees* hybrid_construct_ists(BubbleSortNetwork* network) {
+    return hybrid_construct_ists_with_options(network, NULL);
+}
+
+// Function to handle the hybrid MPI+OpenMP process with the given options
+IndependentSpanningTrees* hybrid_construct_ists_with_options(BubbleSortNetwork* network,
+                                                             const ParallelOptions* options) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
     int n = network->dimension;
     int vertex_count = network->vertex_count;
+    int replicated = holds_all_trees(options, rank);
     
     // Allocate memory for the ISTs
     IndependentSpanningTrees* ists = (IndependentSpanningTrees*)malloc(sizeof(IndependentSpanningTrees));
@@ -88,14 +152,16 @@ IndependentSpanningTrees* hybrid_construct_ists(BubbleSortNetwork* network) {
             return NULL;
         }
         
-        // Initialize parent pointers to -1
-        for (int v = 0; v < vertex_count; v++) {
+        // Initialize parent pointers to -1; a rank that only keeps its own
+        // vertices never touches the rest, so those pages are not mapped
+        ists->trees[t].parent[0] = -1;
+        for (int v = 1; replicated && v < vertex_count; v++) {
             ists->trees[t].parent[v] = -1;
         }
     }
     
     // Construct the trees using hybrid parallelism
-    construct_hybrid_ists(network, ists);
+    construct_hybrid_ists_with_options(network, ists, options);
     
     return ists;
 }
\ No newline at end of file
@@ -1,59 +1,294 @@
 #include "bubble_sort_network.h"
 #include "ist_algorithm.h"
 #include "utils.h"
+#include "ist_checkpoint.h"
+#include "ist_timeline.h"
+#include "ist_kernels.h"
+#include "ist_shared.h"
+#include "ist_digest.h"
 #include <mpi.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-// Construct independent spanning trees in parallel using MPI
-void construct_parallel_ists_mpi(BubbleSortNetwork* network, IndependentSpanningTrees* ists) {
+// Range of vertices [start, end) handled by a rank in the contiguous split
+void vertex_range(int vertex_count, int rank, int size, int* start, int* end) {
+    int vertices_per_proc = vertex_count / size;
+    int remainder = vertex_count % size;
+    
+    *start = rank * vertices_per_proc + (rank < remainder ? rank : remainder);
+    *end = *start + vertices_per_proc + (rank < remainder ? 1 : 0);
+}
+
+// Gather every rank's range of each tree so that all ranks hold all trees
+void allgather_ists(IndependentSpanningTrees* ists, int vertex_count) {
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    int* counts = (int*)malloc(size * sizeof(int));
+    int* displs = (int*)malloc(size * sizeof(int));
+    for (int r = 0; r < size; r++) {
+        int start, end;
+        vertex_range(vertex_count, r, size, &start, &end);
+        counts[r] = end - start;
+        displs[r] = start;
+    }
+    
+    double span_start = timeline_now();
+    for (int t = 0; t < ists->tree_count; t++) {
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                       ists->trees[t].parent, counts, displs, MPI_INT, MPI_COMM_WORLD);
+    }
+    timeline_span(SPAN_ALLGATHER, span_start, timeline_now());
+    
+    free(counts);
+    free(displs);
+}
+
+// Gather every rank's range of each tree on rank 0 only
+void gather_ists_to_root(IndependentSpanningTrees* ists, int vertex_count) {
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     
-    int n = network->dimension;
-    int vertex_count = network->vertex_count;
+    int* counts = (int*)malloc(size * sizeof(int));
+    int* displs = (int*)malloc(size * sizeof(int));
+    for (int r = 0; r < size; r++) {
+        int start, end;
+        vertex_range(vertex_count, r, size, &start, &end);
+        counts[r] = end - start;
+        displs[r] = start;
+    }
     
-    // Calculate the portion of vertices each process will handle
-    int vertices_per_proc = vertex_count / size;
-    int remainder = vertex_count % size;
+    double span_start = timeline_now();
+    for (int t = 0; t < ists->tree_count; t++) {
+        if (rank == 0) {
+            MPI_Gatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                        ists->trees[t].parent, counts, displs, MPI_INT, 0, MPI_COMM_WORLD);
+        } else {
+            MPI_Gatherv(ists->trees[t].parent + displs[rank], counts[rank], MPI_INT,
+                        NULL, NULL, NULL, MPI_INT, 0, MPI_COMM_WORLD);
+        }
+    }
+    timeline_span(SPAN_ALLGATHER, span_start, timeline_now());
     
-    // Calculate start and end vertices for this process
-    int start_vertex = rank * vertices_per_proc + (rank < remainder ? rank : remainder);
-    int end_vertex = start_vertex + vertices_per_proc + (rank < remainder ? 1 : 0);
+    free(counts);
+    free(displs);
+}
+
+// Exchange the ranges of the contiguous split according to placement
+void exchange_ists(IndependentSpanningTrees* ists, int vertex_count, ResultPlacement placement) {
+    if (placement == PLACEMENT_ALL) {
+        allgather_ists(ists, vertex_count);
+    } else if (placement == PLACEMENT_ROOT) {
+        gather_ists_to_root(ists, vertex_count);
+    }
+}
+
+// Exchange the chunks of every tree according to placement. Each rank's
+// chunks are described by one indexed datatype built from the owner table;
+// every rank broadcasts its chunks in place, or sends them to rank 0 only.
+static void exchange_chunks(IndependentSpanningTrees* ists, int vertex_count, int chunk_size,
+                            const int* owner, int chunk_count, ResultPlacement placement) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (placement == PLACEMENT_DISTRIBUTED) return;
     
-    // Process each vertex in the local range
-    for (int v = start_vertex; v < end_vertex; v++) {
-        Permutation* perm = index_to_permutation(v, n);
-        
-        // Skip the root (identity permutation)
-        if (is_identity_permutation(perm)) {
-            free_permutation(perm);
-            continue;
+    int* lengths = (int*)malloc(chunk_count * sizeof(int));
+    int* displs = (int*)malloc(chunk_count * sizeof(int));
+    
+    double span_start = timeline_now();
+    for (int r = 0; r < size; r++) {
+        int count = 0;
+        for (int c = 0; c < chunk_count; c++) {
+            if (owner[c] != r) continue;
+            displs[count] = c * chunk_size;
+            lengths[count] = vertex_count - displs[count] < chunk_size ? vertex_count - displs[count] : chunk_size;
+            count++;
         }
+        if (count == 0) continue;
         
-        // Determine parent in each tree
-        for (int t = 0; t < n - 1; t++) {
-            Permutation* parent = Parent1(perm, t + 1, n); // t+1 because tree indices start at 1
-            int parent_index = permutation_to_index(parent, n);
-            ists->trees[t].parent[v] = parent_index;
-            free_permutation(parent);
+        MPI_Datatype chunks;
+        MPI_Type_indexed(count, lengths, displs, MPI_INT, &chunks);
+        MPI_Type_commit(&chunks);
+        for (int t = 0; t < ists->tree_count; t++) {
+            if (placement == PLACEMENT_ALL) {
+                MPI_Bcast(ists->trees[t].parent, 1, chunks, r, MPI_COMM_WORLD);
+            } else if (r != 0 && rank == r) {
+                MPI_Send(ists->trees[t].parent, 1, chunks, 0, t, MPI_COMM_WORLD);
+            } else if (r != 0 && rank == 0) {
+                MPI_Recv(ists->trees[t].parent, 1, chunks, r, t, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            }
         }
+        MPI_Type_free(&chunks);
+    }
+    timeline_span(SPAN_ALLGATHER, span_start, timeline_now());
+    
+    free(lengths);
+    free(displs);
+}
+
+// Compute chunks of chunk_size vertices claimed from a counter on rank 0
+// until none are left, then exchange them according to placement
+// compute_time is set to the seconds spent before the exchange, and digest
+// (if not NULL) to the digest of the chunks this rank computed
+// Returns the number of chunks this rank computed
+int compute_dynamic_chunks(BubbleSortNetwork* network, IndependentSpanningTrees* ists, int chunk_size,
+                           ResultPlacement placement, RangeKernel compute_range, ParentKernel kernel,
+                           double* compute_time, uint64_t* digest) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    int vertex_count = network->vertex_count;
+    int chunk_count = (vertex_count + chunk_size - 1) / chunk_size;
+    double compute_start = MPI_Wtime();
+    
+    // The next unclaimed chunk lives on rank 0
+    int* counter;
+    MPI_Win window;
+    MPI_Win_allocate(rank == 0 ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD,
+                     &counter, &window);
+    
+    // Set the counter inside the passive epoch, then make it visible to every
+    // rank before the first fetch
+    MPI_Win_lock_all(0, window);
+    if (rank == 0) *counter = 0;
+    MPI_Win_sync(window);
+    MPI_Barrier(MPI_COMM_WORLD);
+    
+    // owner[c] is the rank that computed chunk c, -1 until combined
+    int* owner = (int*)malloc(chunk_count * sizeof(int));
+    for (int c = 0; c < chunk_count; c++) {
+        owner[c] = -1;
+    }
+    
+    int taken = 0;
+    const int one = 1;
+    if (digest) *digest = 0;
+    for (;;) {
+        int chunk;
+        MPI_Fetch_and_op(&one, &chunk, MPI_INT, 0, 0, MPI_SUM, window);
+        MPI_Win_flush(0, window);
+        if (chunk >= chunk_count) break;
         
-        free_permutation(perm);
+        int start = chunk * chunk_size;
+        int end = vertex_count - start < chunk_size ? vertex_count : start + chunk_size;
+        compute_range(kernel, ists, start, end);
+        if (digest) *digest += digest_ists_range(ists, start, end);
+        owner[chunk] = rank;
+        taken++;
     }
+    MPI_Win_unlock_all(window);
+    MPI_Win_free(&window);
     
-    // Gather all results to all processes
-    for (int t = 0; t < n - 1; t++) {
-        MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
-                     ists->trees[t].parent, vertex_count, MPI_INT, MPI_COMM_WORLD);
+    if (compute_time) *compute_time = MPI_Wtime() - compute_start;
+    
+    // Every chunk has exactly one owner, so the maximum is the owner table
+    MPI_Allreduce(MPI_IN_PLACE, owner, chunk_count, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    exchange_chunks(ists, vertex_count, chunk_size, owner, chunk_count, placement);
+    
+    free(owner);
+    return taken;
+}
+
+// Compute the parents of vertices [start_vertex, end_vertex) in every tree
+static void mpi_compute_range(ParentKernel kernel, IndependentSpanningTrees* ists,
+                              int start_vertex, int end_vertex) {
+    // Split the time between unranking and parent computation if a timeline is recorded
+    if (timeline_enabled()) {
+        KernelTimes times = { 0.0, 0.0 };
+        double chunk_start = timeline_now();
+        kernel(ists, start_vertex, end_vertex, &times);
+        timeline_compute_span(chunk_start, timeline_now(), end_vertex - start_vertex,
+                              times.unrank, times.parent);
+    } else {
+        kernel(ists, start_vertex, end_vertex, NULL);
+    }
+}
+
+// Construct independent spanning trees in parallel using MPI
+void construct_parallel_ists_mpi(BubbleSortNetwork* network, IndependentSpanningTrees* ists) {
+    construct_parallel_ists_mpi_with_options(network, ists, NULL);
+}
+
+// Construct independent spanning trees in parallel using MPI with the given options
+void construct_parallel_ists_mpi_with_options(BubbleSortNetwork* network, IndependentSpanningTrees* ists,
+                                              const ParallelOptions* options) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    int vertex_count = network->vertex_count;
+    ParentKernel kernel = select_parent_kernel(network->dimension);
+    
+    // Claim chunks dynamically instead of the fixed split
+    if (options && options->chunk_size > 0) {
+        double compute = 0.0;
+        double start = MPI_Wtime();
+        int taken = compute_dynamic_chunks(network, ists, options->chunk_size, options->placement,
+                                           mpi_compute_range, kernel, &compute, options->digest);
+        if (options->chunks_taken) *options->chunks_taken = taken;
+        if (options->times) {
+            options->times->compute = compute;
+            options->times->exchange = MPI_Wtime() - start - compute;
+        }
+        return;
+    }
+    
+    // Calculate start and end vertices for this process
+    int start_vertex, end_vertex;
+    if (options && options->shared) {
+        shared_vertex_range(options->shared, &start_vertex, &end_vertex);
+    } else {
+        vertex_range(vertex_count, rank, size, &start_vertex, &end_vertex);
+    }
+    
+    double compute_start = MPI_Wtime();
+    
+    // Process each vertex in the local range, skipping checkpointed ranges
+    if (options && options->checkpoint) {
+        compute_with_checkpoints(options->checkpoint, ists, start_vertex, end_vertex,
+                                 mpi_compute_range, kernel);
+    } else {
+        mpi_compute_range(kernel, ists, start_vertex, end_vertex);
+    }
+    
+    // Digest the local range while it is still the only one in place
+    if (options && options->digest) {
+        *options->digest = digest_ists_range(ists, start_vertex, end_vertex);
+    }
+    
+    double exchange_start = MPI_Wtime();
+    
+    // Gather the results where the placement wants them; shared trees only
+    // travel between node leaders
+    ResultPlacement placement = options ? options->placement : PLACEMENT_ALL;
+    if (options && options->shared) {
+        exchange_shared_ists(options->shared, placement);
+    } else {
+        exchange_ists(ists, vertex_count, placement);
+    }
+    
+    if (options && options->times) {
+        options->times->compute = exchange_start - compute_start;
+        options->times->exchange = MPI_Wtime() - exchange_start;
     }
 }
 
 // Function to handle the MPI process for IST construction
 IndependentSpanningTrees* mpi_construct_ists(BubbleSortNetwork* network) {
+    return mpi_construct_ists_with_options(network, NULL);
+}
+
+// Function to handle the MPI process for IST construction with the given options
+IndependentSpanningTrees* mpi_construct_ists_with_options(BubbleSortNetwork* network,
+                                                          const ParallelOptions* options) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
     int n = network->dimension;
     int vertex_count = network->vertex_count;
+    int replicated = holds_all_trees(options, rank);
     
     // Allocate memory for the ISTs
     IndependentSpanningTrees* ists = (IndependentSpanningTrees*)malloc(sizeof(IndependentSpanningTrees));
@@ -79,14 +314,16 @@ IndependentSpanningTrees* mpi_construct_ists(BubbleSortNetwork* network) {
             return NULL;
         }
         
-        // Initialize parent pointers to -1
-        for (int v = 0; v < vertex_count; v++) {
+        // Initialize parent pointers to -1; a rank that only keeps its own
+        // vertices never touches the rest, so those pages are not mapped
+        ists->trees[t].parent[0] = -1;
+        for (int v = 1; replicated && v < vertex_count; v++) {
             ists->trees[t].parent[v] = -1;
         }
     }
     
     // Construct the trees in parallel
-    construct_parallel_ists_mpi(network, ists);
+    construct_parallel_ists_mpi_with_options(network, ists, options);
     
     return ists;
 }
\ No newline at end of file
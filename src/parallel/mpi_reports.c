@@ -0,0 +1,173 @@
+#include "ist_algorithm.h"
+#include "ist_memory.h"
+#include "ist_profile.h"
+#include "ist_timeline.h"
+#include "ist_digest.h"
+#include <mpi.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Print the chunks each rank took and its compute time on rank 0
+void report_chunk_counts(int chunks, double compute_time) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    double local[2] = { chunks, compute_time };
+    double* all = rank == 0 ? (double*)malloc(2 * size * sizeof(double)) : NULL;
+    MPI_Gather(local, 2, MPI_DOUBLE, all, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    
+    if (rank == 0 && all) {
+        double total = 0.0;
+        for (int r = 0; r < size; r++) {
+            total += all[2 * r];
+        }
+        
+        printf("\nDynamic chunks per rank:\n");
+        printf("  rank    chunks   share   compute (s)\n");
+        for (int r = 0; r < size; r++) {
+            printf("  %4d  %8d  %5.1f%%  %12.6f\n", r, (int)all[2 * r],
+                   total > 0 ? 100.0 * all[2 * r] / total : 0.0, all[2 * r + 1]);
+        }
+    }
+    free(all);
+}
+
+// Sum the estimates over the ranks of each node, compare the sums with the
+// memory available on the node (limit if not 0) and agree on one mode: the
+// leanest mode any node needs. plan->local stays per rank; the rest of the
+// plan describes this rank's node, and plan->fits is 0 if any node is short
+void reduce_memory_plan(MemoryPlan* plan, StorageMode requested, uint64_t limit) {
+    MPI_Comm node;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+    MPI_Comm_size(node, &plan->ranks);
+    MPI_Allreduce(plan->local, plan->bytes, STORAGE_COUNT, MPI_UINT64_T, MPI_SUM, node);
+    MPI_Comm_free(&node);
+    
+    // A mode is possible only if it is possible on every rank
+    MPI_Allreduce(MPI_IN_PLACE, plan->possible, STORAGE_COUNT, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    
+    plan->available = limit > 0 ? limit : available_memory();
+    if (plan->available == 0) plan->available = UINT64_MAX;
+    choose_storage_mode(plan, requested);
+    
+    int mode = plan->mode;
+    MPI_Allreduce(MPI_IN_PLACE, &mode, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    choose_storage_mode(plan, (StorageMode)mode);
+    MPI_Allreduce(MPI_IN_PLACE, &plan->fits, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+}
+
+// Print the largest peak RSS of any rank next to the largest estimate
+void reduce_peak_rss(const MemoryPlan* plan) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    uint64_t local[2] = { peak_rss(), plan->baseline + plan->local[plan->mode] };
+    uint64_t largest[2];
+    MPI_Reduce(local, largest, 2, MPI_UINT64_T, MPI_MAX, 0, MPI_COMM_WORLD);
+    
+    if (rank == 0) {
+        printf("\nPeak RSS %.1f MiB on the largest rank (estimated %.1f MiB in %s mode)\n",
+               largest[0] / (1024.0 * 1024.0), largest[1] / (1024.0 * 1024.0), storage_mode_name(plan->mode));
+    }
+}
+
+// Sum the Parent1 counters of all threads and ranks
+// On rank 0 totals and threads hold the sums over the job afterwards
+void reduce_profile_counts(uint64_t* totals, int* threads) {
+    uint64_t local[IST_PROFILE_COUNTERS];
+    int local_threads = ist_profile_collect(local);
+    
+    MPI_Reduce(local, totals, IST_PROFILE_COUNTERS, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&local_threads, threads, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+}
+
+// Sum the digests of the vertices each rank computed
+// Returns the digest of all trees on rank 0
+uint64_t reduce_digest(uint64_t local) {
+    uint64_t digest = 0;
+    MPI_Reduce(&local, &digest, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    return digest;
+}
+
+// Gather the timelines of all ranks on rank 0, which prints the statistics
+// and, if trace_path is set, writes a Chrome trace of the whole job
+void timeline_report(const char* trace_path) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    TimelineWorker* workers = NULL;
+    TimelineSpan* spans = NULL;
+    int worker_count = 0;
+    int span_count = 0;
+    if (!timeline_collect(rank, &workers, &worker_count, &spans, &span_count)) {
+        worker_count = 0;
+        span_count = 0;
+    }
+    
+    // Byte counts of the workers and spans of every rank
+    int local_bytes[2] = { worker_count * (int)sizeof(TimelineWorker), span_count * (int)sizeof(TimelineSpan) };
+    int* bytes = NULL;
+    int* worker_bytes = NULL;
+    int* worker_displs = NULL;
+    int* span_bytes = NULL;
+    int* span_displs = NULL;
+    TimelineWorker* all_workers = NULL;
+    TimelineSpan* all_spans = NULL;
+    int total_workers = 0;
+    int total_spans = 0;
+    
+    if (rank == 0) {
+        bytes = (int*)malloc(2 * size * sizeof(int));
+        worker_bytes = (int*)malloc(size * sizeof(int));
+        worker_displs = (int*)malloc(size * sizeof(int));
+        span_bytes = (int*)malloc(size * sizeof(int));
+        span_displs = (int*)malloc(size * sizeof(int));
+    }
+    MPI_Gather(local_bytes, 2, MPI_INT, bytes, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    
+    if (rank == 0) {
+        int worker_offset = 0;
+        int span_offset = 0;
+        for (int r = 0; r < size; r++) {
+            worker_bytes[r] = bytes[2 * r];
+            span_bytes[r] = bytes[2 * r + 1];
+            worker_displs[r] = worker_offset;
+            span_displs[r] = span_offset;
+            worker_offset += worker_bytes[r];
+            span_offset += span_bytes[r];
+        }
+        total_workers = worker_offset / (int)sizeof(TimelineWorker);
+        total_spans = span_offset / (int)sizeof(TimelineSpan);
+        all_workers = (TimelineWorker*)malloc((total_workers ? total_workers : 1) * sizeof(TimelineWorker));
+        all_spans = (TimelineSpan*)malloc((total_spans ? total_spans : 1) * sizeof(TimelineSpan));
+    }
+    
+    MPI_Gatherv(workers, local_bytes[0], MPI_BYTE, all_workers, worker_bytes, worker_displs,
+                MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Gatherv(spans, local_bytes[1], MPI_BYTE, all_spans, span_bytes, span_displs,
+                MPI_BYTE, 0, MPI_COMM_WORLD);
+    
+    if (rank == 0) {
+        printf("\n");
+        timeline_print_stats(stdout, all_workers, total_workers);
+        if (trace_path) {
+            if (timeline_write_trace(trace_path, all_workers, total_workers, all_spans, total_spans)) {
+                printf("Trace written to %s (%d spans)\n", trace_path, total_spans);
+            } else {
+                printf("Failed to write trace to %s\n", trace_path);
+            }
+        }
+    }
+    
+    free(workers);
+    free(spans);
+    free(bytes);
+    free(worker_bytes);
+    free(worker_displs);
+    free(span_bytes);
+    free(span_displs);
+    free(all_workers);
+    free(all_spans);
+}
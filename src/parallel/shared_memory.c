@@ -0,0 +1,189 @@
+#include "ist_shared.h"
+#include "bubble_sort_network.h"
+#include "ist_timeline.h"
+#include "utils.h"
+#include <mpi.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Allocate count ints once per node (on the node leader) and map them in every
+// rank of node; the window is left in a passive epoch until it is freed
+static int* allocate_shared_window(MPI_Comm node, int node_rank, size_t count, MPI_Win* window) {
+    int* base;
+    MPI_Aint bytes = node_rank == 0 ? (MPI_Aint)(count * sizeof(int)) : 0;
+    MPI_Win_allocate_shared(bytes, sizeof(int), MPI_INFO_NULL, node, &base, window);
+    
+    // Every rank addresses the leader's segment
+    MPI_Aint segment;
+    int disp_unit;
+    MPI_Win_shared_query(*window, 0, &segment, &disp_unit, &base);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, *window);
+    return base;
+}
+
+// Split MPI_COMM_WORLD into nodes and allocate the trees of B_dimension, and
+// the network if with_network, once per node
+// Collective over MPI_COMM_WORLD; returns NULL on failure
+SharedISTs* create_shared_ists(int dimension, int with_network) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    
+    SharedISTs* shared = (SharedISTs*)calloc(1, sizeof(SharedISTs));
+    if (!shared) return NULL;
+    
+    shared->ists.trees = (SpanningTree*)malloc((dimension - 1) * sizeof(SpanningTree));
+    if (!shared->ists.trees) {
+        free(shared);
+        return NULL;
+    }
+    
+    // Ranks keep their world order within a node and leaders within the job
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &shared->node);
+    MPI_Comm_rank(shared->node, &shared->node_rank);
+    MPI_Comm_size(shared->node, &shared->node_size);
+    MPI_Comm_split(MPI_COMM_WORLD, shared->node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &shared->leaders);
+    
+    int layout[3] = { 0, 0, 0 };    // Node index, node count, ranks before this node
+    if (shared->leaders != MPI_COMM_NULL) {
+        MPI_Comm_rank(shared->leaders, &layout[0]);
+        MPI_Comm_size(shared->leaders, &layout[1]);
+        MPI_Exscan(&shared->node_size, &layout[2], 1, MPI_INT, MPI_SUM, shared->leaders);
+        if (layout[0] == 0) layout[2] = 0;      // MPI_Exscan leaves the first result undefined
+    }
+    MPI_Bcast(layout, 3, MPI_INT, 0, shared->node);
+    shared->node_index = layout[0];
+    shared->node_count = layout[1];
+    shared->first_rank = layout[2];
+    
+    // The node owns the ranges of its ranks in node-major order, which are contiguous
+    int vertex_count = factorial(dimension);
+    int unused;
+    vertex_range(vertex_count, shared->first_rank, size, &shared->node_start, &unused);
+    vertex_range(vertex_count, shared->first_rank + shared->node_size - 1, size, &unused, &shared->node_end);
+    
+    size_t tree_ints = (size_t)(dimension - 1) * vertex_count;
+    int* parents = allocate_shared_window(shared->node, shared->node_rank, tree_ints, &shared->tree_window);
+    shared->bytes = tree_ints * sizeof(int);
+    
+    shared->ists.tree_count = dimension - 1;
+    for (int t = 0; t < dimension - 1; t++) {
+        shared->ists.trees[t].vertex_count = vertex_count;
+        shared->ists.trees[t].parent = parents + (size_t)t * vertex_count;
+        
+        // The kernels never write the root
+        if (shared->node_rank == 0) shared->ists.trees[t].parent[0] = -1;
+    }
+    
+    shared->network.dimension = dimension;
+    shared->network.vertex_count = vertex_count;
+    shared->network.adjacency = NULL;
+    shared->network.offsets = NULL;
+    shared->network_window = MPI_WIN_NULL;
+    
+    // Each rank of the node builds a slice of the network
+    if (with_network) {
+        size_t edge_count = (size_t)(dimension - 1) * vertex_count;
+        int* base = allocate_shared_window(shared->node, shared->node_rank, edge_count + vertex_count + 1,
+                                           &shared->network_window);
+        shared->network.adjacency = base;
+        shared->network.offsets = base + edge_count;
+        shared->bytes += (edge_count + vertex_count + 1) * sizeof(int);
+        
+        int start, end;
+        vertex_range(vertex_count, shared->node_rank, shared->node_size, &start, &end);
+        fill_bubble_sort_network(&shared->network, start, end);
+        if (shared->node_rank == 0) shared->network.offsets[vertex_count] = (int)edge_count;
+    }
+    
+    sync_shared_ists(shared);
+    return shared;
+}
+
+// Collective over MPI_COMM_WORLD
+void free_shared_ists(SharedISTs* shared) {
+    if (!shared) return;
+    
+    MPI_Win_unlock_all(shared->tree_window);
+    MPI_Win_free(&shared->tree_window);
+    if (shared->network_window != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(shared->network_window);
+        MPI_Win_free(&shared->network_window);
+    }
+    if (shared->leaders != MPI_COMM_NULL) MPI_Comm_free(&shared->leaders);
+    MPI_Comm_free(&shared->node);
+    free(shared->ists.trees);
+    free(shared);
+}
+
+// Range of vertices [start, end) this rank computes: its share of the node's range
+void shared_vertex_range(const SharedISTs* shared, int* start, int* end) {
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    vertex_range(shared->network.vertex_count, shared->first_rank + shared->node_rank, size, start, end);
+}
+
+// Make the stores of every rank of the node visible to all of them
+// Collective over the node
+void sync_shared_ists(SharedISTs* shared) {
+    MPI_Win_sync(shared->tree_window);
+    if (shared->network_window != MPI_WIN_NULL) MPI_Win_sync(shared->network_window);
+    MPI_Barrier(shared->node);
+    MPI_Win_sync(shared->tree_window);
+    if (shared->network_window != MPI_WIN_NULL) MPI_Win_sync(shared->network_window);
+}
+
+// Exchange the node ranges of every tree between the node leaders according
+// to placement: with PLACEMENT_ALL every rank then sees all trees through the
+// window, with PLACEMENT_ROOT only the ranks on the node of rank 0 do
+// Collective over MPI_COMM_WORLD
+void exchange_shared_ists(SharedISTs* shared, ResultPlacement placement) {
+    sync_shared_ists(shared);
+    
+    double span_start = timeline_now();
+    if (shared->leaders != MPI_COMM_NULL && shared->node_count > 1 && placement != PLACEMENT_DISTRIBUTED) {
+        int* ranges = (int*)malloc(2 * shared->node_count * sizeof(int));
+        int* counts = (int*)malloc(shared->node_count * sizeof(int));
+        int* displs = (int*)malloc(shared->node_count * sizeof(int));
+        
+        int local[2] = { shared->node_start, shared->node_end - shared->node_start };
+        MPI_Allgather(local, 2, MPI_INT, ranges, 2, MPI_INT, shared->leaders);
+        for (int k = 0; k < shared->node_count; k++) {
+            displs[k] = ranges[2 * k];
+            counts[k] = ranges[2 * k + 1];
+        }
+        
+        // Leader 0 is on the node of rank 0, as the leaders keep their world order
+        for (int t = 0; t < shared->ists.tree_count; t++) {
+            int* parent = shared->ists.trees[t].parent;
+            if (placement == PLACEMENT_ALL) {
+                MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, parent, counts, displs, MPI_INT, shared->leaders);
+            } else if (shared->node_index == 0) {
+                MPI_Gatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, parent, counts, displs, MPI_INT, 0, shared->leaders);
+            } else {
+                MPI_Gatherv(parent + shared->node_start, shared->node_end - shared->node_start, MPI_INT,
+                            NULL, NULL, NULL, MPI_INT, 0, shared->leaders);
+            }
+        }
+        
+        free(ranges);
+        free(counts);
+        free(displs);
+    }
+    timeline_span(SPAN_ALLGATHER, span_start, timeline_now());
+    
+    sync_shared_ists(shared);
+}
+
+// Rank of this process within its node, for planning before the windows exist
+// Collective over MPI_COMM_WORLD
+int shared_node_rank(void) {
+    int rank, node_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    MPI_Comm node;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &node_rank);
+    MPI_Comm_free(&node);
+    return node_rank;
+}
@@ -0,0 +1,214 @@
+#include "utils.h"
+#include "ist_server.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Load generator for ist_server
+//
+// Every connection runs in its own thread and sends --requests batches of
+// --batch random vertices back to back; the latency of each request (send to
+// last reply byte) is recorded, and the percentiles are taken over all
+// requests of all connections.
+
+typedef struct {
+    const char* socket_path;
+    ISTQueryOp op;
+    int tree;                   // Tree of parent and path queries, -1 for a random one per request
+    int batch;                  // Vertices per request
+    int requests;               // Requests to send
+    uint64_t seed;              // Seed of the vertex sampler
+    int vertex_count;           // Vertices of the served network
+    int tree_count;             // Trees served
+    size_t capacity;            // Words a reply can hold
+    double* latencies;          // Seconds per request
+    int errors;                 // Replies with an error status
+    int failed;                 // The connection failed
+} ClientThread;
+
+// splitmix64
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void* run_client(void* arg) {
+    ClientThread* client = (ClientThread*)arg;
+    int fd = connect_ist_server(client->socket_path);
+    int32_t* vertices = (int32_t*)malloc(client->batch * sizeof(int32_t));
+    int32_t* words = (int32_t*)malloc(client->capacity * sizeof(int32_t));
+    if (fd < 0 || !vertices || !words) {
+        client->failed = 1;
+        if (fd >= 0) close(fd);
+        free(vertices);
+        free(words);
+        return NULL;
+    }
+    
+    uint64_t state = client->seed;
+    for (int r = 0; r < client->requests; r++) {
+        for (int i = 0; i < client->batch; i++) {
+            vertices[i] = (int32_t)(next_random(&state) % (uint64_t)client->vertex_count);
+        }
+        int tree = client->tree >= 0 ? client->tree : (int)(next_random(&state) % (uint64_t)client->tree_count);
+        
+        ISTReplyHeader reply;
+        double start_time = measure_time();
+        if (!call_ist_server(fd, client->op, tree, vertices, client->batch, &reply, words, client->capacity)) {
+            client->failed = 1;
+            break;
+        }
+        client->latencies[r] = measure_time() - start_time;
+        if (reply.status != IST_STATUS_OK) client->errors++;
+    }
+    
+    close(fd);
+    free(vertices);
+    free(words);
+    return NULL;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Value at fraction q of the sorted values (nearest rank)
+static double percentile(const double* sorted, long long count, double q) {
+    long long rank = (long long)(q * count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+int main(int argc, char* argv[]) {
+    const char* socket_path = "/tmp/ist.sock";
+    ISTQueryOp op = IST_OP_PARENT;
+    int tree = -1;
+    int batch = 64;
+    int requests = 10000;
+    int connections = 1;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--op") == 0 && i + 1 < argc) {
+            if (!parse_ist_query_op(argv[++i], &op)) {
+                printf("Unknown operation: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tree") == 0 && i + 1 < argc) {
+            tree = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            printf("Usage: %s [--socket <path>] [--op info|parent|all_parents|path] [--tree <t>]\n"
+                   "       [--batch <vertices>] [--requests <count>] [--connections <count>] [--seed <S>]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    
+    if (batch < 1 || batch > IST_QUERY_MAX_BATCH || requests < 1 || connections < 1) {
+        printf("Batch must be between 1 and %d; requests and connections must be positive\n", IST_QUERY_MAX_BATCH);
+        return 1;
+    }
+    
+    // Ask the server what it serves
+    int fd = connect_ist_server(socket_path);
+    if (fd < 0) {
+        printf("Failed to connect to %s\n", socket_path);
+        return 1;
+    }
+    ISTReplyHeader reply;
+    int32_t info[4];
+    int ok = call_ist_server(fd, IST_OP_INFO, 0, NULL, 0, &reply, info, 4);
+    close(fd);
+    if (!ok || reply.status != IST_STATUS_OK || reply.words != 4) {
+        printf("The server at %s did not answer the info request\n", socket_path);
+        return 1;
+    }
+    int dimension = info[0];
+    printf("Server: %d trees of B_%d (%d vertices, %s)\n", info[2], dimension, info[1],
+           ist_source_kind_name((ISTSourceKind)info[3]));
+    if (tree >= info[2]) {
+        printf("Tree must be below %d\n", info[2]);
+        return 1;
+    }
+    
+    ClientThread* clients = (ClientThread*)calloc(connections, sizeof(ClientThread));
+    pthread_t* threads = (pthread_t*)malloc(connections * sizeof(pthread_t));
+    double* latencies = (double*)malloc((size_t)connections * requests * sizeof(double));
+    if (!clients || !threads || !latencies) {
+        printf("Failed to allocate the clients\n");
+        free(clients);
+        free(threads);
+        free(latencies);
+        return 1;
+    }
+    
+    printf("Sending %d %s requests of %d vertices on %d connections...\n", requests,
+           ist_query_op_name(op), batch, connections);
+    
+    double start_time = measure_time();
+    for (int c = 0; c < connections; c++) {
+        clients[c].socket_path = socket_path;
+        clients[c].op = op;
+        clients[c].tree = tree;
+        clients[c].batch = batch;
+        clients[c].requests = requests;
+        clients[c].seed = seed + c;
+        clients[c].vertex_count = info[1];
+        clients[c].tree_count = info[2];
+        clients[c].capacity = IST_QUERY_MAX_WORDS(dimension);
+        clients[c].latencies = latencies + (size_t)c * requests;
+        pthread_create(&threads[c], NULL, run_client, &clients[c]);
+    }
+    for (int c = 0; c < connections; c++) {
+        pthread_join(threads[c], NULL);
+    }
+    double seconds = measure_time() - start_time;
+    
+    int errors = 0;
+    int failed = 0;
+    for (int c = 0; c < connections; c++) {
+        errors += clients[c].errors;
+        failed += clients[c].failed;
+    }
+    
+    int status = 0;
+    if (failed > 0) {
+        printf("%d of %d connections failed\n", failed, connections);
+        status = 1;
+    } else {
+        long long total = (long long)connections * requests;
+        qsort(latencies, total, sizeof(double), compare_doubles);
+        
+        printf("%lld requests in %.3f seconds: %.0f requests/s, %.0f lookups/s\n", total, seconds,
+               total / seconds, total * (double)batch / seconds);
+        printf("Latency per request (us): p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+               1e6 * percentile(latencies, total, 0.50), 1e6 * percentile(latencies, total, 0.90),
+               1e6 * percentile(latencies, total, 0.99), 1e6 * percentile(latencies, total, 0.999),
+               1e6 * latencies[total - 1]);
+        if (errors > 0) {
+            printf("%d replies reported an error\n", errors);
+            status = 1;
+        }
+    }
+    
+    free(clients);
+    free(threads);
+    free(latencies);
+    return status;
+}
@@ -64,6 +64,7 @@
 
 #include "bubble_sort_network.h"
 #include "utils.h"
+#include "ist_profile.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -88,8 +89,19 @@ BubbleSortNetwork* create_bubble_sort_network(int dimension) {
     }
     
     // Initialize adjacency list
-    int edge_index = 0;
-    for (int v = 0; v < network->vertex_count; v++) {
+    fill_bubble_sort_network(network, 0, network->vertex_count);
+    
+    network->offsets[network->vertex_count] = edge_count;
+    
+    return network;
+}
+
+// Fill the adjacency lists and offsets of vertices [start_vertex, end_vertex)
+// Every vertex has dimension-1 neighbors, so ranges can be filled independently
+void fill_bubble_sort_network(BubbleSortNetwork* network, int start_vertex, int end_vertex) {
+    int dimension = network->dimension;
+    int edge_index = start_vertex * (dimension - 1);
+    for (int v = start_vertex; v < end_vertex; v++) {
         network->offsets[v] = edge_index;
         
         // Get permutation for this vertex
@@ -99,7 +111,7 @@ BubbleSortNetwork* create_bubble_sort_network(int dimension) {
         for (int i = 0; i < dimension - 1; i++) {
             // Create a new permutation by swapping positions i and i+1
             Permutation* neighbor = copy_permutation(perm);
-            swap(&neighbor->elements[i], &neighbor->elements[i+1]);
+            swap_adjacent(neighbor, i + 1);
             
             // Convert back to index and add to adjacency list
             int neighbor_index = permutation_to_index(neighbor, dimension);
@@ -110,40 +122,82 @@ BubbleSortNetwork* create_bubble_sort_network(int dimension) {
         
         free_permutation(perm);
     }
+}
+
+// Network of dimension n without edges: enough for the engines, which only
+// need the dimension and vertex count, but not for verification
+BubbleSortNetwork* create_bubble_sort_network_shape(int dimension) {
+    BubbleSortNetwork* network = (BubbleSortNetwork*)malloc(sizeof(BubbleSortNetwork));
+    if (!network) return NULL;
     
-    network->offsets[network->vertex_count] = edge_index;
-    
+    network->dimension = dimension;
+    network->vertex_count = factorial(dimension);
+    network->adjacency = NULL;
+    network->offsets = NULL;
     return network;
 }
 
+// Allocate a permutation of the given dimension (contents undefined)
+// elements and inverse share one allocation
+static Permutation* alloc_permutation(int dimension) {
+    Permutation* perm = (Permutation*)malloc(sizeof(Permutation));
+    if (!perm) return NULL;
+    
+    perm->n = dimension;
+    perm->elements = (int*)malloc(2 * dimension * sizeof(int));
+    if (!perm->elements) {
+        free(perm);
+        return NULL;
+    }
+    perm->inverse = perm->elements + dimension;
+    
+    return perm;
+}
+
+// Create the identity permutation of the given dimension
+Permutation* create_permutation(int dimension) {
+    Permutation* perm = alloc_permutation(dimension);
+    if (!perm) return NULL;
+    
+    for (int i = 0; i < dimension; i++) {
+        perm->elements[i] = i + 1;
+        perm->inverse[i] = i + 1;
+    }
+    return perm;
+}
+
 // Create a copy of a permutation
 Permutation* copy_permutation(Permutation* perm) {
-    Permutation* copy = (Permutation*)malloc(sizeof(Permutation));
+    Permutation* copy = alloc_permutation(perm->n);
     if (!copy) return NULL;
     
-    copy->n = perm->n;
-    copy->elements = (int*)malloc(perm->n * sizeof(int));
-    if (!copy->elements) {
-        free(copy);
-        return NULL;
+    memcpy(copy->elements, perm->elements, 2 * perm->n * sizeof(int));
+    return copy;
+}
+
+// Rebuild the inverse after elements were changed directly
+void update_inverse(Permutation* perm) {
+    for (int i = 0; i < perm->n; i++) {
+        perm->inverse[perm->elements[i] - 1] = i + 1;
     }
+}
+
+// Swap the symbols at position and position+1 (1-based), keeping the inverse
+void swap_adjacent(Permutation* perm, int position) {
+    int left = perm->elements[position - 1];
+    int right = perm->elements[position];
     
-    memcpy(copy->elements, perm->elements, perm->n * sizeof(int));
-    return copy;
+    perm->elements[position - 1] = right;
+    perm->elements[position] = left;
+    perm->inverse[right - 1] = position;
+    perm->inverse[left - 1] = position + 1;
 }
 
 // Convert index to permutation using factorial number system
 Permutation* index_to_permutation(int index, int dimension) {
-    Permutation* perm = (Permutation*)malloc(sizeof(Permutation));
+    Permutation* perm = alloc_permutation(dimension);
     if (!perm) return NULL;
     
-    perm->n = dimension;
-    perm->elements = (int*)malloc(dimension * sizeof(int));
-    if (!perm->elements) {
-        free(perm);
-        return NULL;
-    }
-    
     // Initialize with all elements
     int* available = (int*)malloc(dimension * sizeof(int));
     for (int i = 0; i < dimension; i++) {
@@ -172,6 +226,7 @@ Permutation* index_to_permutation(int index, int dimension) {
     
     // Set the last element
     perm->elements[dimension - 1] = available[0];
+    update_inverse(perm);
     
     free(available);
     return perm;
@@ -222,6 +277,8 @@ int is_identity_permutation(Permutation* perm) {
 
 // Position of the first symbol from the right which is not in the right position
 int right_position(Permutation* perm) {
+    IST_PROFILE_COUNT(IST_PROFILE_RIGHT_POSITION);
+    
     for (int i = perm->n - 1; i >= 0; i--) {
         if (perm->elements[i] != i + 1) {
             return i + 1;
@@ -230,14 +287,80 @@ int right_position(Permutation* perm) {
     return 0;  // All elements are in the right position
 }
 
-// Get the position of a value in the permutation
+// Get the position of a value in the permutation (O(1) through the inverse)
 int find_position(Permutation* perm, int value) {
-    for (int i = 0; i < perm->n; i++) {
-        if (perm->elements[i] == value) {
-            return i + 1;
-        }
+    if (value < 1 || value > perm->n) {
+        return -1;  // Value not found (should not happen)
+    }
+    return perm->inverse[value - 1];
+}
+
+// Advance to the next permutation in lexicographic (= index) order
+// Returns 0 when perm was the last permutation, 1 otherwise
+int next_permutation(Permutation* perm) {
+    int n = perm->n;
+    
+    // Find the rightmost ascent
+    int i = n - 2;
+    while (i >= 0 && perm->elements[i] > perm->elements[i + 1]) {
+        i--;
+    }
+    if (i < 0) return 0;
+    
+    // Swap with the smallest larger element to its right
+    int j = n - 1;
+    while (perm->elements[j] < perm->elements[i]) {
+        j--;
+    }
+    swap(&perm->elements[i], &perm->elements[j]);
+    
+    // Reverse the suffix
+    for (int l = i + 1, r = n - 1; l < r; l++, r--) {
+        swap(&perm->elements[l], &perm->elements[r]);
+    }
+    
+    // Only positions i..n-1 changed; amortized O(1) over a walk
+    for (int k = i; k < n; k++) {
+        perm->inverse[perm->elements[k] - 1] = k + 1;
+    }
+    
+    return 1;
+}
+
+// Lehmer digit i of an index: number of smaller symbols to the right of position i+1
+static int lehmer_digit(int index, int i, int dimension) {
+    return (index / factorial(dimension - i - 1)) % (dimension - i);
+}
+
+// Index of the neighbor obtained by swapping positions position and position+1 (1-based)
+// Only the Lehmer digits of the two swapped positions change, so the
+// neighbor is found without unranking the permutation
+int adjacent_swap_index(int index, int position, int dimension) {
+    int i = position - 1;
+    int d0 = lehmer_digit(index, i, dimension);
+    int d1 = lehmer_digit(index, i + 1, dimension);
+    
+    // d0 <= d1 exactly when the symbol at position i+1 is smaller than the next one
+    int new_d0 = d0 <= d1 ? d1 + 1 : d1;
+    int new_d1 = d0 <= d1 ? d0 : d0 - 1;
+    
+    return index + (new_d0 - d0) * factorial(dimension - i - 1)
+                 + (new_d1 - d1) * factorial(dimension - i - 2);
+}
+
+// Position (1-based) of the adjacent swap taking index to neighbor
+// Returns 0 if the two vertices are not adjacent in B_n
+int adjacent_swap_position(int index, int neighbor, int dimension) {
+    if (index == neighbor || neighbor < 0) return 0;
+    
+    // The swap position is the first Lehmer digit that differs
+    int i = 0;
+    while (i < dimension - 1 && lehmer_digit(index, i, dimension) == lehmer_digit(neighbor, i, dimension)) {
+        i++;
     }
-    return -1;  // Value not found (should not happen)
+    if (i >= dimension - 1) return 0;
+    
+    return adjacent_swap_index(index, i + 1, dimension) == neighbor ? i + 1 : 0;
 }
 
 // Free memory for a permutation
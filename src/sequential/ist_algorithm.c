@@ -1,105 +1,143 @@
 #include "ist_algorithm.h"
 #include "utils.h"
+#include "ist_profile.h"
+#include "ist_kernels.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-// Determine the parent of vertex v in tree t
-// This is the core algorithm from the paper
-Permutation* Parent1(Permutation* v, int t, int n) {
-    // Create a copy of the permutation to work with
-    Permutation* parent = copy_permutation(v);
+// Position (1-based) of the adjacent swap that takes vertex v to its parent in tree t
+// This is the core algorithm from the paper; every lookup is O(1) through the inverse
+int parent_swap_position(Permutation* v, int t, int n) {
+    int pos;
     
     // Case A: Last symbol is n
-    if (parent->elements[n-1] == n) {
+    if (v->elements[n-1] == n) {
         // Case A.1: Tree index is not n-1
         if (t != n - 1) {
             // FindPosition function from the paper
             // Case A.1.1: t != 2 or Swap(v, t) != identity
-            if (t != 2 || !is_swap_identity(parent, t)) {
+            if (t != 2 || !is_swap_identity(v, t)) {
                 // Case A.1.1.1: Second-to-last symbol is t or n-1
-                if (parent->elements[n-2] == t || parent->elements[n-2] == n-1) {
-                    int j = right_position(parent);
-                    int pos = find_position(parent, j);
-                    swap(&parent->elements[pos-1], &parent->elements[pos]);
+                if (v->elements[n-2] == t || v->elements[n-2] == n-1) {
+                    IST_PROFILE_COUNT(PARENT_CASE_A111);
+                    int j = right_position(v);
+                    pos = find_position(v, j);
                 }
                 // Case A.1.1.2: Second-to-last symbol is not t or n-1
                 else {
-                    int pos = find_position(parent, t);
-                    swap(&parent->elements[pos-1], &parent->elements[pos]);
+                    IST_PROFILE_COUNT(PARENT_CASE_A112);
+                    pos = find_position(v, t);
                 }
             }
             // Case A.1.2: t = 2 and Swap(v, t) = identity
             else {
-                int pos = find_position(parent, t-1);
-                swap(&parent->elements[pos-1], &parent->elements[pos]);
+                IST_PROFILE_COUNT(PARENT_CASE_A12);
+                pos = find_position(v, t-1);
             }
         }
         // Case A.2: Tree index is n-1
         else {
-            int pos = find_position(parent, parent->elements[n-2]);
-            swap(&parent->elements[pos-1], &parent->elements[pos]);
+            IST_PROFILE_COUNT(PARENT_CASE_A2);
+            pos = find_position(v, v->elements[n-2]);
         }
     }
     // Case B: Last symbol is n-1
-    else if (parent->elements[n-1] == n-1) {
+    else if (v->elements[n-1] == n-1) {
         // Case B.1: Second-to-last symbol is not n or Swap(v, n) is identity
-        if (parent->elements[n-2] != n || is_swap_identity(parent, n)) {
+        if (v->elements[n-2] != n || is_swap_identity(v, n)) {
             // Case B.1.1: Last symbol is equal to tree index
-            if (parent->elements[n-1] == t) {
-                int pos = find_position(parent, n);
-                swap(&parent->elements[pos-1], &parent->elements[pos]);
+            if (v->elements[n-1] == t) {
+                IST_PROFILE_COUNT(PARENT_CASE_B11);
+                pos = find_position(v, n);
             }
             // Case B.1.2: Last symbol is not equal to tree index
             else {
-                int pos = find_position(parent, t);
-                swap(&parent->elements[pos-1], &parent->elements[pos]);
+                IST_PROFILE_COUNT(PARENT_CASE_B12);
+                pos = find_position(v, t);
             }
         }
         // Case B.2: Second-to-last symbol is n and Swap(v, n) is not identity
         else {
             // Case B.2.1: Tree index is not 1
             if (t != 1) {
-                int pos = find_position(parent, t-1);
-                swap(&parent->elements[pos-1], &parent->elements[pos]);
+                IST_PROFILE_COUNT(PARENT_CASE_B21);
+                pos = find_position(v, t-1);
             }
             // Case B.2.2: Tree index is 1
             else {
-                int pos = find_position(parent, n);
-                swap(&parent->elements[pos-1], &parent->elements[pos]);
+                IST_PROFILE_COUNT(PARENT_CASE_B22);
+                pos = find_position(v, n);
             }
         }
     }
     // Case C: Last symbol is j where j is in {1, 2, ..., n-2}
     else {
         // Case C.1: Last symbol is equal to tree index
-        if (parent->elements[n-1] == t) {
-            int pos = find_position(parent, n);
-            swap(&parent->elements[pos-1], &parent->elements[pos]);
+        if (v->elements[n-1] == t) {
+            IST_PROFILE_COUNT(PARENT_CASE_C1);
+            pos = find_position(v, n);
         }
         // Case C.2: Last symbol is not equal to tree index
         else {
-            int pos = find_position(parent, t);
-            swap(&parent->elements[pos-1], &parent->elements[pos]);
+            IST_PROFILE_COUNT(PARENT_CASE_C2);
+            pos = find_position(v, t);
         }
     }
     
+    return pos;
+}
+
+// Determine the parent of vertex v in tree t
+Permutation* Parent1(Permutation* v, int t, int n) {
+    // Create a copy of the permutation to work with
+    Permutation* parent = copy_permutation(v);
+    swap_adjacent(parent, parent_swap_position(v, t, n));
     return parent;
 }
 
+// The case of Parent1 that handles vertex v in tree t
+// Mirrors the branch structure of Parent1 without computing the parent
+ParentCase parent1_case(Permutation* v, int t, int n) {
+    int last = v->elements[n-1];
+    
+    if (last == n) {
+        if (t == n - 1) return PARENT_CASE_A2;
+        if (t == 2 && is_swap_identity(v, t)) return PARENT_CASE_A12;
+        if (v->elements[n-2] == t || v->elements[n-2] == n-1) return PARENT_CASE_A111;
+        return PARENT_CASE_A112;
+    }
+    if (last == n - 1) {
+        if (v->elements[n-2] != n || is_swap_identity(v, n)) {
+            return last == t ? PARENT_CASE_B11 : PARENT_CASE_B12;
+        }
+        return t != 1 ? PARENT_CASE_B21 : PARENT_CASE_B22;
+    }
+    return last == t ? PARENT_CASE_C1 : PARENT_CASE_C2;
+}
+
+// Printable name of a Parent1 case ("A.1.1.1", ...)
+const char* parent_case_name(ParentCase c) {
+    static const char* names[PARENT_CASE_COUNT] = {
+        "A.1.1.1", "A.1.1.2", "A.1.2", "A.2", "B.1.1", "B.1.2", "B.2.1", "B.2.2", "C.1", "C.2"
+    };
+    return c >= 0 && c < PARENT_CASE_COUNT ? names[c] : "unknown";
+}
+
 // Check if swapping the position of value t results in the identity permutation
+// That is the case iff the symbols at positions pos, pos+1 are pos+1, pos and
+// every other symbol is fixed, so no copy is needed
 int is_swap_identity(Permutation* perm, int t) {
-    // Create a copy to work with
-    Permutation* copy = copy_permutation(perm);
-    
-    // Find position of t and swap with next position
-    int pos = find_position(copy, t);
-    swap(&copy->elements[pos-1], &copy->elements[pos]);
+    IST_PROFILE_COUNT(IST_PROFILE_IS_SWAP_IDENTITY);
     
-    // Check if result is identity
-    int result = is_identity_permutation(copy);
+    int pos = find_position(perm, t);
+    if (pos < 1 || pos >= perm->n) return 0;
+    if (perm->elements[pos-1] != pos + 1 || perm->elements[pos] != pos) return 0;
     
-    free_permutation(copy);
-    return result;
+    for (int i = 0; i < perm->n; i++) {
+        if (i != pos - 1 && i != pos && perm->elements[i] != i + 1) return 0;
+    }
+    return 1;
 }
 
 // Construct n-1 independent spanning trees sequentially
@@ -137,30 +175,48 @@ IndependentSpanningTrees* construct_sequential_ists(BubbleSortNetwork* network)
         }
     }
     
-    // Construct each tree
-    for (int v = 0; v < vertex_count; v++) {
-        Permutation* perm = index_to_permutation(v, n);
-        
-        // Skip the root (identity permutation)
-        if (is_identity_permutation(perm)) {
-            free_permutation(perm);
-            continue;
-        }
-        
-        // Determine parent in each tree
-        for (int t = 0; t < n - 1; t++) {
-            Permutation* parent = Parent1(perm, t + 1, n); // t+1 because tree indices start at 1
-            int parent_index = permutation_to_index(parent, n);
-            ists->trees[t].parent[v] = parent_index;
-            free_permutation(parent);
-        }
-        
-        free_permutation(perm);
-    }
+    // Construct each tree with the kernel for this dimension
+    ParentKernel kernel = select_parent_kernel(n);
+    kernel(ists, 0, vertex_count, NULL);
     
     return ists;
 }
 
+// Default options for the MPI and hybrid engines
+void init_parallel_options(ParallelOptions* options) {
+    options->checkpoint = NULL;
+    options->times = NULL;
+    options->chunk_size = 0;
+    options->chunks_taken = NULL;
+    options->shared = NULL;
+    options->placement = PLACEMENT_ALL;
+    options->digest = NULL;
+}
+
+static const char* placement_names[PLACEMENT_COUNT] = { "all", "root", "distributed" };
+
+// Whether rank holds every tree after a construction with options (NULL for the defaults)
+int holds_all_trees(const ParallelOptions* options, int rank) {
+    if (!options || options->placement == PLACEMENT_ALL) return 1;
+    return options->placement == PLACEMENT_ROOT && rank == 0;
+}
+
+// Parse all, root or distributed
+// Returns 1 on success, 0 for an unknown name
+int parse_result_placement(const char* name, ResultPlacement* placement) {
+    for (int p = 0; p < PLACEMENT_COUNT; p++) {
+        if (strcmp(name, placement_names[p]) == 0) {
+            *placement = (ResultPlacement)p;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* result_placement_name(ResultPlacement placement) {
+    return placement >= 0 && placement < PLACEMENT_COUNT ? placement_names[placement] : "unknown";
+}
+
 // Free memory for a spanning tree
 void free_spanning_tree(SpanningTree* tree) {
     if (tree) {
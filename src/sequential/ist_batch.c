@@ -0,0 +1,286 @@
+#include "ist_kernels.h"
+#include "ist_timeline.h"
+#include "utils.h"
+#include <stdlib.h>
+
+// Batch parent kernels: LANES consecutive vertices at a time
+//
+// The permutations of a group live in structure-of-arrays form, row i holding
+// position (or symbol) i of every lane, so each step of the computation is one
+// loop over the lanes that the compiler turns into vector instructions. The
+// case analysis of Parent1 is evaluated for all lanes with selects instead of
+// branches; only the tree index t, which is the same in every lane, is
+// branched on. Lookups at a lane-dependent position (the position of the
+// rightmost misplaced symbol, the Lehmer digits at the swap) are sweeps over
+// all positions, which costs O(n) selects but no gathers.
+//
+// The body is compiled once per dimension and instruction set: AVX-512
+// (16 lanes), AVX2 (8 lanes) and the baseline x86-64 or non-x86 target (8
+// lanes, scalar or SSE2), picked once at run time. Vertices that do not fill a
+// whole group go through the scalar kernel.
+
+#define BATCH_INLINE static inline __attribute__((always_inline))
+#define BATCH_MAX_LANES 16
+
+// k! for k = 0..IST_KERNEL_MAX_DIMENSION
+static const int batch_factorials[IST_KERNEL_MAX_DIMENSION + 1] = {
+    1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880, 3628800, 39916800, 479001600
+};
+
+// Whether swapping the symbol at 0-based position p with its right neighbor
+// gives the identity, for every lane
+BATCH_INLINE void batch_swap_is_identity(int (*elements)[BATCH_MAX_LANES], const int* p,
+                                         int* identity, const int n, const int lanes) {
+    for (int l = 0; l < lanes; l++) {
+        identity[l] = p[l] + 1 < n;
+    }
+    #pragma GCC unroll 12
+    for (int i = 0; i < n; i++) {
+        for (int l = 0; l < lanes; l++) {
+            int expected = i == p[l] ? p[l] + 2 : (i == p[l] + 1 ? p[l] + 1 : i + 1);
+            identity[l] &= elements[i][l] == expected;
+        }
+    }
+}
+
+// Parents of vertices first .. first+lanes-1 in all n-1 trees
+// With times, the unrank sweep and the parent computation are timed apart
+BATCH_INLINE void batch_group(int* const* parents, int first, KernelTimes* times, const int n, const int lanes) {
+    int vertex[BATCH_MAX_LANES];
+    int digits[IST_KERNEL_MAX_DIMENSION][BATCH_MAX_LANES];
+    int elements[IST_KERNEL_MAX_DIMENSION][BATCH_MAX_LANES];
+    int inverse[IST_KERNEL_MAX_DIMENSION][BATCH_MAX_LANES];
+    double unrank_start = times ? timeline_now() : 0.0;
+    
+    for (int l = 0; l < lanes; l++) {
+        vertex[l] = first + l;
+    }
+    
+    // Lehmer digits; the divisors are constants, so no division instructions
+    #pragma GCC unroll 12
+    for (int i = 0; i < n; i++) {
+        for (int l = 0; l < lanes; l++) {
+            digits[i][l] = (vertex[l] / batch_factorials[n - 1 - i]) % (n - i);
+        }
+    }
+    
+    // Symbols from the right: position i takes rank digit+1 among the symbols
+    // of positions i..n-1, and the symbols further right at or above it move up
+    #pragma GCC unroll 12
+    for (int i = n - 1; i >= 0; i--) {
+        int symbol[BATCH_MAX_LANES];
+        for (int l = 0; l < lanes; l++) {
+            symbol[l] = digits[i][l] + 1;
+            elements[i][l] = symbol[l];
+        }
+        #pragma GCC unroll 12
+        for (int j = i + 1; j < n; j++) {
+            for (int l = 0; l < lanes; l++) {
+                elements[j][l] += elements[j][l] >= symbol[l];
+            }
+        }
+    }
+    
+    // Inverse by sweeping the positions: inverse[s][l] is the position of symbol s+1
+    #pragma GCC unroll 12
+    for (int s = 0; s < n; s++) {
+        for (int l = 0; l < lanes; l++) {
+            inverse[s][l] = 0;
+        }
+        #pragma GCC unroll 12
+        for (int i = 0; i < n; i++) {
+            for (int l = 0; l < lanes; l++) {
+                inverse[s][l] = elements[i][l] == s + 1 ? i + 1 : inverse[s][l];
+            }
+        }
+    }
+    
+    double parent_start = times ? timeline_now() : 0.0;
+    if (times) times->unrank += parent_start - unrank_start;
+    
+    // Tree-independent conditions of Parent1
+    int last[BATCH_MAX_LANES];
+    int second[BATCH_MAX_LANES];
+    int right_symbol_position[BATCH_MAX_LANES];
+    int b1[BATCH_MAX_LANES];
+    int identity2[BATCH_MAX_LANES];
+    int identity_n[BATCH_MAX_LANES];
+    int p[BATCH_MAX_LANES];
+    
+    for (int l = 0; l < lanes; l++) {
+        last[l] = elements[n - 1][l];
+        second[l] = elements[n - 2][l];
+        p[l] = inverse[1][l] - 1;
+    }
+    batch_swap_is_identity(elements, p, identity2, n, lanes);
+    for (int l = 0; l < lanes; l++) {
+        p[l] = inverse[n - 1][l] - 1;
+    }
+    batch_swap_is_identity(elements, p, identity_n, n, lanes);
+    
+    // right_position, then the position of that symbol
+    int right[BATCH_MAX_LANES];
+    for (int l = 0; l < lanes; l++) {
+        right[l] = 0;
+        right_symbol_position[l] = 0;
+        b1[l] = second[l] != n || identity_n[l];
+    }
+    #pragma GCC unroll 12
+    for (int i = 0; i < n; i++) {
+        for (int l = 0; l < lanes; l++) {
+            right[l] = elements[i][l] != i + 1 ? i + 1 : right[l];
+        }
+    }
+    #pragma GCC unroll 12
+    for (int s = 0; s < n; s++) {
+        for (int l = 0; l < lanes; l++) {
+            right_symbol_position[l] = right[l] == s + 1 ? inverse[s][l] : right_symbol_position[l];
+        }
+    }
+    
+    int position[BATCH_MAX_LANES];
+    int d0[BATCH_MAX_LANES];
+    int d1[BATCH_MAX_LANES];
+    int f0[BATCH_MAX_LANES];
+    int f1[BATCH_MAX_LANES];
+    
+    #pragma GCC unroll 12
+    for (int t = 1; t < n; t++) {
+        int* parent = parents[t - 1] + first;
+        
+        // Rows and conditions that depend only on t are resolved outside the lanes
+        const int* find_t = inverse[t - 1];
+        const int* find_b1 = inverse[t == n - 1 ? n - 1 : t - 1];
+        const int* find_b2 = inverse[t != 1 ? t - 2 : n - 1];
+        const int a2 = t == n - 1;
+        const int a12 = t == 2;
+        
+        for (int l = 0; l < lanes; l++) {
+            // Case A: last symbol is n; later selects take precedence
+            int a = (second[l] == t) | (second[l] == n - 1) ? right_symbol_position[l]  // A.1.1.1
+                                                            : find_t[l];                // A.1.1.2
+            a = a12 & identity2[l] ? inverse[0][l] : a;                         // A.1.2
+            a = a2 ? n - 1 : a;                                                 // A.2
+            
+            // Case B: last symbol is n-1
+            int b = b1[l] ? find_b1[l] : find_b2[l];                            // B.1.1, B.1.2 / B.2.1, B.2.2
+            
+            // Case C: last symbol is in 1..n-2
+            int c = last[l] == t ? inverse[n - 1][l] : find_t[l];               // C.1, C.2
+            
+            position[l] = last[l] == n ? a : (last[l] == n - 1 ? b : c);
+            d0[l] = d1[l] = f0[l] = f1[l] = 0;
+        }
+        
+        // Digits and place values at the swap, found by sweeping the positions
+        #pragma GCC unroll 12
+        for (int i = 0; i < n - 1; i++) {
+            for (int l = 0; l < lanes; l++) {
+                int match = position[l] == i + 1;
+                d0[l] = match ? digits[i][l] : d0[l];
+                d1[l] = match ? digits[i + 1][l] : d1[l];
+                f0[l] = match ? batch_factorials[n - 1 - i] : f0[l];
+                f1[l] = match ? batch_factorials[n - 2 - i] : f1[l];
+            }
+        }
+        
+        for (int l = 0; l < lanes; l++) {
+            int new_d0 = d0[l] <= d1[l] ? d1[l] + 1 : d1[l];
+            int new_d1 = d0[l] <= d1[l] ? d0[l] : d0[l] - 1;
+            parent[l] = vertex[l] + (new_d0 - d0[l]) * f0[l] + (new_d1 - d1[l]) * f1[l];
+        }
+    }
+    
+    if (times) times->parent += timeline_now() - parent_start;
+}
+
+// Body of every batch kernel; leftover vertices go to the scalar kernel
+BATCH_INLINE void batch_range(IndependentSpanningTrees* ists, int start, int end,
+                              KernelTimes* times, const int n, const int lanes) {
+    int* parents[IST_KERNEL_MAX_DIMENSION];
+    for (int t = 0; t < n - 1; t++) {
+        parents[t] = ists->trees[t].parent;
+    }
+    
+    // The root (identity permutation, index 0) has no parent
+    if (start == 0) start = 1;
+    
+    int v = start;
+    for (; v + lanes <= end; v += lanes) {
+        batch_group(parents, v, times, n, lanes);
+    }
+    
+    if (v < end) {
+        select_scalar_parent_kernel(n)(ists, v, end, times);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_X86 1
+#define DEFINE_BATCH_KERNELS(N) \
+    __attribute__((target("avx512f"))) \
+    static void batch_kernel_avx512_##N(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) { \
+        batch_range(ists, start, end, times, N, 16); \
+    } \
+    __attribute__((target("avx2"))) \
+    static void batch_kernel_avx2_##N(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) { \
+        batch_range(ists, start, end, times, N, 8); \
+    } \
+    static void batch_kernel_scalar_##N(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) { \
+        batch_range(ists, start, end, times, N, 8); \
+    }
+#else
+#define BATCH_X86 0
+#define DEFINE_BATCH_KERNELS(N) \
+    static void batch_kernel_scalar_##N(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) { \
+        batch_range(ists, start, end, times, N, 8); \
+    }
+#endif
+
+DEFINE_BATCH_KERNELS(4)
+DEFINE_BATCH_KERNELS(5)
+DEFINE_BATCH_KERNELS(6)
+DEFINE_BATCH_KERNELS(7)
+DEFINE_BATCH_KERNELS(8)
+DEFINE_BATCH_KERNELS(9)
+DEFINE_BATCH_KERNELS(10)
+DEFINE_BATCH_KERNELS(11)
+DEFINE_BATCH_KERNELS(12)
+
+#define BATCH_KERNEL_TABLE(ISA) { \
+    batch_kernel_##ISA##_4, batch_kernel_##ISA##_5, batch_kernel_##ISA##_6, \
+    batch_kernel_##ISA##_7, batch_kernel_##ISA##_8, batch_kernel_##ISA##_9, \
+    batch_kernel_##ISA##_10, batch_kernel_##ISA##_11, batch_kernel_##ISA##_12 }
+
+// Indexed by dimension - IST_KERNEL_MIN_DIMENSION
+static const ParentKernel batch_kernels[BATCH_ISA_COUNT][IST_KERNEL_MAX_DIMENSION - IST_KERNEL_MIN_DIMENSION + 1] = {
+    BATCH_KERNEL_TABLE(scalar),
+#if BATCH_X86
+    BATCH_KERNEL_TABLE(avx2),
+    BATCH_KERNEL_TABLE(avx512),
+#endif
+};
+
+static const char* batch_isa_names[BATCH_ISA_COUNT] = { "scalar", "avx2", "avx512" };
+
+// Widest instruction set the CPU supports
+BatchISA batch_kernel_isa(void) {
+#if BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return BATCH_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return BATCH_ISA_AVX2;
+#endif
+    return BATCH_ISA_SCALAR;
+}
+
+const char* batch_isa_name(BatchISA isa) {
+    return isa >= 0 && isa < BATCH_ISA_COUNT ? batch_isa_names[isa] : "unknown";
+}
+
+// Batch kernel for the dimension and instruction set
+// Returns NULL if the dimension has no specialized kernel or the set is not built
+ParentKernel select_batch_parent_kernel(int dimension, BatchISA isa) {
+    if (!parent_kernel_is_specialized(dimension) || isa < 0 || isa >= BATCH_ISA_COUNT) return NULL;
+    if (!BATCH_X86 && isa != BATCH_ISA_SCALAR) return NULL;
+    return batch_kernels[isa][dimension - IST_KERNEL_MIN_DIMENSION];
+}
@@ -0,0 +1,231 @@
+#include "ist_kernels.h"
+#include "ist_timeline.h"
+#include "utils.h"
+#include <stdlib.h>
+
+// Helpers are force-inlined into every specialized kernel, where n is a
+// compile-time constant; this is what lets the compiler unroll their loops
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+// k! for k = 0..IST_KERNEL_MAX_DIMENSION
+static const int kernel_factorials[IST_KERNEL_MAX_DIMENSION + 1] = {
+    1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880, 3628800, 39916800, 479001600
+};
+
+// Lehmer digits, symbols and inverse (position of each symbol) of vertex index
+KERNEL_INLINE void kernel_unrank(int index, int* digits, int* elements, int* inverse, const int n) {
+    #pragma GCC unroll 12
+    for (int i = 0; i < n; i++) {
+        digits[i] = (index / kernel_factorials[n - 1 - i]) % (n - i);
+    }
+    
+    // Bit s-1 is set while symbol s is unused; take the digit-th set bit
+    unsigned int available = (1u << n) - 1;
+    #pragma GCC unroll 12
+    for (int i = 0; i < n; i++) {
+        unsigned int mask = available;
+        for (int d = digits[i]; d > 0; d--) {
+            mask &= mask - 1;
+        }
+        int bit = __builtin_ctz(mask);
+        elements[i] = bit + 1;
+        inverse[bit] = i + 1;
+        available &= ~(1u << bit);
+    }
+}
+
+// find_position: 1-based position of symbol, read from the inverse
+KERNEL_INLINE int kernel_find(const int* inverse, int symbol) {
+    return inverse[symbol - 1];
+}
+
+// right_position: 1-based position of the rightmost symbol out of place
+KERNEL_INLINE int kernel_right_position(const int* elements, const int n) {
+    #pragma GCC unroll 12
+    for (int i = n - 1; i >= 0; i--) {
+        if (elements[i] != i + 1) return i + 1;
+    }
+    return 0;
+}
+
+// is_swap_identity without the copy: swapping symbol at position p (1-based)
+// with its right neighbor gives the identity iff the pair is (p+1, p) and
+// every other symbol is fixed
+KERNEL_INLINE int kernel_swap_is_identity(const int* elements, const int* inverse, int symbol, const int n) {
+    int p = kernel_find(inverse, symbol) - 1;
+    if (p + 1 >= n) return 0;
+    
+    int identity = 1;
+    #pragma GCC unroll 12
+    for (int i = 0; i < n; i++) {
+        int expected = i == p ? p + 2 : (i == p + 1 ? p + 1 : i + 1);
+        identity &= elements[i] == expected;
+    }
+    return identity;
+}
+
+// Swap position (1-based) that Parent1 applies to vertex elements in tree t
+KERNEL_INLINE int kernel_parent_position(const int* elements, const int* inverse, int t, const int n) {
+    int last = elements[n - 1];
+    int second = elements[n - 2];
+    
+    // Case A: last symbol is n
+    if (last == n) {
+        if (t == n - 1) return n - 1;                               // A.2
+        if (t == 2 && kernel_swap_is_identity(elements, inverse, 2, n)) {
+            return kernel_find(inverse, 1);                         // A.1.2
+        }
+        if (second == t || second == n - 1) {
+            return kernel_find(inverse, kernel_right_position(elements, n)); // A.1.1.1
+        }
+        return kernel_find(inverse, t);                             // A.1.1.2
+    }
+    
+    // Case B: last symbol is n-1
+    if (last == n - 1) {
+        if (second != n || kernel_swap_is_identity(elements, inverse, n, n)) {
+            return kernel_find(inverse, last == t ? n : t);         // B.1.1, B.1.2
+        }
+        return kernel_find(inverse, t != 1 ? t - 1 : n);            // B.2.1, B.2.2
+    }
+    
+    // Case C: last symbol is in 1..n-2
+    return kernel_find(inverse, last == t ? n : t);                 // C.1, C.2
+}
+
+// adjacent_swap_index with the Lehmer digits of the vertex at hand
+KERNEL_INLINE int kernel_neighbor_index(int index, const int* digits, int position, const int n) {
+    int i = position - 1;
+    int d0 = digits[i];
+    int d1 = digits[i + 1];
+    int new_d0 = d0 <= d1 ? d1 + 1 : d1;
+    int new_d1 = d0 <= d1 ? d0 : d0 - 1;
+    
+    return index + (new_d0 - d0) * kernel_factorials[n - 1 - i]
+                 + (new_d1 - d1) * kernel_factorials[n - 2 - i];
+}
+
+// Body of every specialized kernel
+KERNEL_INLINE void kernel_range(IndependentSpanningTrees* ists, int start, int end,
+                                KernelTimes* times, const int n) {
+    int digits[IST_KERNEL_MAX_DIMENSION] = { 0 };
+    int elements[IST_KERNEL_MAX_DIMENSION];
+    int inverse[IST_KERNEL_MAX_DIMENSION] = { 0 };
+    int* parents[IST_KERNEL_MAX_DIMENSION] = { NULL };
+    
+    #pragma GCC unroll 12
+    for (int t = 0; t < n - 1; t++) {
+        parents[t] = ists->trees[t].parent;
+    }
+    
+    for (int v = start; v < end; v++) {
+        // The root (identity permutation, index 0) has no parent
+        if (v == 0) continue;
+        
+        double unrank_start = times ? timeline_now() : 0.0;
+        kernel_unrank(v, digits, elements, inverse, n);
+        double parent_start = times ? timeline_now() : 0.0;
+        
+        #pragma GCC unroll 12
+        for (int t = 1; t < n; t++) {
+            int position = kernel_parent_position(elements, inverse, t, n);
+            parents[t - 1][v] = kernel_neighbor_index(v, digits, position, n);
+        }
+        
+        if (times) {
+            times->unrank += parent_start - unrank_start;
+            times->parent += timeline_now() - parent_start;
+        }
+    }
+}
+
+#define DEFINE_PARENT_KERNEL(N) \
+    static void parent_kernel_##N(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) { \
+        kernel_range(ists, start, end, times, N); \
+    }
+
+DEFINE_PARENT_KERNEL(4)
+DEFINE_PARENT_KERNEL(5)
+DEFINE_PARENT_KERNEL(6)
+DEFINE_PARENT_KERNEL(7)
+DEFINE_PARENT_KERNEL(8)
+DEFINE_PARENT_KERNEL(9)
+DEFINE_PARENT_KERNEL(10)
+DEFINE_PARENT_KERNEL(11)
+DEFINE_PARENT_KERNEL(12)
+
+// Indexed by dimension - IST_KERNEL_MIN_DIMENSION
+static const ParentKernel specialized_kernels[IST_KERNEL_MAX_DIMENSION - IST_KERNEL_MIN_DIMENSION + 1] = {
+    parent_kernel_4, parent_kernel_5, parent_kernel_6, parent_kernel_7, parent_kernel_8,
+    parent_kernel_9, parent_kernel_10, parent_kernel_11, parent_kernel_12
+};
+
+// The specialized kernel body with n known only at run time, for measuring
+// what specialization itself gains (dimensions 3..IST_KERNEL_MAX_DIMENSION)
+void runtime_parent_kernel(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) {
+    int n = ists->tree_count + 1;
+    if (n < 3 || n > IST_KERNEL_MAX_DIMENSION) {
+        generic_parent_kernel(ists, start, end, times);
+        return;
+    }
+    kernel_range(ists, start, end, times, n);
+}
+
+// Parents of vertices [start, end) through Parent1, for any dimension
+void generic_parent_kernel(IndependentSpanningTrees* ists, int start, int end, KernelTimes* times) {
+    int n = ists->tree_count + 1;
+    
+    for (int v = start; v < end; v++) {
+        double unrank_start = times ? timeline_now() : 0.0;
+        Permutation* perm = index_to_permutation(v, n);
+        double parent_start = times ? timeline_now() : 0.0;
+        if (times) times->unrank += parent_start - unrank_start;
+        
+        // Skip the root (identity permutation)
+        if (is_identity_permutation(perm)) {
+            free_permutation(perm);
+            continue;
+        }
+        
+        // Determine parent in each tree
+        for (int t = 0; t < n - 1; t++) {
+            Permutation* parent = Parent1(perm, t + 1, n); // t+1 because tree indices start at 1
+            ists->trees[t].parent[v] = permutation_to_index(parent, n);
+            free_permutation(parent);
+        }
+        
+        free_permutation(perm);
+        if (times) times->parent += timeline_now() - parent_start;
+    }
+}
+
+// Whether a specialized kernel exists for the dimension
+int parent_kernel_is_specialized(int dimension) {
+    return dimension >= IST_KERNEL_MIN_DIMENSION && dimension <= IST_KERNEL_MAX_DIMENSION;
+}
+
+// Scalar kernel for a network of the given dimension
+// A PROFILE=1 build always takes Parent1, the only path with case counters
+ParentKernel select_scalar_parent_kernel(int dimension) {
+#ifdef IST_PROFILE_CASES
+    (void)dimension;
+    return generic_parent_kernel;
+#endif
+    if (parent_kernel_is_specialized(dimension)) {
+        return specialized_kernels[dimension - IST_KERNEL_MIN_DIMENSION];
+    }
+    return generic_parent_kernel;
+}
+
+// Kernel to use for a network of the given dimension; call once per run
+// The batch kernel is used where the CPU has vector instructions for it
+ParentKernel select_parent_kernel(int dimension) {
+#ifdef IST_PROFILE_CASES
+    return select_scalar_parent_kernel(dimension);
+#endif
+    BatchISA isa = batch_kernel_isa();
+    if (isa != BATCH_ISA_SCALAR && parent_kernel_is_specialized(dimension)) {
+        return select_batch_parent_kernel(dimension, isa);
+    }
+    return select_scalar_parent_kernel(dimension);
+}
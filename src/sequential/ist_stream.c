@@ -0,0 +1,194 @@
+#include "ist_stream.h"
+#include "ist_algorithm.h"
+#include "ist_kernels.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Shared state between the producer (construction) and the writer thread
+// Two blocks are used alternately: while the writer drains one, the
+// producer fills the other
+typedef struct {
+    ISTBlock blocks[2];     // Double-buffered blocks
+    int ready[2];           // Block is filled and waiting for the writer
+    int done;               // Producer has no more blocks
+    int failed;             // Sink reported an error
+    ISTBlockSink sink;
+    void* user_data;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} StreamState;
+
+// Writer thread: hand blocks to the sink in the order they were produced
+static void* stream_writer(void* arg) {
+    StreamState* state = (StreamState*)arg;
+    int next = 0;
+    
+    for (;;) {
+        pthread_mutex_lock(&state->lock);
+        while (!state->ready[next] && !state->done) {
+            pthread_cond_wait(&state->cond, &state->lock);
+        }
+        if (!state->ready[next]) {
+            // Producer finished and every block has been written
+            pthread_mutex_unlock(&state->lock);
+            break;
+        }
+        pthread_mutex_unlock(&state->lock);
+        
+        int ok = state->sink(&state->blocks[next], state->user_data);
+        
+        pthread_mutex_lock(&state->lock);
+        state->ready[next] = 0;
+        if (!ok) state->failed = 1;
+        pthread_cond_broadcast(&state->cond);
+        pthread_mutex_unlock(&state->lock);
+        
+        if (!ok) break;
+        next ^= 1;
+    }
+    
+    return NULL;
+}
+
+// Fill a block with the parents of count vertices, starting from first_vertex
+// kernel writes tree-major parents into scratch, whose trees cover one block;
+// they are then transposed into the vertex-major records of the block
+static void fill_block(ISTBlock* block, ParentKernel kernel, IndependentSpanningTrees* scratch,
+                       int* scratch_parents, int block_vertices, int first_vertex, int count) {
+    int tree_count = block->tree_count;
+    
+    block->first_vertex = first_vertex;
+    block->vertex_count = count;
+    
+    // Kernels index parents by vertex, so tree t is viewed from vertex 0
+    for (int t = 0; t < tree_count; t++) {
+        scratch->trees[t].parent = scratch_parents + (size_t)t * block_vertices - first_vertex;
+    }
+    kernel(scratch, first_vertex, first_vertex + count, NULL);
+    
+    for (int t = 0; t < tree_count; t++) {
+        const int* parent = scratch_parents + (size_t)t * block_vertices;
+        for (int i = 0; i < count; i++) {
+            block->parents[i * tree_count + t] = parent[i];
+        }
+    }
+    
+    // The root (identity permutation) has no parent; kernels leave it unset
+    if (first_vertex == 0) {
+        for (int t = 0; t < tree_count; t++) {
+            block->parents[t] = -1;
+        }
+    }
+}
+
+// Construct n-1 independent spanning trees without materializing them
+// Vertices are walked in index order and their parents are passed to sink in
+// blocks of block_vertices vertices; memory use is O(block_vertices * n)
+// Returns 1 on success, 0 on failure
+int construct_streaming_ists(int dimension, int block_vertices,
+                             ISTBlockSink sink, void* user_data) {
+    if (dimension < 3 || dimension > IST_STREAM_MAX_DIMENSION || !sink) return 0;
+    if (block_vertices <= 0) block_vertices = IST_STREAM_DEFAULT_BLOCK;
+    
+    int vertex_count = factorial(dimension);
+    if (block_vertices > vertex_count) block_vertices = vertex_count;
+    
+    StreamState state;
+    state.ready[0] = state.ready[1] = 0;
+    state.done = 0;
+    state.failed = 0;
+    state.sink = sink;
+    state.user_data = user_data;
+    
+    for (int b = 0; b < 2; b++) {
+        state.blocks[b].dimension = dimension;
+        state.blocks[b].tree_count = dimension - 1;
+        state.blocks[b].first_vertex = 0;
+        state.blocks[b].vertex_count = 0;
+        state.blocks[b].parents = (int*)malloc((size_t)block_vertices * (dimension - 1) * sizeof(int));
+    }
+    
+    // Tree-major scratch for the kernel, one block per tree
+    ParentKernel kernel = select_parent_kernel(dimension);
+    IndependentSpanningTrees scratch;
+    scratch.tree_count = dimension - 1;
+    scratch.trees = (SpanningTree*)malloc((dimension - 1) * sizeof(SpanningTree));
+    int* scratch_parents = (int*)malloc((size_t)block_vertices * (dimension - 1) * sizeof(int));
+    if (!state.blocks[0].parents || !state.blocks[1].parents || !scratch.trees || !scratch_parents) {
+        free(state.blocks[0].parents);
+        free(state.blocks[1].parents);
+        free(scratch.trees);
+        free(scratch_parents);
+        return 0;
+    }
+    for (int t = 0; t < dimension - 1; t++) {
+        scratch.trees[t].vertex_count = vertex_count;
+    }
+    
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.cond, NULL);
+    
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, stream_writer, &state) != 0) {
+        pthread_mutex_destroy(&state.lock);
+        pthread_cond_destroy(&state.cond);
+        free(state.blocks[0].parents);
+        free(state.blocks[1].parents);
+        free(scratch.trees);
+        free(scratch_parents);
+        return 0;
+    }
+    
+    // Produce blocks, alternating between the two buffers
+    int current = 0;
+    for (int first = 0; first < vertex_count; first += block_vertices) {
+        int count = vertex_count - first < block_vertices ? vertex_count - first : block_vertices;
+        
+        // Wait until the writer has released this buffer
+        pthread_mutex_lock(&state.lock);
+        while (state.ready[current] && !state.failed) {
+            pthread_cond_wait(&state.cond, &state.lock);
+        }
+        int failed = state.failed;
+        pthread_mutex_unlock(&state.lock);
+        if (failed) break;
+        
+        fill_block(&state.blocks[current], kernel, &scratch, scratch_parents, block_vertices, first, count);
+        
+        pthread_mutex_lock(&state.lock);
+        state.ready[current] = 1;
+        pthread_cond_broadcast(&state.cond);
+        pthread_mutex_unlock(&state.lock);
+        
+        current ^= 1;
+    }
+    
+    // Let the writer drain the remaining blocks
+    pthread_mutex_lock(&state.lock);
+    state.done = 1;
+    pthread_cond_broadcast(&state.cond);
+    pthread_mutex_unlock(&state.lock);
+    pthread_join(writer, NULL);
+    
+    int success = !state.failed;
+    
+    pthread_mutex_destroy(&state.lock);
+    pthread_cond_destroy(&state.cond);
+    free(state.blocks[0].parents);
+    free(state.blocks[1].parents);
+    free(scratch.trees);
+    free(scratch_parents);
+    
+    return success;
+}
+
+// Sink writing raw parent records to a FILE* (file, pipe or compressor)
+// Records are written as native ints in the vertex-major order of ISTBlock
+int file_block_sink(const ISTBlock* block, void* user_data) {
+    FILE* out = (FILE*)user_data;
+    size_t count = (size_t)block->vertex_count * block->tree_count;
+    
+    return fwrite(block->parents, sizeof(int), count, out) == count;
+}
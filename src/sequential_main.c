@@ -71,13 +71,113 @@
 #include "bubble_sort_network.h"
 #include "ist_algorithm.h"
 #include "utils.h"
+#include "ist_stream.h"
+#include "ist_io.h"
+#include "ist_archive.h"
+#include "ist_profile.h"
+#include "ist_depth.h"
+#include "ist_children.h"
+#include "ist_reroot.h"
+#include "ist_memory.h"
+#include "ist_sample.h"
+#include "ist_digest.h"
+#include "ist_congestion.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Print the Parent1 case counters and optionally write them as JSON
+static void report_profile(FILE* log, int dimension, const char* path) {
+    if (!ist_profile_enabled()) {
+        if (path) fprintf(log, "Case profiling is not compiled in (build with make PROFILE=1)\n");
+        return;
+    }
+    
+    uint64_t profile[IST_PROFILE_COUNTERS];
+    int threads = ist_profile_collect(profile);
+    
+    fprintf(log, "\n");
+    ist_profile_print(log, profile);
+    if (path && !ist_profile_write_json(path, profile, dimension, 1, threads)) {
+        fprintf(log, "Failed to write profile to %s\n", path);
+    }
+}
+
+// Stream the trees into a binary IST file without building the network
+// digest is set to the digest of the streamed trees
+static int run_streaming_to_ist_file(int dimension, const char* path, int block_vertices, uint64_t* digest) {
+    ISTFileWriter* writer = open_ists_file_writer(path, dimension);
+    if (!writer) {
+        printf("Failed to open %s\n", path);
+        return 1;
+    }
+    
+    printf("Streaming %d independent spanning trees of B_%d (%d vertices) into %s...\n",
+           dimension - 1, dimension, factorial(dimension), path);
+    
+    double start_time = measure_time();
+    DigestSink digest_sink = { ists_file_block_sink, writer, 0 };
+    int ok = construct_streaming_ists(dimension, block_vertices, digest_block_sink, &digest_sink);
+    if (!close_ists_file_writer(writer)) ok = 0;
+    double end_time = measure_time();
+    
+    if (!ok) {
+        printf("Failed to stream ISTs\n");
+        return 1;
+    }
+    
+    printf("ISTs streamed in %.6f seconds\n", end_time - start_time);
+    *digest = digest_sink.digest;
+    return 0;
+}
+
+// Stream the trees to a file (or stdout for "-") without building the network
+// digest is set to the digest of the streamed trees
+static int run_streaming(int dimension, const char* path, const char* format, int block_vertices,
+                         uint64_t* digest) {
+    if (strcmp(format, "ist") == 0) {
+        return run_streaming_to_ist_file(dimension, path, block_vertices, digest);
+    }
+    
+    FILE* out = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+    FILE* log = out == stdout ? stderr : stdout;
+    
+    if (!out) {
+        fprintf(log, "Failed to open %s\n", path);
+        return 1;
+    }
+    
+    fprintf(log, "Streaming %d independent spanning trees of B_%d (%d vertices) in blocks of %d vertices...\n",
+            dimension - 1, dimension, factorial(dimension), block_vertices);
+    
+    double start_time = measure_time();
+    DigestSink digest_sink = { file_block_sink, out, 0 };
+    int ok = construct_streaming_ists(dimension, block_vertices, digest_block_sink, &digest_sink);
+    if (fflush(out) != 0) ok = 0;
+    double end_time = measure_time();
+    
+    if (out != stdout) fclose(out);
+    
+    if (!ok) {
+        fprintf(log, "Failed to stream ISTs\n");
+        return 1;
+    }
+    
+    fprintf(log, "ISTs streamed in %.6f seconds\n", end_time - start_time);
+    *digest = digest_sink.digest;
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
     // Check command line arguments
     if (argc < 2) {
-        printf("Usage: %s <dimension>\n", argv[0]);
+        printf("Usage: %s <dimension> [--stream <file|-> [--format raw|ist] [--block <vertices>]]\n"
+               "       [--output <file.ist>] [--archive <file.istz>] [--input <file.ist|file.istz>]\n"
+               "       [--profile-json <file>] [--depth] [--depth-json <file>] [--broadcast] [--root <vertex>]\n"
+               "       [--congestion] [--congestion-top <k>] [--congestion-json <file>]\n"
+               "       [--storage auto|full|trees|stream] [--memory-limit <MiB>] [--plan]\n"
+               "       [--verify auto|full|sample|none] [--samples <K>] [--seed <S>] [--sample-vertex <v>]\n"
+               "       [--expect-digest <hex>]\n", argv[0]);
         return 1;
     }
     
@@ -87,11 +187,169 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    printf("Creating bubble-sort network B_%d with %d vertices...\n", 
-           dimension, factorial(dimension));
+    const char* stream_path = NULL;
+    const char* stream_format = "raw";
+    const char* output_path = NULL;
+    const char* input_path = NULL;
+    const char* archive_path = NULL;
+    const char* profile_path = NULL;
+    const char* depth_path = NULL;
+    const char* congestion_path = NULL;
+    int congestion = 0;
+    int congestion_top = IST_CONGESTION_DEFAULT_TOP;
+    int depth = 0;
+    int broadcast = 0;
+    int root = -1;
+    int block_vertices = IST_STREAM_DEFAULT_BLOCK;
+    StorageMode storage = STORAGE_AUTO;
+    uint64_t memory_limit = 0;
+    int plan_only = 0;
+    VerifyMode verify = VERIFY_AUTO;
+    SampleOptions sample_options;
+    init_sample_options(&sample_options);
+    int verify_given = 0;
+    int sampling = 0;
+    uint64_t expected_digest;
+    int expect_digest = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            stream_path = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            stream_format = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+            archive_path = argv[++i];
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+            block_vertices = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--profile-json") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--depth") == 0) {
+            depth = 1;
+        } else if (strcmp(argv[i], "--depth-json") == 0 && i + 1 < argc) {
+            depth_path = argv[++i];
+            depth = 1;
+        } else if (strcmp(argv[i], "--broadcast") == 0) {
+            broadcast = 1;
+        } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--congestion") == 0) {
+            congestion = 1;
+        } else if (strcmp(argv[i], "--congestion-top") == 0 && i + 1 < argc) {
+            congestion_top = atoi(argv[++i]);
+            congestion = 1;
+        } else if (strcmp(argv[i], "--congestion-json") == 0 && i + 1 < argc) {
+            congestion_path = argv[++i];
+            congestion = 1;
+        } else if (strcmp(argv[i], "--storage") == 0 && i + 1 < argc) {
+            if (!parse_storage_mode(argv[++i], &storage)) {
+                printf("Unknown storage mode: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc) {
+            memory_limit = (uint64_t)atof(argv[++i]) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--plan") == 0) {
+            plan_only = 1;
+        } else if (strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            if (!parse_verify_mode(argv[++i], &verify)) {
+                printf("Unknown verification mode: %s\n", argv[i]);
+                return 1;
+            }
+            verify_given = 1;
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            sample_options.samples = atoi(argv[++i]);
+            sampling = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            sample_options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--sample-vertex") == 0 && i + 1 < argc) {
+            if (!add_sample_vertex(&sample_options, atoi(argv[++i]))) {
+                printf("At most %d vertices can be given with --sample-vertex\n", IST_SAMPLE_MAX_VERTICES);
+                return 1;
+            }
+            sampling = 1;
+        } else if (strcmp(argv[i], "--expect-digest") == 0 && i + 1 < argc) {
+            if (!parse_digest(argv[++i], &expected_digest)) {
+                printf("Invalid digest: %s\n", argv[i]);
+                return 1;
+            }
+            expect_digest = 1;
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    // --samples and --sample-vertex ask for sampling unless --verify says otherwise
+    if (sampling && !verify_given) verify = VERIFY_SAMPLE;
+    if (sample_options.samples < 0) {
+        printf("The number of samples must not be negative\n");
+        return 1;
+    }
+    
+    if (stream_path) {
+        if (dimension > IST_STREAM_MAX_DIMENSION) {
+            printf("Dimension must be at most %d\n", IST_STREAM_MAX_DIMENSION);
+            return 1;
+        }
+        if (strcmp(stream_format, "raw") != 0 && strcmp(stream_format, "ist") != 0) {
+            printf("Unknown stream format: %s\n", stream_format);
+            return 1;
+        }
+        storage = STORAGE_STREAM;
+    }
+    
+    // Plan the memory of the run before anything large is allocated; without
+    // --stream, streaming is a fallback that writes the --output file
+    MemoryNeeds needs;
+    init_memory_needs(&needs, dimension);
+    needs.depth = depth;
+    needs.broadcast = broadcast;
+    needs.reroot = root >= 0;
+    needs.congestion = congestion;
+    needs.verify = verify == VERIFY_AUTO || verify == VERIFY_FULL;
+    if (dimension <= IST_STREAM_MAX_DIMENSION && (stream_path || (output_path && !input_path && !archive_path))) {
+        needs.stream_block = block_vertices;
+    }
+    
+    MemoryPlan plan;
+    plan_memory(&needs, storage, memory_limit, &plan);
+    int to_stdout = stream_path && strcmp(stream_path, "-") == 0 && strcmp(stream_format, "raw") == 0;
+    FILE* log = to_stdout ? stderr : stdout;
+    print_memory_plan(log, &plan);
+    if (plan_only) return plan.fits ? 0 : 1;
+    if (!accept_memory_plan(log, &plan, storage, dimension)) return 1;
+    fprintf(log, "\n");
+    
+    if (plan.mode == STORAGE_STREAM) {
+        uint64_t digest = 0;
+        int status = stream_path ? run_streaming(dimension, stream_path, stream_format, block_vertices, &digest)
+                                 : run_streaming(dimension, output_path, "ist", block_vertices, &digest);
+        report_profile(log, dimension, profile_path);
+        
+        // The streamed trees are gone, so the sampler recomputes their parents
+        if (status == 0) {
+            if (!report_digest(log, digest, expect_digest ? &expected_digest : NULL)) status = 1;
+            verify_ists(log, verify, NULL, NULL, dimension, &sample_options);
+        }
+        report_peak_rss(log, &plan, peak_rss());
+        return status;
+    }
+    
+    
+    if (plan.mode == STORAGE_FULL) {
+        printf("Creating bubble-sort network B_%d with %d vertices...\n", 
+               dimension, factorial(dimension));
+    } else {
+        printf("Using B_%d with %d vertices without building its edges...\n",
+               dimension, factorial(dimension));
+    }
     
+    // In trees mode only the dimension is kept, there are no edges to verify against
     double start_time = measure_time();
-    BubbleSortNetwork* network = create_bubble_sort_network(dimension);
+    BubbleSortNetwork* network = plan.mode == STORAGE_FULL ? create_bubble_sort_network(dimension)
+                                                           : create_bubble_sort_network_shape(dimension);
     double end_time = measure_time();
     
     if (!network) {
@@ -119,18 +377,73 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    printf("\nConstructing %d independent spanning trees...\n", dimension - 1);
-    start_time = measure_time();
-    IndependentSpanningTrees* ists = construct_sequential_ists(network);
-    end_time = measure_time();
+    IndependentSpanningTrees* ists = NULL;
+    MappedISTs* mapped = NULL;
     
-    if (!ists) {
-        printf("Failed to construct ISTs\n");
-        free_bubble_sort_network(network);
-        return 1;
+    if (input_path) {
+        // Use previously computed trees in place instead of constructing them
+        printf("\nLoading independent spanning trees from %s...\n", input_path);
+        start_time = measure_time();
+        mapped = map_ists_file(input_path, 1);
+        if (mapped) {
+            ists = &mapped->ists;
+        } else {
+            // Not a plain IST file, try a compressed archive
+            ISTArchive* archive = open_ist_archive(input_path, 1);
+            if (archive) {
+                ists = ist_archive_extract(archive);
+                close_ist_archive(archive);
+            }
+        }
+        end_time = measure_time();
+        
+        if (!ists || ists->tree_count != dimension - 1) {
+            printf("Failed to load ISTs for B_%d from %s\n", dimension, input_path);
+            if (mapped) {
+                unmap_ists_file(mapped);
+            } else {
+                free_ists(ists);
+            }
+            free_bubble_sort_network(network);
+            return 1;
+        }
+        
+        printf("ISTs loaded in %.6f seconds\n", end_time - start_time);
+    } else {
+        printf("\nConstructing %d independent spanning trees...\n", dimension - 1);
+        start_time = measure_time();
+        ists = construct_sequential_ists(network);
+        end_time = measure_time();
+        
+        if (!ists) {
+            printf("Failed to construct ISTs\n");
+            free_bubble_sort_network(network);
+            return 1;
+        }
+        
+        printf("ISTs constructed in %.6f seconds\n", end_time - start_time);
+        report_profile(stdout, dimension, profile_path);
     }
     
-    printf("ISTs constructed in %.6f seconds\n", end_time - start_time);
+    int status = report_digest(stdout, digest_ists(ists), expect_digest ? &expected_digest : NULL) ? 0 : 1;
+    
+    if (output_path) {
+        start_time = measure_time();
+        if (write_ists_file(output_path, ists, dimension)) {
+            printf("ISTs written to %s in %.6f seconds\n", output_path, measure_time() - start_time);
+        } else {
+            printf("Failed to write ISTs to %s\n", output_path);
+        }
+    }
+    
+    if (archive_path) {
+        start_time = measure_time();
+        if (write_ist_archive(archive_path, ists, dimension, IST_ARCHIVE_DEFAULT_BLOCK)) {
+            printf("ISTs archived to %s in %.6f seconds\n", archive_path, measure_time() - start_time);
+        } else {
+            printf("Failed to archive ISTs to %s\n", archive_path);
+        }
+    }
     
     // Print a small example tree if dimension is small
     if (dimension <= 3) {
@@ -140,77 +453,31 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    // Verify the spanning trees
-    printf("\nVerifying spanning trees...\n");
-    int valid = 1;
-    for (int t = 0; t < dimension - 1; t++) {
-        if (!verify_spanning_tree(&ists->trees[t], network)) {
-            printf("Tree %d is not a valid spanning tree\n", t + 1);
-            valid = 0;
-            break;
-        }
+    if (depth) {
+        report_tree_depths(stdout, ists, dimension, depth_path);
     }
-    
-    if (valid) {
-        printf("All trees are valid spanning trees\n");
-        
-        // Verify independence
-        printf("\nVerifying independence...\n");
-        if (!verify_independence(ists, network)) {
-            printf("Trees are not independent\n");
-            valid = 0;
-        } else {
-            printf("All trees are independent\n");
-        }
+    if (broadcast) {
+        report_broadcast(stdout, ists);
     }
-    
-    if (valid) {
-        printf("\nSuccessfully constructed %d valid independent spanning trees\n", dimension - 1);
+    if (root >= 0) {
+        report_reroot(stdout, ists, dimension, root);
     }
-    
-    // Example path from a specific vertex to root in each tree
-    if (dimension == 4) {
-        // Example vertex: 4231 (as in Fig. 3 of the paper)
-        int example_index = -1;
-        for (int i = 0; i < network->vertex_count; i++) {
-            Permutation* perm = index_to_permutation(i, dimension);
-            if (perm->elements[0] == 4 && perm->elements[1] == 2 && 
-                perm->elements[2] == 3 && perm->elements[3] == 1) {
-                example_index = i;
-                free_permutation(perm);
-                break;
-            }
-            free_permutation(perm);
-        }
-        
-        if (example_index != -1) {
-            printf("\nExample paths from vertex 4231 to root in each tree:\n");
-            for (int t = 0; t < dimension - 1; t++) {
-                printf("Tree T_%d: ", t+1);
-                
-                // Trace path to root
-                int current = example_index;
-                while (current != 0) {  // 0 is the identity permutation
-                    Permutation* perm = index_to_permutation(current, dimension);
-                    print_permutation(perm);
-                    printf(" -> ");
-                    free_permutation(perm);
-                    
-                    current = ists->trees[t].parent[current];
-                }
-                
-                // Print root
-                Permutation* root = index_to_permutation(0, dimension);
-                print_permutation(root);
-                printf("\n");
-                free_permutation(root);
-            }
-        }
+    if (congestion) {
+        report_congestion(stdout, ists, dimension, congestion_top, congestion_path);
     }
     
+    // Without network edges (trees mode) the trees are sampled
+    verify_ists(stdout, verify, ists, network, dimension, &sample_options);
+    print_example_paths(ists, dimension);
+    report_peak_rss(stdout, &plan, peak_rss());
+    
     // Clean up
-    free_ists(ists);
+    if (mapped) {
+        unmap_ists_file(mapped);
+    } else {
+        free_ists(ists);
+    }
     free_bubble_sort_network(network);
     
-    return 0;
+    return status;
 }
\ No newline at end of file
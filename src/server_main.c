@@ -0,0 +1,134 @@
+#include "bubble_sort_network.h"
+#include "ist_algorithm.h"
+#include "utils.h"
+#include "ist_io.h"
+#include "ist_context.h"
+#include "ist_server.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Local IST query daemon
+//
+// Loads or builds the trees of one dimension once and answers batched parent,
+// all-parents and path queries over a Unix domain socket until SIGINT or
+// SIGTERM (protocol in include/ist_server.h; ist_query is the load generator).
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+int main(int argc, char* argv[]) {
+    // Check command line arguments
+    if (argc < 2) {
+        printf("Usage: %s <dimension> [--socket <path>] [--input <file.ist>] [--construct] [--threads <count>]\n",
+               argv[0]);
+        return 1;
+    }
+    
+    int dimension = atoi(argv[1]);
+    if (dimension < 3 || dimension > IST_CONTEXT_MAX_DIMENSION) {
+        printf("Dimension must be between 3 and %d\n", IST_CONTEXT_MAX_DIMENSION);
+        return 1;
+    }
+    
+    const char* socket_path = "/tmp/ist.sock";
+    const char* input_path = NULL;
+    int construct = 0;
+    int threads = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--construct") == 0) {
+            construct = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    if (input_path && construct) {
+        printf("--input and --construct cannot be used together\n");
+        return 1;
+    }
+    
+    ISTQuerySource source;
+    source.kind = IST_SOURCE_COMPUTED;
+    source.dimension = dimension;
+    source.vertex_count = factorial(dimension);
+    source.tree_count = dimension - 1;
+    source.ists = NULL;
+    MappedISTs* mapped = NULL;
+    ISTContext* context = NULL;
+    
+    double start_time = measure_time();
+    if (input_path) {
+        // Mapped in place, so the pages are shared with other readers of the file
+        mapped = map_ists_file(input_path, 1);
+        if (!mapped || mapped->ists.tree_count != dimension - 1) {
+            printf("Failed to map ISTs for B_%d from %s\n", dimension, input_path);
+            unmap_ists_file(mapped);
+            return 1;
+        }
+        source.kind = IST_SOURCE_MAPPED;
+        source.ists = &mapped->ists;
+        printf("Mapped %s in %.6f seconds\n", input_path, measure_time() - start_time);
+    } else if (construct) {
+        context = create_ist_context(threads);
+        source.ists = context ? ist_context_construct(context, dimension) : NULL;
+        if (!source.ists) {
+            printf("Failed to construct ISTs\n");
+            free_ist_context(context);
+            return 1;
+        }
+        source.kind = IST_SOURCE_BUILT;
+        printf("ISTs constructed in %.6f seconds\n", measure_time() - start_time);
+    }
+    
+    int listen_fd = open_ist_server(socket_path);
+    if (listen_fd < 0) {
+        printf("Failed to listen on %s\n", socket_path);
+        if (mapped) unmap_ists_file(mapped);
+        free_ist_context(context);
+        return 1;
+    }
+    
+    // No SA_RESTART, so a signal also ends the wait of the accept loop
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    
+    printf("Serving %d trees of B_%d (%d vertices, %s) on %s\n", source.tree_count, dimension,
+           source.vertex_count, ist_source_kind_name(source.kind), socket_path);
+    fflush(stdout);
+    
+    ISTServerStats stats;
+    start_time = measure_time();
+    int ok = run_ist_server(listen_fd, &source, &stop_requested, &stats);
+    double seconds = measure_time() - start_time;
+    
+    close(listen_fd);
+    unlink(socket_path);
+    
+    printf("\nServed %llu requests (%llu lookups, %llu errors) on %llu connections in %.1f seconds\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.lookups,
+           (unsigned long long)stats.errors, (unsigned long long)stats.connections, seconds);
+    
+    // Clean up
+    if (mapped) unmap_ists_file(mapped);
+    free_ist_context(context);
+    
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+#include "ist_checkpoint.h"
+#include "utils.h"
+#include "ist_timeline.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Header of a range file, followed by tree-major parents of the range
+typedef struct {
+    char magic[8];              // IST_CHECKPOINT_MAGIC
+    uint32_t dimension;         // Dimension n of B_n
+    uint32_t tree_count;        // Number of trees (n-1)
+    int32_t start;              // First vertex of the range
+    int32_t end;                // One past the last vertex of the range
+    uint64_t checksum;          // FNV-1a over the parents
+} CheckpointFileHeader;
+
+// Path of this rank's manifest
+static void manifest_path(ISTCheckpoint* checkpoint, char* path) {
+    snprintf(path, IST_CHECKPOINT_PATH_MAX, "%s/manifest_rank%d.txt",
+             checkpoint->dir, checkpoint->rank);
+}
+
+// Path of the file holding one range
+static void range_path(ISTCheckpoint* checkpoint, int start, int end, char* path) {
+    snprintf(path, IST_CHECKPOINT_PATH_MAX, "%s/rank%d_%d_%d.chk",
+             checkpoint->dir, checkpoint->rank, start, end);
+}
+
+// Insert a completed range, keeping the list sorted by start
+static int add_range(ISTCheckpoint* checkpoint, int start, int end) {
+    if (checkpoint->range_count == checkpoint->range_capacity) {
+        int capacity = checkpoint->range_capacity ? 2 * checkpoint->range_capacity : 16;
+        VertexRange* ranges = (VertexRange*)realloc(checkpoint->ranges, capacity * sizeof(VertexRange));
+        if (!ranges) return 0;
+        checkpoint->ranges = ranges;
+        checkpoint->range_capacity = capacity;
+    }
+    
+    int i = checkpoint->range_count;
+    while (i > 0 && checkpoint->ranges[i - 1].start > start) {
+        checkpoint->ranges[i] = checkpoint->ranges[i - 1];
+        i--;
+    }
+    checkpoint->ranges[i].start = start;
+    checkpoint->ranges[i].end = end;
+    checkpoint->range_count++;
+    
+    return 1;
+}
+
+// Start a fresh manifest for this run
+static int reset_manifest(ISTCheckpoint* checkpoint) {
+    char path[IST_CHECKPOINT_PATH_MAX];
+    manifest_path(checkpoint, path);
+    
+    FILE* manifest = fopen(path, "w");
+    if (!manifest) return 0;
+    
+    fprintf(manifest, "ist-checkpoint dimension %d ranks %d rank %d\n",
+            checkpoint->dimension, checkpoint->size, checkpoint->rank);
+    
+    int ok = fflush(manifest) == 0 && fsync(fileno(manifest)) == 0;
+    if (fclose(manifest) != 0) ok = 0;
+    return ok;
+}
+
+// Read the ranges recorded by a previous run with the same configuration
+// Returns 0 if there is no usable manifest
+static int read_manifest(ISTCheckpoint* checkpoint) {
+    char path[IST_CHECKPOINT_PATH_MAX];
+    manifest_path(checkpoint, path);
+    
+    FILE* manifest = fopen(path, "r");
+    if (!manifest) return 0;
+    
+    int dimension, size, rank;
+    if (fscanf(manifest, "ist-checkpoint dimension %d ranks %d rank %d",
+               &dimension, &size, &rank) != 3 ||
+        dimension != checkpoint->dimension || size != checkpoint->size || rank != checkpoint->rank) {
+        fclose(manifest);
+        return 0;
+    }
+    
+    int start, end;
+    while (fscanf(manifest, " range %d %d", &start, &end) == 2) {
+        if (start >= 0 && start < end && !add_range(checkpoint, start, end)) break;
+    }
+    
+    fclose(manifest);
+    return 1;
+}
+
+// Open (and optionally resume) the checkpoint of one rank
+// With resume set, ranges recorded by an identical earlier run are kept;
+// otherwise, or if the manifest does not match, a fresh manifest is started
+ISTCheckpoint* open_checkpoint(const char* dir, int dimension, int rank, int size,
+                               double interval, int resume) {
+    if (strlen(dir) >= IST_CHECKPOINT_DIR_MAX) return NULL;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return NULL;
+    
+    ISTCheckpoint* checkpoint = (ISTCheckpoint*)calloc(1, sizeof(ISTCheckpoint));
+    if (!checkpoint) return NULL;
+    
+    snprintf(checkpoint->dir, sizeof(checkpoint->dir), "%s", dir);
+    checkpoint->dimension = dimension;
+    checkpoint->rank = rank;
+    checkpoint->size = size;
+    checkpoint->interval = interval > 0 ? interval : IST_CHECKPOINT_DEFAULT_INTERVAL;
+    checkpoint->last_time = measure_time();
+    
+    if (!(resume && read_manifest(checkpoint))) {
+        checkpoint->range_count = 0;
+        if (!reset_manifest(checkpoint)) {
+            close_checkpoint(checkpoint);
+            return NULL;
+        }
+    }
+    
+    return checkpoint;
+}
+
+// Load one range file into ists; returns 1 if it is complete and intact
+static int load_range(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists, int start, int end) {
+    char path[IST_CHECKPOINT_PATH_MAX];
+    range_path(checkpoint, start, end, path);
+    
+    FILE* in = fopen(path, "rb");
+    if (!in) return 0;
+    
+    CheckpointFileHeader header;
+    int count = end - start;
+    int ok = fread(&header, sizeof(header), 1, in) == 1 &&
+             memcmp(header.magic, IST_CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+             (int)header.dimension == checkpoint->dimension &&
+             (int)header.tree_count == ists->tree_count &&
+             header.start == start && header.end == end &&
+             end <= ists->trees[0].vertex_count;
+    
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (int t = 0; t < ists->tree_count && ok; t++) {
+        int* parents = &ists->trees[t].parent[start];
+        ok = fread(parents, sizeof(int), count, in) == (size_t)count;
+        hash = fnv1a_hash(hash, parents, count * sizeof(int));
+    }
+    
+    fclose(in);
+    return ok && hash == header.checksum;
+}
+
+// Reload every recorded range into ists
+// Ranges whose file is missing or damaged are dropped and recomputed
+// Returns the number of vertices restored
+int checkpoint_restore(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists) {
+    int kept = 0;
+    int restored = 0;
+    
+    for (int i = 0; i < checkpoint->range_count; i++) {
+        VertexRange range = checkpoint->ranges[i];
+        if (load_range(checkpoint, ists, range.start, range.end)) {
+            checkpoint->ranges[kept++] = range;
+            restored += range.end - range.start;
+        }
+    }
+    
+    checkpoint->range_count = kept;
+    checkpoint->vertices_restored = restored;
+    return restored;
+}
+
+// First vertex in [from, end) that is not covered by a completed range
+// *gap_end is set to the end of the uncovered run starting there
+// Returns end if everything in [from, end) is complete
+int checkpoint_next_gap(ISTCheckpoint* checkpoint, int from, int end, int* gap_end) {
+    int v = from;
+    
+    for (int i = 0; i < checkpoint->range_count && v < end; i++) {
+        VertexRange range = checkpoint->ranges[i];
+        if (range.end <= v) continue;
+        if (range.start > v) {
+            *gap_end = range.start < end ? range.start : end;
+            return v;
+        }
+        v = range.end;
+    }
+    
+    *gap_end = end;
+    return v < end ? v : end;
+}
+
+// Whether enough time has passed since the last checkpoint
+int checkpoint_due(ISTCheckpoint* checkpoint) {
+    return measure_time() - checkpoint->last_time >= checkpoint->interval;
+}
+
+// Persist the parents of vertices [start, end) and record the range
+// The file is written under a temporary name and renamed before the manifest
+// entry is added, so the manifest only ever lists complete files
+// On failure the temporary file is removed and the failure counted; only the
+// first failure is reported, so a full disk does not flood the output
+// Returns 1 on success, 0 on failure
+int checkpoint_save_range(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists,
+                          int start, int end) {
+    if (start >= end) return 1;
+    
+    double begin = measure_time();
+    double span_start = timeline_now();
+    int count = end - start;
+    
+    char path[IST_CHECKPOINT_PATH_MAX];
+    char temp_path[IST_CHECKPOINT_PATH_MAX + 8];
+    range_path(checkpoint, start, end, path);
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    
+    CheckpointFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IST_CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.dimension = checkpoint->dimension;
+    header.tree_count = ists->tree_count;
+    header.start = start;
+    header.end = end;
+    header.checksum = FNV_OFFSET_BASIS;
+    for (int t = 0; t < ists->tree_count; t++) {
+        header.checksum = fnv1a_hash(header.checksum, &ists->trees[t].parent[start], count * sizeof(int));
+    }
+    
+    FILE* out = fopen(temp_path, "wb");
+    int ok = out && fwrite(&header, sizeof(header), 1, out) == 1;
+    for (int t = 0; t < ists->tree_count && ok; t++) {
+        ok = fwrite(&ists->trees[t].parent[start], sizeof(int), count, out) == (size_t)count;
+    }
+    if (out) {
+        if (fflush(out) != 0 || fsync(fileno(out)) != 0) ok = 0;
+        if (fclose(out) != 0) ok = 0;
+    }
+    if (ok) ok = rename(temp_path, path) == 0;
+    
+    // Record the range only once its file is in place
+    if (ok) {
+        char manifest_file[IST_CHECKPOINT_PATH_MAX];
+        manifest_path(checkpoint, manifest_file);
+        FILE* manifest = fopen(manifest_file, "a");
+        ok = manifest && fprintf(manifest, "range %d %d\n", start, end) > 0;
+        if (manifest) {
+            if (fflush(manifest) != 0 || fsync(fileno(manifest)) != 0) ok = 0;
+            if (fclose(manifest) != 0) ok = 0;
+        }
+    }
+    if (ok) ok = add_range(checkpoint, start, end);
+    
+    timeline_span(SPAN_CHECKPOINT, span_start, timeline_now());
+    double now = measure_time();
+    checkpoint->write_time += now - begin;
+    checkpoint->last_time = now;
+    if (ok) {
+        checkpoint->checkpoints_written++;
+    } else {
+        unlink(temp_path);
+        if (checkpoint->checkpoints_failed++ == 0) {
+            printf("Rank %d: Failed to write checkpoint %d-%d\n", checkpoint->rank, start, end);
+        }
+    }
+    
+    return ok;
+}
+
+// Compute vertices [start, end) with compute_range, skipping restored ranges
+// Work is done in segments; after each segment a checkpoint is written if the
+// interval has elapsed, and every uncovered run is saved once it is finished
+// A range that could not be saved is kept pending and retried with the next save
+void compute_with_checkpoints(ISTCheckpoint* checkpoint, IndependentSpanningTrees* ists,
+                              int start, int end, RangeKernel compute_range, ParentKernel kernel) {
+    checkpoint_restore(checkpoint, ists);
+    
+    int v = start;
+    while (v < end) {
+        int gap_end;
+        v = checkpoint_next_gap(checkpoint, v, end, &gap_end);
+        if (v >= end) break;
+        
+        int pending = v;
+        for (int segment = v; segment < gap_end; segment += IST_CHECKPOINT_SEGMENT) {
+            int segment_end = gap_end - segment < IST_CHECKPOINT_SEGMENT ? gap_end : segment + IST_CHECKPOINT_SEGMENT;
+            compute_range(kernel, ists, segment, segment_end);
+            
+            if (segment_end < gap_end && checkpoint_due(checkpoint)) {
+                if (checkpoint_save_range(checkpoint, ists, pending, segment_end)) {
+                    pending = segment_end;
+                }
+            }
+        }
+        checkpoint_save_range(checkpoint, ists, pending, gap_end);
+        
+        v = gap_end;
+    }
+}
+
+// Release a checkpoint (the files are kept for a later resume)
+void close_checkpoint(ISTCheckpoint* checkpoint) {
+    if (checkpoint) {
+        free(checkpoint->ranges);
+        free(checkpoint);
+    }
+}
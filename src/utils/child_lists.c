@@ -0,0 +1,248 @@
+#include "ist_children.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Invert the parent array of tree into CSR child lists
+// Returns NULL on failure
+ChildLists* build_child_lists(SpanningTree* tree, int root) {
+    int vertex_count = tree->vertex_count;
+    const int* parent = tree->parent;
+    if (root < 0 || root >= vertex_count) return NULL;
+    
+    ChildLists* lists = (ChildLists*)calloc(1, sizeof(ChildLists));
+    if (!lists) return NULL;
+    
+    lists->vertex_count = vertex_count;
+    lists->root = root;
+    lists->offsets = (int*)calloc(vertex_count + 1, sizeof(int));
+    lists->children = (int*)malloc(vertex_count * sizeof(int));
+    if (!lists->offsets || !lists->children) {
+        free_child_lists(lists);
+        return NULL;
+    }
+    int* offsets = lists->offsets;
+    int* children = lists->children;
+    
+    // Count the children of every vertex; the root and invalid parents are skipped
+    #pragma omp parallel for schedule(static)
+    for (int v = 0; v < vertex_count; v++) {
+        int p = parent[v];
+        if (v != root && p >= 0 && p < vertex_count) {
+            #pragma omp atomic
+            offsets[p]++;
+        }
+    }
+    
+    // offsets[p] becomes the end of p's group; placing children from the end
+    // moves it back to the start
+    for (int v = 1; v < vertex_count; v++) {
+        offsets[v] += offsets[v - 1];
+    }
+    offsets[vertex_count] = offsets[vertex_count - 1];
+    
+    #pragma omp parallel for schedule(static)
+    for (int v = 0; v < vertex_count; v++) {
+        int p = parent[v];
+        if (v != root && p >= 0 && p < vertex_count) {
+            int slot;
+            #pragma omp atomic capture
+            slot = --offsets[p];
+            children[slot] = v;
+        }
+    }
+    
+    // Sort each group (at most n-1 children) so the order does not depend on the threads
+    #pragma omp parallel for schedule(static)
+    for (int v = 0; v < vertex_count; v++) {
+        for (int i = offsets[v] + 1; i < offsets[v + 1]; i++) {
+            int child = children[i];
+            int j = i;
+            while (j > offsets[v] && children[j - 1] > child) {
+                children[j] = children[j - 1];
+                j--;
+            }
+            children[j] = child;
+        }
+    }
+    
+    return lists;
+}
+
+// List the vertices reachable from the root in level order
+// Each level is expanded in parallel; a prefix sum over the child counts of
+// the level gives every vertex the place of its children in the next one
+// Returns 1 on success, 0 on failure
+int build_level_order(ChildLists* lists) {
+    int vertex_count = lists->vertex_count;
+    const int* offsets = lists->offsets;
+    const int* children = lists->children;
+    
+    free(lists->order);
+    free(lists->level_start);
+    lists->order = (int*)malloc(vertex_count * sizeof(int));
+    lists->level_start = NULL;
+    lists->level_count = 0;
+    lists->reachable = 0;
+    
+    int* slot = (int*)malloc(vertex_count * sizeof(int));
+    if (!lists->order || !slot) {
+        free(slot);
+        return 0;
+    }
+    int* order = lists->order;
+    
+    int capacity = 0;
+    int level_begin = 0;
+    int level_end = 1;
+    order[0] = lists->root;
+    
+    while (level_begin < level_end) {
+        // level_start keeps one extra entry for the end of the last level
+        if (lists->level_count + 2 > capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            int* grown = (int*)realloc(lists->level_start, capacity * sizeof(int));
+            if (!grown) {
+                free(slot);
+                return 0;
+            }
+            lists->level_start = grown;
+        }
+        lists->level_start[lists->level_count++] = level_begin;
+        
+        int next_end = level_end;
+        for (int i = level_begin; i < level_end; i++) {
+            int u = order[i];
+            slot[i] = next_end;
+            next_end += offsets[u + 1] - offsets[u];
+        }
+        
+        #pragma omp parallel for schedule(static)
+        for (int i = level_begin; i < level_end; i++) {
+            int u = order[i];
+            int position = slot[i];
+            for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+                order[position++] = children[e];
+            }
+        }
+        
+        level_begin = level_end;
+        level_end = next_end;
+    }
+    
+    lists->level_start[lists->level_count] = level_end;
+    lists->reachable = level_end;
+    free(slot);
+    return 1;
+}
+
+void free_child_lists(ChildLists* lists) {
+    if (lists) {
+        free(lists->offsets);
+        free(lists->children);
+        free(lists->order);
+        free(lists->level_start);
+        free(lists);
+    }
+}
+
+// Child lists and level order of every tree, all rooted at root
+// Returns an array of ists->tree_count entries, or NULL on failure
+ChildLists** build_all_child_lists(IndependentSpanningTrees* ists, int root) {
+    ChildLists** lists = (ChildLists**)calloc(ists->tree_count, sizeof(ChildLists*));
+    if (!lists) return NULL;
+    
+    for (int t = 0; t < ists->tree_count; t++) {
+        lists[t] = build_child_lists(&ists->trees[t], root);
+        if (!lists[t] || !build_level_order(lists[t])) {
+            free_all_child_lists(lists, ists->tree_count);
+            return NULL;
+        }
+    }
+    return lists;
+}
+
+void free_all_child_lists(ChildLists** lists, int tree_count) {
+    if (!lists) return;
+    for (int t = 0; t < tree_count; t++) {
+        free_child_lists(lists[t]);
+    }
+    free(lists);
+}
+
+// Visit every edge from the root down, one level after the other
+// build_level_order must have been called
+void traverse_level_order(const ChildLists* lists, ChildVisitor visit, void* user_data) {
+    for (int level = 0; level + 1 < lists->level_count; level++) {
+        #pragma omp parallel for schedule(static)
+        for (int i = lists->level_start[level]; i < lists->level_start[level + 1]; i++) {
+            int u = lists->order[i];
+            for (int e = lists->offsets[u]; e < lists->offsets[u + 1]; e++) {
+                visit(u, lists->children[e], level + 1, user_data);
+            }
+        }
+    }
+}
+
+// Root-to-all dissemination: every vertex receives its parent's value
+// Vertices not reachable from the root keep their value
+void broadcast_values(const ChildLists* lists, uint64_t* values) {
+    for (int level = 0; level + 1 < lists->level_count; level++) {
+        #pragma omp parallel for schedule(static)
+        for (int i = lists->level_start[level]; i < lists->level_start[level + 1]; i++) {
+            int u = lists->order[i];
+            uint64_t value = values[u];
+            for (int e = lists->offsets[u]; e < lists->offsets[u + 1]; e++) {
+                values[lists->children[e]] = value;
+            }
+        }
+    }
+}
+
+// Build the child lists of all trees and broadcast a value from the root of
+// each, printing the times and the vertices reached
+// Returns 1 on success, 0 on failure
+int report_broadcast(FILE* out, IndependentSpanningTrees* ists) {
+    double start_time = measure_time();
+    ChildLists** lists = build_all_child_lists(ists, 0);  // 0 is the identity permutation
+    double build_time = measure_time() - start_time;
+    if (!lists) {
+        fprintf(out, "Failed to build child lists\n");
+        return 0;
+    }
+    
+    int vertex_count = lists[0]->vertex_count;
+    uint64_t* values = (uint64_t*)calloc(vertex_count, sizeof(uint64_t));
+    if (!values) {
+        fprintf(out, "Failed to allocate broadcast values\n");
+        free_all_child_lists(lists, ists->tree_count);
+        return 0;
+    }
+    
+    fprintf(out, "\nChild lists of %d trees built in %.6f seconds\n", ists->tree_count, build_time);
+    fprintf(out, "Broadcast from the root:\n");
+    fprintf(out, "  %-6s %7s %10s %12s\n", "tree", "levels", "reached", "seconds");
+    
+    double total_time = 0.0;
+    long long total_reached = 0;
+    for (int t = 0; t < ists->tree_count; t++) {
+        values[lists[t]->root] = t + 1;
+        start_time = measure_time();
+        broadcast_values(lists[t], values);
+        double seconds = measure_time() - start_time;
+        
+        int reached = 0;
+        for (int v = 0; v < vertex_count; v++) {
+            if (values[v] == (uint64_t)(t + 1)) reached++;
+        }
+        fprintf(out, "  T_%-4d %7d %10d %12.6f\n", t + 1, lists[t]->level_count, reached, seconds);
+        total_time += seconds;
+        total_reached += reached;
+    }
+    fprintf(out, "  %lld vertices reached in %.6f seconds (%.1f M vertices/s)\n", total_reached,
+            total_time, total_time > 0 ? total_reached / total_time / 1e6 : 0.0);
+    
+    free(values);
+    free_all_child_lists(lists, ists->tree_count);
+    return 1;
+}
@@ -0,0 +1,472 @@
+#include "ist_congestion.h"
+#include "ist_children.h"
+#include "bubble_sort_network.h"
+#include "utils.h"
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Factorials 0! .. IST_CONGESTION_MAX_DIMENSION!
+static void factorial_table(int* fact) {
+    fact[0] = 1;
+    for (int k = 1; k <= IST_CONGESTION_MAX_DIMENSION; k++) {
+        fact[k] = fact[k - 1] * k;
+    }
+}
+
+// Lehmer digits of index, digit i weighted by (n-1-i)!
+static void lehmer_digits(int index, int n, const int* fact, int* digits) {
+    for (int i = 0; i < n; i++) {
+        digits[i] = (index / fact[n - 1 - i]) % (n - i);
+    }
+}
+
+// Lehmer digits of index + 1 from those of index (mixed-radix increment)
+static void next_lehmer_digits(int n, int* digits) {
+    for (int i = n - 2; i >= 0; i--) {
+        if (++digits[i] < n - i) return;
+        digits[i] = 0;
+    }
+}
+
+// Change of the index when positions i+1 and i+2 (1-based) are swapped; see
+// adjacent_swap_index, here with the digits and factorials at hand
+static int swap_delta(const int* digits, int i, int n, const int* fact) {
+    int d0 = digits[i];
+    int d1 = digits[i + 1];
+    int new_d0 = d0 <= d1 ? d1 + 1 : d1;
+    int new_d1 = d0 <= d1 ? d0 : d0 - 1;
+    return (new_d0 - d0) * fact[n - i - 1] + (new_d1 - d1) * fact[n - i - 2];
+}
+
+// Add the loads of one tree to stats
+// Returns 1 on success, 0 on failure
+static int add_tree_congestion(SpanningTree* tree, CongestionStats* stats, const int* fact) {
+    int n = stats->dimension;
+    const int* parent = tree->parent;
+    
+    ChildLists* lists = build_child_lists(tree, stats->root);
+    if (!lists || !build_level_order(lists)) {
+        free_child_lists(lists);
+        return 0;
+    }
+    int* size = (int*)calloc(stats->vertex_count, sizeof(int));
+    if (!size) {
+        free_child_lists(lists);
+        return 0;
+    }
+    const int* order = lists->order;
+    const int* offsets = lists->offsets;
+    const int* children = lists->children;
+    
+    // Subtree sizes from the deepest level up; the children of a level are
+    // all on the next one, which is done by then
+    for (int level = lists->level_count - 1; level >= 0; level--) {
+        #pragma omp parallel for schedule(static)
+        for (int i = lists->level_start[level]; i < lists->level_start[level + 1]; i++) {
+            int v = order[i];
+            int s = 1;
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                s += size[children[e]];
+            }
+            size[v] = s;
+        }
+    }
+    
+    // Every reachable vertex (size > 0) adds to its own totals and to the
+    // link to its parent; in index order the Lehmer digits are incremented
+    // instead of recomputed
+    #pragma omp parallel
+    {
+        int digits[IST_CONGESTION_MAX_DIMENSION];
+        int next = -1;
+        
+        #pragma omp for schedule(static)
+        for (int v = 0; v < stats->vertex_count; v++) {
+            if (v == next) {
+                next_lehmer_digits(n, digits);
+            } else {
+                lehmer_digits(v, n, fact, digits);
+            }
+            next = v + 1;
+            if (size[v] == 0) continue;
+            
+            if (offsets[v + 1] > offsets[v]) stats->relay[v]++;
+            stats->load[v] += (uint64_t)(size[v] - 1);
+            if (v == stats->root) continue;
+            
+            int u = parent[v];
+            for (int p = 0; p < n - 1; p++) {
+                if (v + swap_delta(digits, p, n, fact) == u) {
+                    stats->link_load[(size_t)(v < u ? v : u) * (n - 1) + p] += (uint32_t)size[v];
+                    break;
+                }
+            }
+        }
+    }
+    
+    stats->unreachable += stats->vertex_count - lists->reachable;
+    free(size);
+    free_child_lists(lists);
+    return 1;
+}
+
+// Vertex and link loads of all trees, rooted at root; the trees are done one
+// after the other to keep a single set of child lists in memory
+// Returns 1 on success, 0 on failure (stats is left empty)
+int compute_congestion(IndependentSpanningTrees* ists, int dimension, int root, CongestionStats* stats) {
+    memset(stats, 0, sizeof(CongestionStats));
+    if (dimension > IST_CONGESTION_MAX_DIMENSION || ists->tree_count == 0) return 0;
+    
+    double start_time = measure_time();
+    int vertex_count = ists->trees[0].vertex_count;
+    if (root < 0 || root >= vertex_count) return 0;
+    
+    stats->dimension = dimension;
+    stats->vertex_count = vertex_count;
+    stats->tree_count = ists->tree_count;
+    stats->root = root;
+    stats->relay = (uint8_t*)calloc(vertex_count, sizeof(uint8_t));
+    stats->load = (uint64_t*)calloc(vertex_count, sizeof(uint64_t));
+    stats->link_load = (uint32_t*)calloc((size_t)vertex_count * (dimension - 1), sizeof(uint32_t));
+    if (!stats->relay || !stats->load || !stats->link_load) {
+        free_congestion(stats);
+        return 0;
+    }
+    
+    int fact[IST_CONGESTION_MAX_DIMENSION + 1];
+    factorial_table(fact);
+    for (int t = 0; t < ists->tree_count; t++) {
+        if (!add_tree_congestion(&ists->trees[t], stats, fact)) {
+            free_congestion(stats);
+            return 0;
+        }
+    }
+    
+    stats->seconds = measure_time() - start_time;
+    return 1;
+}
+
+void free_congestion(CongestionStats* stats) {
+    if (stats) {
+        free(stats->relay);
+        free(stats->load);
+        free(stats->link_load);
+        stats->relay = NULL;
+        stats->load = NULL;
+        stats->link_load = NULL;
+    }
+}
+
+// Whether a is hotter than b; ties go to the smaller vertices so that the
+// ranking does not depend on the threads
+static int hotter(const HotSpot* a, const HotSpot* b) {
+    if (a->load != b->load) return a->load > b->load;
+    if (a->first != b->first) return a->first < b->first;
+    return a->second < b->second;
+}
+
+// Insert a spot into a ranking of at most top entries, hottest first
+static void offer_hot_spot(HotSpot* ranking, int* count, int top, HotSpot spot) {
+    if (*count == top && !hotter(&spot, &ranking[top - 1])) return;
+    
+    int i = *count < top ? (*count)++ : top - 1;
+    while (i > 0 && hotter(&spot, &ranking[i - 1])) {
+        ranking[i] = ranking[i - 1];
+        i--;
+    }
+    ranking[i] = spot;
+}
+
+// Bucket of a load: 0 for none, b for [2^(b-1), 2^b)
+static int load_bucket(uint64_t load) {
+    int bucket = 0;
+    while (load > 0 && bucket < IST_CONGESTION_BUCKETS - 1) {
+        load >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// Merge the per-thread rankings of threads * top entries into ranking
+static int merge_rankings(const HotSpot* local, const int* counts, int threads, int top, HotSpot* ranking) {
+    int count = 0;
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < counts[t]; i++) {
+            offer_hot_spot(ranking, &count, top, local[(size_t)t * top + i]);
+        }
+    }
+    return count;
+}
+
+// Hot spots and distributions of stats, the root left out
+// Returns 1 on success, 0 on failure
+int summarize_congestion(const CongestionStats* stats, int top, CongestionSummary* summary) {
+    memset(summary, 0, sizeof(CongestionSummary));
+    int n = stats->dimension;
+    int vertex_count = stats->vertex_count;
+    int threads = omp_get_max_threads();
+    if (top < 1) top = 1;
+    
+    summary->hot_vertices = (HotSpot*)calloc(top, sizeof(HotSpot));
+    summary->hot_links = (HotSpot*)calloc(top, sizeof(HotSpot));
+    summary->relay_histogram = (int*)calloc(stats->tree_count + 1, sizeof(int));
+    HotSpot* local = (HotSpot*)malloc((size_t)threads * top * sizeof(HotSpot));
+    int* counts = (int*)calloc(threads, sizeof(int));
+    if (!summary->hot_vertices || !summary->hot_links || !summary->relay_histogram || !local || !counts) {
+        free(local);
+        free(counts);
+        free_congestion_summary(summary);
+        return 0;
+    }
+    
+    int fact[IST_CONGESTION_MAX_DIMENSION + 1];
+    factorial_table(fact);
+    int relay_size = stats->tree_count + 1;
+    int* relay_histogram = summary->relay_histogram;
+    long long* vertex_buckets = summary->vertex_buckets;
+    long long* link_buckets = summary->link_buckets;
+    uint64_t vertex_total = 0;
+    uint64_t link_total = 0;
+    long long links_used = 0;
+    
+    // Vertices
+    #pragma omp parallel reduction(+:relay_histogram[:relay_size], vertex_buckets[:IST_CONGESTION_BUCKETS], vertex_total)
+    {
+        int thread = omp_get_thread_num();
+        HotSpot* ranking = local + (size_t)thread * top;
+        
+        #pragma omp for schedule(static)
+        for (int v = 0; v < vertex_count; v++) {
+            if (v == stats->root) continue;
+            relay_histogram[stats->relay[v]]++;
+            vertex_buckets[load_bucket(stats->load[v])]++;
+            vertex_total += stats->load[v];
+            
+            HotSpot spot = { stats->load[v], v, -1 };
+            offer_hot_spot(ranking, &counts[thread], top, spot);
+        }
+    }
+    summary->top = merge_rankings(local, counts, threads, top, summary->hot_vertices);
+    
+    // Links, each stored at its smaller endpoint: the swap raises the index
+    // exactly when the two Lehmer digits are in order
+    memset(counts, 0, threads * sizeof(int));
+    #pragma omp parallel reduction(+:link_buckets[:IST_CONGESTION_BUCKETS], link_total, links_used)
+    {
+        int thread = omp_get_thread_num();
+        HotSpot* ranking = local + (size_t)thread * top;
+        int digits[IST_CONGESTION_MAX_DIMENSION];
+        int next = -1;
+        
+        #pragma omp for schedule(static)
+        for (int v = 0; v < vertex_count; v++) {
+            if (v == next) {
+                next_lehmer_digits(n, digits);
+            } else {
+                lehmer_digits(v, n, fact, digits);
+            }
+            next = v + 1;
+            for (int p = 0; p < n - 1; p++) {
+                if (digits[p] > digits[p + 1]) continue;
+                
+                uint64_t load = stats->link_load[(size_t)v * (n - 1) + p];
+                link_buckets[load_bucket(load)]++;
+                link_total += load;
+                if (load > 0) links_used++;
+                
+                HotSpot spot = { load, v, v + swap_delta(digits, p, n, fact) };
+                offer_hot_spot(ranking, &counts[thread], top, spot);
+            }
+        }
+    }
+    int hot_links = merge_rankings(local, counts, threads, top, summary->hot_links);
+    if (hot_links < summary->top) summary->top = hot_links;
+    
+    summary->vertex_total = vertex_total;
+    summary->link_total = link_total;
+    summary->links_used = links_used;
+    summary->link_count = (long long)vertex_count * (n - 1) / 2;
+    
+    free(local);
+    free(counts);
+    return 1;
+}
+
+void free_congestion_summary(CongestionSummary* summary) {
+    if (summary) {
+        free(summary->hot_vertices);
+        free(summary->hot_links);
+        free(summary->relay_histogram);
+        summary->hot_vertices = NULL;
+        summary->hot_links = NULL;
+        summary->relay_histogram = NULL;
+    }
+}
+
+// Write vertex as its permutation, e.g. "2 1 3 4", into text
+static void format_vertex(int vertex, int n, char* text, size_t size) {
+    Permutation* perm = index_to_permutation(vertex, n);
+    size_t length = 0;
+    text[0] = '\0';
+    for (int i = 0; perm && i < n && length < size; i++) {
+        length += snprintf(text + length, size - length, i ? " %d" : "%d", perm->elements[i]);
+    }
+    free_permutation(perm);
+}
+
+// Print the buckets from the first to the last non-empty one
+static void print_buckets(FILE* out, const long long* buckets) {
+    int last = 0;
+    for (int b = 0; b < IST_CONGESTION_BUCKETS; b++) {
+        if (buckets[b] > 0) last = b;
+    }
+    for (int b = 0; b <= last; b++) {
+        if (b == 0) {
+            fprintf(out, "    %10s %10d %12lld\n", "0", 0, buckets[b]);
+        } else {
+            fprintf(out, "    %10llu %10llu %12lld\n", 1ULL << (b - 1), (1ULL << b) - 1, buckets[b]);
+        }
+    }
+}
+
+// Print the relay counts, load distributions and hot spots
+void print_congestion(FILE* out, const CongestionStats* stats, const CongestionSummary* summary) {
+    int n = stats->dimension;
+    int vertices = stats->vertex_count - 1;     // Without the root
+    double vertex_mean = (double)summary->vertex_total / vertices;
+    double link_mean = (double)summary->link_total / summary->link_count;
+    char text[64];
+    
+    fprintf(out, "Congestion of %d trees rooted at vertex %d (root left out):\n", stats->tree_count, stats->root);
+    if (stats->unreachable > 0) {
+        fprintf(out, "  %lld vertices over all trees do not reach the root and are skipped\n", stats->unreachable);
+    }
+    
+    fprintf(out, "  Relay: vertices with children in k trees\n");
+    fprintf(out, "    %4s %12s\n", "k", "vertices");
+    for (int k = 0; k <= stats->tree_count; k++) {
+        fprintf(out, "    %4d %12d\n", k, summary->relay_histogram[k]);
+    }
+    
+    uint64_t vertex_max = summary->top > 0 ? summary->hot_vertices[0].load : 0;
+    fprintf(out, "  Vertex load (root paths crossing a vertex): mean %.2f, max %llu (%.1fx the mean)\n",
+            vertex_mean, (unsigned long long)vertex_max, vertex_mean > 0 ? vertex_max / vertex_mean : 0.0);
+    fprintf(out, "    %10s %10s %12s\n", "from", "to", "vertices");
+    print_buckets(out, summary->vertex_buckets);
+    
+    uint64_t link_max = summary->top > 0 ? summary->hot_links[0].load : 0;
+    fprintf(out, "  Link load (root paths over a link): %lld of %lld links used, mean %.2f, max %llu (%.1fx the mean)\n",
+            summary->links_used, summary->link_count, link_mean, (unsigned long long)link_max,
+            link_mean > 0 ? link_max / link_mean : 0.0);
+    fprintf(out, "    %10s %10s %12s\n", "from", "to", "links");
+    print_buckets(out, summary->link_buckets);
+    
+    fprintf(out, "  Hottest vertices:\n");
+    fprintf(out, "    %10s %12s %6s  %s\n", "vertex", "load", "relay", "permutation");
+    for (int i = 0; i < summary->top; i++) {
+        const HotSpot* spot = &summary->hot_vertices[i];
+        format_vertex(spot->first, n, text, sizeof(text));
+        fprintf(out, "    %10d %12llu %6d  %s\n", spot->first, (unsigned long long)spot->load,
+                stats->relay[spot->first], text);
+    }
+    
+    fprintf(out, "  Hottest links:\n");
+    fprintf(out, "    %10s %10s %8s %12s\n", "from", "to", "position", "load");
+    for (int i = 0; i < summary->top; i++) {
+        const HotSpot* spot = &summary->hot_links[i];
+        fprintf(out, "    %10d %10d %8d %12llu\n", spot->first, spot->second,
+                adjacent_swap_position(spot->first, spot->second, n), (unsigned long long)spot->load);
+    }
+}
+
+// Write the buckets as a JSON array of [from, to, count]
+static void write_buckets_json(FILE* out, const long long* buckets) {
+    int last = 0;
+    for (int b = 0; b < IST_CONGESTION_BUCKETS; b++) {
+        if (buckets[b] > 0) last = b;
+    }
+    fprintf(out, "[");
+    for (int b = 0; b <= last; b++) {
+        unsigned long long from = b ? 1ULL << (b - 1) : 0;
+        unsigned long long to = b ? (1ULL << b) - 1 : 0;
+        fprintf(out, "%s[%llu, %llu, %lld]", b ? ", " : "", from, to, buckets[b]);
+    }
+    fprintf(out, "]");
+}
+
+// Write the statistics to a JSON file
+// Returns 1 on success, 0 on failure
+int write_congestion_json(const char* path, const CongestionStats* stats, const CongestionSummary* summary) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    fprintf(out, "{\n  \"dimension\": %d,\n  \"vertices\": %d,\n  \"trees\": %d,\n  \"root\": %d,\n"
+            "  \"unreachable\": %lld,\n", stats->dimension, stats->vertex_count, stats->tree_count,
+            stats->root, stats->unreachable);
+    
+    fprintf(out, "  \"relay_histogram\": [");
+    for (int k = 0; k <= stats->tree_count; k++) {
+        fprintf(out, "%s%d", k ? ", " : "", summary->relay_histogram[k]);
+    }
+    fprintf(out, "],\n  \"vertex_load\": {\"total\": %llu, \"buckets\": ",
+            (unsigned long long)summary->vertex_total);
+    write_buckets_json(out, summary->vertex_buckets);
+    fprintf(out, "},\n  \"link_load\": {\"links\": %lld, \"used\": %lld, \"total\": %llu, \"buckets\": ",
+            summary->link_count, summary->links_used, (unsigned long long)summary->link_total);
+    write_buckets_json(out, summary->link_buckets);
+    
+    fprintf(out, "},\n  \"hot_vertices\": [");
+    for (int i = 0; i < summary->top; i++) {
+        const HotSpot* spot = &summary->hot_vertices[i];
+        fprintf(out, "%s{\"vertex\": %d, \"load\": %llu, \"relay\": %d}", i ? ", " : "", spot->first,
+                (unsigned long long)spot->load, stats->relay[spot->first]);
+    }
+    fprintf(out, "],\n  \"hot_links\": [");
+    for (int i = 0; i < summary->top; i++) {
+        const HotSpot* spot = &summary->hot_links[i];
+        fprintf(out, "%s{\"from\": %d, \"to\": %d, \"load\": %llu}", i ? ", " : "", spot->first,
+                spot->second, (unsigned long long)spot->load);
+    }
+    fprintf(out, "]\n}\n");
+    
+    return fclose(out) == 0;
+}
+
+// Compute, print and optionally write the congestion of all trees rooted at
+// the identity, with the top hottest vertices and links
+// Returns 1 on success, 0 on failure
+int report_congestion(FILE* out, IndependentSpanningTrees* ists, int dimension, int top, const char* json_path) {
+    if (dimension > IST_CONGESTION_MAX_DIMENSION) {
+        fprintf(out, "\nCongestion analysis supports dimensions up to %d\n", IST_CONGESTION_MAX_DIMENSION);
+        return 0;
+    }
+    
+    CongestionStats stats;
+    CongestionSummary summary;
+    if (!compute_congestion(ists, dimension, 0, &stats)) {     // 0 is the identity permutation
+        fprintf(out, "\nFailed to compute congestion\n");
+        return 0;
+    }
+    double start_time = measure_time();
+    if (!summarize_congestion(&stats, top, &summary)) {
+        fprintf(out, "\nFailed to summarize congestion\n");
+        free_congestion(&stats);
+        return 0;
+    }
+    double summary_time = measure_time() - start_time;
+    
+    fprintf(out, "\n");
+    print_congestion(out, &stats, &summary);
+    fprintf(out, "Congestion computed in %.6f seconds (summary %.6f)\n", stats.seconds, summary_time);
+    
+    int ok = 1;
+    if (json_path && !write_congestion_json(json_path, &stats, &summary)) {
+        fprintf(out, "Failed to write congestion to %s\n", json_path);
+        ok = 0;
+    }
+    
+    free_congestion_summary(&summary);
+    free_congestion(&stats);
+    return ok;
+}
@@ -0,0 +1,101 @@
+#include "ist_digest.h"
+#include <omp.h>
+
+// splitmix64 finalizer
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Contribution of one entry; vertex indices fit in 32 bits up to n = 12
+static inline uint64_t digest_entry(int tree, int vertex, int parent) {
+    uint64_t key = (uint64_t)tree << 32 | (uint32_t)vertex;
+    return mix64(mix64(key) + (uint32_t)parent);
+}
+
+// Digest of the parents of vertices [start, end) in tree (0-based)
+uint64_t digest_tree_range(const int* parent, int tree, int start, int end) {
+    uint64_t digest = 0;
+    for (int v = start; v < end; v++) {
+        digest += digest_entry(tree, v, parent[v]);
+    }
+    return digest;
+}
+
+// Digest of vertices [start, end) in every tree, computed by the OpenMP threads
+uint64_t digest_ists_range(IndependentSpanningTrees* ists, int start, int end) {
+    int blocks = (end - start + IST_DIGEST_BLOCK - 1) / IST_DIGEST_BLOCK;
+    int items = blocks * ists->tree_count;
+    uint64_t digest = 0;
+    
+    #pragma omp parallel for schedule(static) reduction(+:digest)
+    for (int i = 0; i < items; i++) {
+        int t = i / blocks;
+        int block_start = start + (i % blocks) * IST_DIGEST_BLOCK;
+        int block_end = end - block_start < IST_DIGEST_BLOCK ? end : block_start + IST_DIGEST_BLOCK;
+        digest += digest_tree_range(ists->trees[t].parent, t, block_start, block_end);
+    }
+    return digest;
+}
+
+// Digest of all trees
+uint64_t digest_ists(IndependentSpanningTrees* ists) {
+    if (ists->tree_count == 0) return 0;
+    return digest_ists_range(ists, 0, ists->trees[0].vertex_count);
+}
+
+// Digest of a vertex-major streamed block
+uint64_t digest_block(const ISTBlock* block) {
+    uint64_t digest = 0;
+    for (int i = 0; i < block->vertex_count; i++) {
+        const int* parents = block->parents + (size_t)i * block->tree_count;
+        for (int t = 0; t < block->tree_count; t++) {
+            digest += digest_entry(t, block->first_vertex + i, parents[t]);
+        }
+    }
+    return digest;
+}
+
+// ISTBlockSink adding each block to the DigestSink in user_data before
+// passing it on (if the DigestSink has a sink)
+int digest_block_sink(const ISTBlock* block, void* user_data) {
+    DigestSink* digest_sink = (DigestSink*)user_data;
+    digest_sink->digest += digest_block(block);
+    return digest_sink->sink ? digest_sink->sink(block, digest_sink->user_data) : 1;
+}
+
+// Parse a digest of 1 to 16 hexadecimal digits and nothing else
+// Returns 1 on success, 0 otherwise
+int parse_digest(const char* text, uint64_t* digest) {
+    uint64_t value = 0;
+    int digits = 0;
+    for (const char* p = text; *p; p++) {
+        int nibble;
+        if (*p >= '0' && *p <= '9') nibble = *p - '0';
+        else if (*p >= 'a' && *p <= 'f') nibble = *p - 'a' + 10;
+        else if (*p >= 'A' && *p <= 'F') nibble = *p - 'A' + 10;
+        else return 0;
+        
+        if (++digits > 16) return 0;
+        value = (value << 4) | (uint64_t)nibble;
+    }
+    if (digits == 0) return 0;
+    
+    *digest = value;
+    return 1;
+}
+
+// Print the digest and, if expected is not NULL, whether it matches
+// Returns 0 on a mismatch, 1 otherwise
+int report_digest(FILE* out, uint64_t digest, const uint64_t* expected) {
+    fprintf(out, "\nDigest: %016llx\n", (unsigned long long)digest);
+    if (!expected) return 1;
+    
+    if (digest != *expected) {
+        fprintf(out, "Digest mismatch: expected %016llx\n", (unsigned long long)*expected);
+        return 0;
+    }
+    fprintf(out, "Digest matches the expected digest\n");
+    return 1;
+}
@@ -0,0 +1,369 @@
+#include "ist_fault.h"
+#include "ist_depth.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+// Number the reachable vertices of one tree in preorder from its depths
+// Vertices are bucketed by depth; subtree sizes are summed from the deepest
+// level up, then every vertex takes the next free position after its parent
+static int number_tree(SpanningTree* tree, TreeDepths* depths, int* preorder, int* subtree, int* order) {
+    int vertex_count = tree->vertex_count;
+    int* by_depth = (int*)malloc(depths->reachable * sizeof(int));
+    int* start = (int*)malloc((depths->height + 2) * sizeof(int));
+    int* next = (int*)malloc(vertex_count * sizeof(int));
+    if (!by_depth || !start || !next) {
+        free(by_depth);
+        free(start);
+        free(next);
+        return 0;
+    }
+    
+    start[0] = 0;
+    for (int d = 0; d <= depths->height; d++) {
+        start[d + 1] = start[d] + depths->histogram[d];
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        preorder[v] = -1;
+        subtree[v] = 0;
+        if (depths->depth[v] != IST_DEPTH_UNREACHABLE) {
+            by_depth[start[depths->depth[v]]++] = v;
+            subtree[v] = 1;
+        }
+    }
+    
+    for (int i = depths->reachable - 1; i > 0; i--) {
+        int v = by_depth[i];
+        subtree[tree->parent[v]] += subtree[v];
+    }
+    
+    // by_depth[0] is the root
+    preorder[depths->root] = 0;
+    next[depths->root] = 1;
+    for (int i = 1; i < depths->reachable; i++) {
+        int v = by_depth[i];
+        int p = tree->parent[v];
+        preorder[v] = next[p];
+        next[p] += subtree[v];
+        next[v] = preorder[v] + 1;
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        if (preorder[v] >= 0) order[preorder[v]] = v;
+    }
+    
+    free(by_depth);
+    free(start);
+    free(next);
+    return 1;
+}
+
+// Precompute distances, depths and preorder numbering of every tree
+// The trees are rooted at the identity permutation (vertex 0)
+// Returns NULL on failure
+FaultModel* create_fault_model(IndependentSpanningTrees* ists, int dimension) {
+    if (ists->tree_count > IST_FAULT_MAX_TREES) return NULL;
+    
+    FaultModel* model = (FaultModel*)calloc(1, sizeof(FaultModel));
+    if (!model) return NULL;
+    
+    int vertex_count = ists->trees[0].vertex_count;
+    model->dimension = dimension;
+    model->tree_count = ists->tree_count;
+    model->vertex_count = vertex_count;
+    model->root = 0;
+    model->distance = (int*)malloc(vertex_count * sizeof(int));
+    model->preorder = (int**)calloc(ists->tree_count, sizeof(int*));
+    model->subtree = (int**)calloc(ists->tree_count, sizeof(int*));
+    model->order = (int**)calloc(ists->tree_count, sizeof(int*));
+    model->depth = (int**)calloc(ists->tree_count, sizeof(int*));
+    model->reachable = (int*)calloc(ists->tree_count, sizeof(int));
+    if (!model->distance || !model->preorder || !model->subtree || !model->order ||
+        !model->depth || !model->reachable) {
+        free_fault_model(model);
+        return NULL;
+    }
+    
+    // Distance to the identity is the number of inversions, the sum of the Lehmer digits
+    for (int v = 0; v < vertex_count; v++) {
+        int inversions = 0;
+        int rest = v;
+        for (int i = 1; i <= dimension; i++) {
+            inversions += rest % i;
+            rest /= i;
+        }
+        model->distance[v] = inversions;
+    }
+    
+    int ok = 1;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(&&:ok)
+    for (int t = 0; t < ists->tree_count; t++) {
+        TreeDepths depths;
+        int* preorder = (int*)malloc(vertex_count * sizeof(int));
+        int* subtree = (int*)malloc(vertex_count * sizeof(int));
+        int* order = (int*)malloc(vertex_count * sizeof(int));
+        int done = preorder && subtree && order &&
+                   compute_tree_depths(&ists->trees[t], model->root, &depths);
+        
+        if (done) {
+            done = number_tree(&ists->trees[t], &depths, preorder, subtree, order);
+            model->reachable[t] = depths.reachable;
+            model->depth[t] = depths.depth;     // Kept; the histogram is not needed
+            depths.depth = NULL;
+            free_tree_depths(&depths);
+        }
+        
+        model->preorder[t] = preorder;
+        model->subtree[t] = subtree;
+        model->order[t] = order;
+        ok = done && ok;
+    }
+    
+    if (!ok) {
+        free_fault_model(model);
+        return NULL;
+    }
+    return model;
+}
+
+void free_fault_model(FaultModel* model) {
+    if (!model) return;
+    
+    for (int t = 0; t < model->tree_count; t++) {
+        if (model->preorder) free(model->preorder[t]);
+        if (model->subtree) free(model->subtree[t]);
+        if (model->order) free(model->order[t]);
+        if (model->depth) free(model->depth[t]);
+    }
+    free(model->preorder);
+    free(model->subtree);
+    free(model->order);
+    free(model->depth);
+    free(model->reachable);
+    free(model->distance);
+    free(model);
+}
+
+FaultScratch* create_fault_scratch(FaultModel* model) {
+    FaultScratch* scratch = (FaultScratch*)malloc(sizeof(FaultScratch));
+    if (!scratch) return NULL;
+    
+    scratch->paths = (unsigned char*)malloc(model->vertex_count);
+    scratch->best = (int*)malloc(model->vertex_count * sizeof(int));
+    if (!scratch->paths || !scratch->best) {
+        free_fault_scratch(scratch);
+        return NULL;
+    }
+    return scratch;
+}
+
+void free_fault_scratch(FaultScratch* scratch) {
+    if (scratch) {
+        free(scratch->paths);
+        free(scratch->best);
+        free(scratch);
+    }
+}
+
+// Whether ancestor lies on the path from vertex to the root of tree (inclusive)
+int is_tree_ancestor(FaultModel* model, int tree, int ancestor, int vertex) {
+    int a = model->preorder[tree][ancestor];
+    int v = model->preorder[tree][vertex];
+    return a >= 0 && v >= 0 && a <= v && v < a + model->subtree[tree][ancestor];
+}
+
+// Count the surviving paths of every vertex under one fault set
+void evaluate_fault_set(FaultModel* model, const FaultSet* set, FaultScratch* scratch, FaultResult* result) {
+    int vertex_count = model->vertex_count;
+    
+    memset(scratch->paths, 0, vertex_count);
+    for (int v = 0; v < vertex_count; v++) {
+        scratch->best[v] = INT_MAX;
+    }
+    
+    for (int t = 0; t < model->tree_count; t++) {
+        const int* preorder = model->preorder[t];
+        const int* subtree = model->subtree[t];
+        const int* order = model->order[t];
+        const int* depth = model->depth[t];
+        
+        // Subtrees cut off by the faults, sorted by start
+        int cut_start[IST_FAULT_MAX_FAULTS];
+        int cut_end[IST_FAULT_MAX_FAULTS];
+        int cuts = 0;
+        for (int i = 0; i < set->fault_count; i++) {
+            int f = set->faults[i];
+            if (preorder[f] < 0) continue;
+            
+            int j = cuts++;
+            while (j > 0 && cut_start[j - 1] > preorder[f]) {
+                cut_start[j] = cut_start[j - 1];
+                cut_end[j] = cut_end[j - 1];
+                j--;
+            }
+            cut_start[j] = preorder[f];
+            cut_end[j] = preorder[f] + subtree[f];
+        }
+        
+        // Walk the positions that are not cut off (position 0 is the root)
+        int position = 1;
+        for (int c = 0; c <= cuts; c++) {
+            int end = c < cuts ? cut_start[c] : model->reachable[t];
+            for (; position < end; position++) {
+                int v = order[position];
+                scratch->paths[v]++;
+                if (depth[v] < scratch->best[v]) scratch->best[v] = depth[v];
+            }
+            if (c < cuts && cut_end[c] > position) position = cut_end[c];
+        }
+    }
+    
+    memset(result, 0, sizeof(FaultResult));
+    result->min_paths = model->tree_count;
+    double stretch_sum = 0.0;
+    
+    for (int v = 0; v < vertex_count; v++) {
+        if (v == model->root) continue;
+        
+        int faulty = 0;
+        for (int i = 0; i < set->fault_count; i++) {
+            if (set->faults[i] == v) faulty = 1;
+        }
+        if (faulty) continue;
+        
+        int paths = scratch->paths[v];
+        result->sources++;
+        result->paths[paths]++;
+        if (paths < result->min_paths) result->min_paths = paths;
+        if (paths > 0) {
+            double stretch = (double)scratch->best[v] / model->distance[v];
+            result->delivered++;
+            stretch_sum += stretch;
+            if (stretch > result->max_stretch) result->max_stretch = stretch;
+        }
+    }
+    
+    result->mean_stretch = result->delivered ? stretch_sum / result->delivered : 0.0;
+}
+
+// Evaluate set_count fault sets in parallel, one scratch per thread
+// Returns 1 on success, 0 on failure
+int simulate_fault_sets(FaultModel* model, const FaultSet* sets, int set_count, FaultResult* results) {
+    int ok = 1;
+    
+    #pragma omp parallel reduction(&&:ok)
+    {
+        FaultScratch* scratch = create_fault_scratch(model);
+        if (!scratch) ok = 0;
+        
+        #pragma omp for schedule(dynamic, 4)
+        for (int s = 0; s < set_count; s++) {
+            if (scratch) evaluate_fault_set(model, &sets[s], scratch, &results[s]);
+        }
+        
+        free_fault_scratch(scratch);
+    }
+    
+    return ok;
+}
+
+// The fault_count vertices whose subtrees, summed over all trees, are largest
+// Faulting them cuts off the most paths at once
+void adversarial_fault_set(FaultModel* model, int fault_count, FaultSet* set) {
+    set->fault_count = 0;
+    long long weights[IST_FAULT_MAX_FAULTS];
+    if (fault_count <= 0) return;
+    
+    for (int v = 0; v < model->vertex_count; v++) {
+        if (v == model->root) continue;
+        
+        long long weight = 0;
+        for (int t = 0; t < model->tree_count; t++) {
+            weight += model->subtree[t][v];
+        }
+        
+        // Insert into the list of the heaviest vertices so far, dropping the
+        // lightest once it is full
+        int count = set->fault_count;
+        if (count == fault_count && weight <= weights[count - 1]) continue;
+        
+        int j = count < fault_count ? count++ : count - 1;
+        while (j > 0 && weights[j - 1] < weight) {
+            weights[j] = weights[j - 1];
+            set->faults[j] = set->faults[j - 1];
+            j--;
+        }
+        weights[j] = weight;
+        set->faults[j] = v;
+        set->fault_count = count;
+    }
+}
+
+// Read fault sets from a text file, one set of vertex indices per line
+// Blank lines and lines starting with '#' are skipped
+// Returns 1 on success, 0 on failure (with a message)
+int read_fault_sets(const char* path, int vertex_count, int root, FaultSet** sets, int* set_count) {
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        printf("Failed to open %s\n", path);
+        return 0;
+    }
+    
+    int capacity = 0;
+    *sets = NULL;
+    *set_count = 0;
+    
+    char line[4096];
+    int line_number = 0;
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), in)) {
+        line_number++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\0') continue;
+        
+        if (*set_count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            FaultSet* grown = (FaultSet*)realloc(*sets, capacity * sizeof(FaultSet));
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            *sets = grown;
+        }
+        
+        FaultSet* set = &(*sets)[*set_count];
+        set->fault_count = 0;
+        for (;;) {
+            char* end;
+            long vertex = strtol(p, &end, 10);
+            if (end == p) break;
+            p = end;
+            
+            if (vertex < 0 || vertex >= vertex_count || vertex == root ||
+                set->fault_count == IST_FAULT_MAX_FAULTS) {
+                printf("Invalid fault set on line %d of %s\n", line_number, path);
+                ok = 0;
+                break;
+            }
+            set->faults[set->fault_count++] = (int)vertex;
+        }
+        
+        // Only whitespace or a comment may follow the vertices
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (ok && *p != '\0' && *p != '#') {
+            printf("Invalid fault set on line %d of %s\n", line_number, path);
+            ok = 0;
+        }
+        if (ok) (*set_count)++;
+    }
+    
+    fclose(in);
+    if (!ok) {
+        free(*sets);
+        *sets = NULL;
+        *set_count = 0;
+    }
+    return ok;
+}
@@ -0,0 +1,360 @@
+#include "ist_archive.h"
+#include "ist_io.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Number of bits needed for swap positions 0..n-1
+static int symbol_bits_for(int dimension) {
+    int bits = 1;
+    while ((1 << bits) < dimension) {
+        bits++;
+    }
+    return bits;
+}
+
+// Worst-case encoded size of a block (RLE with one run per vertex)
+static size_t max_block_size(int block_vertices) {
+    return (size_t)block_vertices * 6;
+}
+
+// Bit-pack count symbols; returns the encoded size
+static size_t encode_packed(const unsigned char* symbols, int count, int bits, unsigned char* out) {
+    size_t size = ((size_t)count * bits + 7) / 8;
+    memset(out, 0, size);
+    
+    for (int i = 0; i < count; i++) {
+        size_t bit = (size_t)i * bits;
+        for (int b = 0; b < bits; b++, bit++) {
+            if (symbols[i] & (1 << b)) {
+                out[bit / 8] |= (unsigned char)(1 << (bit % 8));
+            }
+        }
+    }
+    
+    return size;
+}
+
+// Run-length encode count symbols; returns the encoded size
+static size_t encode_rle(const unsigned char* symbols, int count, unsigned char* out) {
+    size_t size = 0;
+    
+    for (int i = 0; i < count; ) {
+        int run = 1;
+        while (i + run < count && symbols[i + run] == symbols[i]) {
+            run++;
+        }
+        
+        out[size++] = symbols[i];
+        unsigned int length = run;
+        do {
+            unsigned char byte = length & 0x7f;
+            length >>= 7;
+            out[size++] = length ? (byte | 0x80) : byte;
+        } while (length);
+        
+        i += run;
+    }
+    
+    return size;
+}
+
+// Decode one block of symbols; returns 1 on success
+static int decode_symbols(const unsigned char* data, const ISTArchiveBlock* entry, int bits,
+                          int count, unsigned char* symbols) {
+    if (entry->encoding == IST_BLOCK_PACKED) {
+        if (entry->size < ((size_t)count * bits + 7) / 8) return 0;
+        for (int i = 0; i < count; i++) {
+            size_t bit = (size_t)i * bits;
+            unsigned char symbol = 0;
+            for (int b = 0; b < bits; b++, bit++) {
+                if (data[bit / 8] & (1 << (bit % 8))) {
+                    symbol |= (unsigned char)(1 << b);
+                }
+            }
+            symbols[i] = symbol;
+        }
+        return 1;
+    }
+    
+    if (entry->encoding == IST_BLOCK_RLE) {
+        size_t pos = 0;
+        int i = 0;
+        while (i < count && pos < entry->size) {
+            unsigned char symbol = data[pos++];
+            unsigned int length = 0;
+            int shift = 0;
+            unsigned char byte;
+            do {
+                if (pos >= entry->size) return 0;
+                byte = data[pos++];
+                length |= (unsigned int)(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            
+            if (length > (unsigned int)(count - i)) return 0;
+            memset(&symbols[i], symbol, length);
+            i += length;
+        }
+        return i == count;
+    }
+    
+    return 0;
+}
+
+// Write trees from any engine to a block-compressed archive
+// Returns 1 on success, 0 on failure (including a parent that is not a neighbor)
+int write_ist_archive(const char* path, IndependentSpanningTrees* ists,
+                      int dimension, int block_vertices) {
+    if (ists->tree_count != dimension - 1) return 0;
+    if (block_vertices <= 0) block_vertices = IST_ARCHIVE_DEFAULT_BLOCK;
+    
+    int vertex_count = factorial(dimension);
+    int bits = symbol_bits_for(dimension);
+    uint64_t blocks_per_tree = (vertex_count + block_vertices - 1) / block_vertices;
+    uint64_t block_count = blocks_per_tree * ists->tree_count;
+    
+    ISTArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IST_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = IST_ARCHIVE_VERSION;
+    header.byte_order = IST_FILE_BYTE_ORDER;
+    header.header_size = sizeof(ISTArchiveHeader);
+    header.dimension = dimension;
+    header.tree_count = ists->tree_count;
+    header.block_vertices = block_vertices;
+    header.symbol_bits = bits;
+    header.vertex_count = vertex_count;
+    header.blocks_per_tree = blocks_per_tree;
+    header.index_offset = sizeof(ISTArchiveHeader);
+    header.data_offset = header.index_offset + block_count * sizeof(ISTArchiveBlock);
+    
+    ISTArchiveBlock* index = (ISTArchiveBlock*)calloc(block_count, sizeof(ISTArchiveBlock));
+    unsigned char* symbols = (unsigned char*)malloc(block_vertices);
+    unsigned char* packed = (unsigned char*)malloc(max_block_size(block_vertices));
+    unsigned char* rle = (unsigned char*)malloc(max_block_size(block_vertices));
+    FILE* out = fopen(path, "wb");
+    
+    int success = index && symbols && packed && rle && out &&
+                  fseek(out, (long)header.data_offset, SEEK_SET) == 0;
+    
+    uint64_t hash = FNV_OFFSET_BASIS;
+    uint64_t data_size = 0;
+    
+    for (int t = 0; t < ists->tree_count && success; t++) {
+        const int* parent = ists->trees[t].parent;
+        
+        for (uint64_t b = 0; b < blocks_per_tree && success; b++) {
+            int first = (int)(b * block_vertices);
+            int count = vertex_count - first < block_vertices ? vertex_count - first : block_vertices;
+            
+            // Map each parent to the position of its adjacent swap
+            for (int i = 0; i < count; i++) {
+                int v = first + i;
+                int position = parent[v] < 0 ? 0 : adjacent_swap_position(v, parent[v], dimension);
+                if (parent[v] >= 0 && position == 0) {
+                    success = 0;
+                    break;
+                }
+                symbols[i] = (unsigned char)position;
+            }
+            if (!success) break;
+            
+            size_t packed_size = encode_packed(symbols, count, bits, packed);
+            size_t rle_size = encode_rle(symbols, count, rle);
+            
+            ISTArchiveBlock* entry = &index[t * blocks_per_tree + b];
+            const unsigned char* encoded = rle_size < packed_size ? rle : packed;
+            entry->offset = data_size;
+            entry->size = (uint32_t)(rle_size < packed_size ? rle_size : packed_size);
+            entry->encoding = rle_size < packed_size ? IST_BLOCK_RLE : IST_BLOCK_PACKED;
+            
+            success = fwrite(encoded, 1, entry->size, out) == entry->size;
+            hash = fnv1a_hash(hash, encoded, entry->size);
+            data_size += entry->size;
+        }
+    }
+    
+    if (success) {
+        header.data_size = data_size;
+        header.checksum = fnv1a_hash(hash, index, block_count * sizeof(ISTArchiveBlock));
+        
+        success = fseek(out, 0, SEEK_SET) == 0 &&
+                  fwrite(&header, sizeof(header), 1, out) == 1 &&
+                  fwrite(index, sizeof(ISTArchiveBlock), block_count, out) == block_count;
+    }
+    
+    if (out && fclose(out) != 0) success = 0;
+    free(index);
+    free(symbols);
+    free(packed);
+    free(rle);
+    
+    return success;
+}
+
+// Map an archive read-only; returns NULL if the file is not a valid archive
+ISTArchive* open_ist_archive(const char* path, int verify_checksum) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ISTArchiveHeader)) {
+        close(fd);
+        return NULL;
+    }
+    
+    void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+    
+    ISTArchiveHeader* header = (ISTArchiveHeader*)mapping;
+    int valid = memcmp(header->magic, IST_ARCHIVE_MAGIC, sizeof(header->magic)) == 0 &&
+                header->version == IST_ARCHIVE_VERSION &&
+                header->byte_order == IST_FILE_BYTE_ORDER &&
+                header->header_size == sizeof(ISTArchiveHeader) &&
+                header->dimension >= 3 && header->dimension <= IST_STREAM_MAX_DIMENSION &&
+                header->tree_count + 1 == header->dimension &&
+                header->vertex_count == (uint64_t)factorial(header->dimension) &&
+                header->block_vertices > 0 &&
+                header->symbol_bits == (uint32_t)symbol_bits_for(header->dimension) &&
+                header->blocks_per_tree == (header->vertex_count + header->block_vertices - 1) / header->block_vertices &&
+                header->data_offset == header->index_offset +
+                    header->blocks_per_tree * header->tree_count * sizeof(ISTArchiveBlock) &&
+                header->data_offset + header->data_size <= (uint64_t)st.st_size;
+    
+    uint64_t block_count = valid ? header->blocks_per_tree * header->tree_count : 0;
+    ISTArchiveBlock* index = (ISTArchiveBlock*)((char*)mapping + (valid ? header->index_offset : 0));
+    
+    for (uint64_t b = 0; b < block_count && valid; b++) {
+        if (index[b].offset + index[b].size > header->data_size) valid = 0;
+    }
+    
+    if (valid && verify_checksum) {
+        uint64_t hash = fnv1a_hash(FNV_OFFSET_BASIS, (char*)mapping + header->data_offset, header->data_size);
+        hash = fnv1a_hash(hash, index, block_count * sizeof(ISTArchiveBlock));
+        valid = hash == header->checksum;
+    }
+    
+    ISTArchive* archive = valid ? (ISTArchive*)malloc(sizeof(ISTArchive)) : NULL;
+    int* cache = valid ? (int*)malloc(header->block_vertices * sizeof(int)) : NULL;
+    if (!archive || !cache) {
+        free(archive);
+        free(cache);
+        munmap(mapping, st.st_size);
+        return NULL;
+    }
+    
+    archive->header = header;
+    archive->index = index;
+    archive->data = (const unsigned char*)mapping + header->data_offset;
+    archive->mapping = mapping;
+    archive->mapping_size = st.st_size;
+    archive->cache = cache;
+    archive->cache_block = -1;
+    
+    return archive;
+}
+
+// Decode the parents of one block of one tree into parents
+// Returns the number of vertices in the block, 0 on failure
+int ist_archive_decode_block(ISTArchive* archive, int tree, int block, int* parents) {
+    ISTArchiveHeader* header = archive->header;
+    
+    if (tree < 0 || tree >= (int)header->tree_count) return 0;
+    if (block < 0 || (uint64_t)block >= header->blocks_per_tree) return 0;
+    
+    int dimension = header->dimension;
+    int first = block * header->block_vertices;
+    int count = (int)header->vertex_count - first < (int)header->block_vertices ?
+                (int)header->vertex_count - first : (int)header->block_vertices;
+    
+    const ISTArchiveBlock* entry = &archive->index[tree * header->blocks_per_tree + block];
+    unsigned char* symbols = (unsigned char*)malloc(count);
+    if (!symbols) return 0;
+    
+    if (!decode_symbols(archive->data + entry->offset, entry, header->symbol_bits, count, symbols)) {
+        free(symbols);
+        return 0;
+    }
+    
+    // Rebuild parent indices from swap positions
+    for (int i = 0; i < count; i++) {
+        parents[i] = symbols[i] ? adjacent_swap_index(first + i, symbols[i], dimension) : -1;
+    }
+    
+    free(symbols);
+    return count;
+}
+
+// Parent of vertex in tree (0-based), decoding only the block that holds it
+// Returns -1 for the root or on failure
+int ist_archive_parent(ISTArchive* archive, int tree, int vertex) {
+    ISTArchiveHeader* header = archive->header;
+    
+    if (tree < 0 || tree >= (int)header->tree_count) return -1;
+    if (vertex < 0 || (uint64_t)vertex >= header->vertex_count) return -1;
+    
+    int block = vertex / header->block_vertices;
+    int64_t entry = (int64_t)tree * header->blocks_per_tree + block;
+    
+    if (archive->cache_block != entry) {
+        if (!ist_archive_decode_block(archive, tree, block, archive->cache)) {
+            archive->cache_block = -1;
+            return -1;
+        }
+        archive->cache_block = entry;
+    }
+    
+    return archive->cache[vertex - block * (int)header->block_vertices];
+}
+
+// Decompress the whole archive into freshly allocated trees
+IndependentSpanningTrees* ist_archive_extract(ISTArchive* archive) {
+    ISTArchiveHeader* header = archive->header;
+    int tree_count = header->tree_count;
+    int vertex_count = (int)header->vertex_count;
+    
+    IndependentSpanningTrees* ists = (IndependentSpanningTrees*)malloc(sizeof(IndependentSpanningTrees));
+    if (!ists) return NULL;
+    
+    ists->tree_count = tree_count;
+    ists->trees = (SpanningTree*)calloc(tree_count, sizeof(SpanningTree));
+    if (!ists->trees) {
+        free(ists);
+        return NULL;
+    }
+    
+    for (int t = 0; t < tree_count; t++) {
+        ists->trees[t].vertex_count = vertex_count;
+        ists->trees[t].parent = (int*)malloc(vertex_count * sizeof(int));
+        if (!ists->trees[t].parent) {
+            free_ists(ists);
+            return NULL;
+        }
+        
+        for (uint64_t b = 0; b < header->blocks_per_tree; b++) {
+            int* parents = &ists->trees[t].parent[b * header->block_vertices];
+            if (!ist_archive_decode_block(archive, t, (int)b, parents)) {
+                free_ists(ists);
+                return NULL;
+            }
+        }
+    }
+    
+    return ists;
+}
+
+// Release an archive
+void close_ist_archive(ISTArchive* archive) {
+    if (archive) {
+        free(archive->cache);
+        munmap(archive->mapping, archive->mapping_size);
+        free(archive);
+    }
+}
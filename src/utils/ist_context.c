@@ -0,0 +1,144 @@
+#include "ist_context.h"
+#include "bubble_sort_network.h"
+#include "utils.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Create a context whose constructions use threads OpenMP threads (0 for the default)
+// Returns NULL on failure
+ISTContext* create_ist_context(int threads) {
+    ISTContext* context = (ISTContext*)calloc(1, sizeof(ISTContext));
+    if (!context) return NULL;
+    
+    context->threads = threads > 0 ? threads : 0;
+    context->ists.trees = context->trees;
+    return context;
+}
+
+void free_ist_context(ISTContext* context) {
+    if (!context) return;
+    
+    free(context->arena);
+    free(context->path);
+    free_bubble_sort_network(context->network);
+    free(context);
+}
+
+// Point the trees into the arena for dimension, growing it only if it is too small
+// Returns 1 on success, 0 on failure
+static int prepare_trees(ISTContext* context, int dimension) {
+    int vertex_count = factorial(dimension);
+    size_t needed = (size_t)(dimension - 1) * vertex_count;
+    
+    if (needed > context->arena_capacity) {
+        free(context->arena);
+        context->arena = (int*)malloc(needed * sizeof(int));
+        context->arena_capacity = context->arena ? needed : 0;
+        if (!context->arena) return 0;
+        context->arena_allocations++;
+    }
+    
+    if (dimension != context->dimension) {
+        free_bubble_sort_network(context->network);
+        context->network = NULL;
+        context->kernel = select_parent_kernel(dimension);
+    }
+    
+    context->ists.tree_count = dimension - 1;
+    for (int t = 0; t < dimension - 1; t++) {
+        context->trees[t].vertex_count = vertex_count;
+        context->trees[t].parent = context->arena + (size_t)t * vertex_count;
+    }
+    context->dimension = dimension;
+    return 1;
+}
+
+// Construct the n-1 independent spanning trees of B_dimension in the context
+// The trees belong to the context; returns NULL on failure
+IndependentSpanningTrees* ist_context_construct(ISTContext* context, int dimension) {
+    if (dimension < 3 || dimension > IST_CONTEXT_MAX_DIMENSION) {
+        printf("Dimension must be between 3 and %d\n", IST_CONTEXT_MAX_DIMENSION);
+        return NULL;
+    }
+    if (!prepare_trees(context, dimension)) {
+        context->dimension = 0;
+        return NULL;
+    }
+    
+    IndependentSpanningTrees* ists = &context->ists;
+    ParentKernel kernel = context->kernel;
+    int vertex_count = factorial(dimension);
+    int blocks = (vertex_count + IST_CONTEXT_BLOCK - 1) / IST_CONTEXT_BLOCK;
+    int threads = context->threads > 0 ? context->threads : omp_get_max_threads();
+    
+    // The kernels never write the root, whose entry may be left over from an earlier call
+    for (int t = 0; t < dimension - 1; t++) {
+        ists->trees[t].parent[0] = -1;
+    }
+    
+    // Each block writes disjoint entries of the parent arrays
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (int b = 0; b < blocks; b++) {
+        int start = b * IST_CONTEXT_BLOCK;
+        int end = vertex_count - start < IST_CONTEXT_BLOCK ? vertex_count : start + IST_CONTEXT_BLOCK;
+        kernel(ists, start, end, NULL);
+    }
+    
+    context->constructions++;
+    return ists;
+}
+
+// Network of the current dimension, built on first request
+// Returns NULL before the first construction or on failure
+BubbleSortNetwork* ist_context_network(ISTContext* context) {
+    if (context->dimension == 0) return NULL;
+    
+    if (!context->network) {
+        context->network = create_bubble_sort_network(context->dimension);
+    }
+    return context->network;
+}
+
+// Parent of vertex in tree (0-based) of the last construction
+// Returns -1 for the root or an invalid query
+int ist_context_parent(ISTContext* context, int tree, int vertex) {
+    if (context->dimension == 0 || tree < 0 || tree >= context->ists.tree_count) return -1;
+    if (vertex < 0 || vertex >= context->trees[tree].vertex_count) return -1;
+    
+    return context->trees[tree].parent[vertex];
+}
+
+// Path from vertex to the root in tree (0-based), both ends included
+// *path points into the context and is overwritten by the next query
+// Returns the number of vertices on the path, or -1 if the parents do not
+// lead to the root
+int ist_context_path(ISTContext* context, int tree, int vertex, const int** path) {
+    if (context->dimension == 0 || tree < 0 || tree >= context->ists.tree_count) return -1;
+    
+    const int* parent = context->trees[tree].parent;
+    int vertex_count = context->trees[tree].vertex_count;
+    int length = 0;
+    int current = vertex;
+    
+    // A path visits each vertex at most once, so longer walks are cycles
+    while (length <= vertex_count) {
+        if (current < 0 || current >= vertex_count) return -1;
+        
+        if (length == context->path_capacity) {
+            int capacity = context->path_capacity ? 2 * context->path_capacity : 64;
+            int* grown = (int*)realloc(context->path, capacity * sizeof(int));
+            if (!grown) return -1;
+            context->path = grown;
+            context->path_capacity = capacity;
+        }
+        
+        context->path[length++] = current;
+        if (current == 0) {
+            *path = context->path;
+            return length;
+        }
+        current = parent[current];
+    }
+    return -1;
+}
@@ -0,0 +1,262 @@
+#include "ist_io.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Combine the per-tree section hashes into the file checksum
+static uint64_t combine_tree_hashes(const uint64_t* tree_hashes, int tree_count) {
+    return fnv1a_hash(FNV_OFFSET_BASIS, tree_hashes, tree_count * sizeof(uint64_t));
+}
+
+// Round size up to a multiple of IST_FILE_ALIGNMENT
+static uint64_t align_up(uint64_t size) {
+    return (size + IST_FILE_ALIGNMENT - 1) / IST_FILE_ALIGNMENT * IST_FILE_ALIGNMENT;
+}
+
+// Write a whole buffer at a file offset
+static int pwrite_all(int fd, const void* data, size_t length, uint64_t offset) {
+    const char* bytes = (const char*)data;
+    while (length > 0) {
+        ssize_t written = pwrite(fd, bytes, length, (off_t)offset);
+        if (written <= 0) return 0;
+        bytes += written;
+        length -= written;
+        offset += written;
+    }
+    return 1;
+}
+
+// Create an IST file for B_dimension and size it for all tree sections
+ISTFileWriter* open_ists_file_writer(const char* path, int dimension) {
+    ISTFileWriter* writer = (ISTFileWriter*)calloc(1, sizeof(ISTFileWriter));
+    if (!writer) return NULL;
+    
+    int tree_count = dimension - 1;
+    uint64_t vertex_count = (uint64_t)factorial(dimension);
+    
+    ISTFileHeader* header = &writer->header;
+    memcpy(header->magic, IST_FILE_MAGIC, sizeof(header->magic));
+    header->version = IST_FILE_VERSION;
+    header->byte_order = IST_FILE_BYTE_ORDER;
+    header->header_size = sizeof(ISTFileHeader);
+    header->dimension = dimension;
+    header->tree_count = tree_count;
+    header->encoding = IST_ENCODING_INT32;
+    header->layout = IST_LAYOUT_TREE_MAJOR;
+    header->alignment = IST_FILE_ALIGNMENT;
+    header->vertex_count = vertex_count;
+    header->section_offset = align_up(sizeof(ISTFileHeader));
+    header->section_stride = align_up(vertex_count * sizeof(int32_t));
+    
+    writer->tree_hashes = (uint64_t*)malloc(tree_count * sizeof(uint64_t));
+    writer->next_vertex = (int64_t*)calloc(tree_count, sizeof(int64_t));
+    if (!writer->tree_hashes || !writer->next_vertex) {
+        free(writer->tree_hashes);
+        free(writer->next_vertex);
+        free(writer);
+        return NULL;
+    }
+    for (int t = 0; t < tree_count; t++) {
+        writer->tree_hashes[t] = FNV_OFFSET_BASIS;
+    }
+    
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    uint64_t file_size = header->section_offset + (uint64_t)tree_count * header->section_stride;
+    if (writer->fd < 0 || ftruncate(writer->fd, (off_t)file_size) != 0) {
+        if (writer->fd >= 0) close(writer->fd);
+        free(writer->tree_hashes);
+        free(writer->next_vertex);
+        free(writer);
+        return NULL;
+    }
+    
+    return writer;
+}
+
+// Write parents of vertices [first_vertex, first_vertex + vertex_count) of one tree
+// Ranges of a tree must be written in vertex order so the section hash can be
+// computed incrementally; returns 1 on success, 0 on failure
+int write_ists_tree_range(ISTFileWriter* writer, int tree, int first_vertex,
+                          int vertex_count, const int* parents) {
+    ISTFileHeader* header = &writer->header;
+    
+    if (tree < 0 || tree >= (int)header->tree_count) return 0;
+    if (first_vertex != writer->next_vertex[tree]) return 0;
+    if ((uint64_t)first_vertex + vertex_count > header->vertex_count) return 0;
+    
+    size_t length = (size_t)vertex_count * sizeof(int32_t);
+    uint64_t offset = header->section_offset + tree * header->section_stride +
+                      (uint64_t)first_vertex * sizeof(int32_t);
+    
+    if (!pwrite_all(writer->fd, parents, length, offset)) return 0;
+    
+    writer->tree_hashes[tree] = fnv1a_hash(writer->tree_hashes[tree], parents, length);
+    writer->next_vertex[tree] += vertex_count;
+    return 1;
+}
+
+// Finish the file: write the header once every section is complete
+// Returns 1 on success; an incomplete file is left without a valid header
+int close_ists_file_writer(ISTFileWriter* writer) {
+    if (!writer) return 0;
+    
+    ISTFileHeader* header = &writer->header;
+    int complete = 1;
+    for (int t = 0; t < (int)header->tree_count; t++) {
+        if ((uint64_t)writer->next_vertex[t] != header->vertex_count) {
+            complete = 0;
+        }
+    }
+    
+    int success = 0;
+    if (complete) {
+        header->checksum = combine_tree_hashes(writer->tree_hashes, header->tree_count);
+        success = pwrite_all(writer->fd, header, sizeof(ISTFileHeader), 0);
+    }
+    if (close(writer->fd) != 0) success = 0;
+    
+    free(writer->tree_hashes);
+    free(writer->next_vertex);
+    free(writer->scratch);
+    free(writer);
+    
+    return success;
+}
+
+// Stream sink storing each vertex-major block into the per-tree sections
+// user_data is an ISTFileWriter*
+int ists_file_block_sink(const ISTBlock* block, void* user_data) {
+    ISTFileWriter* writer = (ISTFileWriter*)user_data;
+    
+    if (writer->scratch_count < block->vertex_count) {
+        free(writer->scratch);
+        writer->scratch = (int*)malloc(block->vertex_count * sizeof(int));
+        if (!writer->scratch) {
+            writer->scratch_count = 0;
+            return 0;
+        }
+        writer->scratch_count = block->vertex_count;
+    }
+    
+    for (int t = 0; t < block->tree_count; t++) {
+        for (int i = 0; i < block->vertex_count; i++) {
+            writer->scratch[i] = block->parents[i * block->tree_count + t];
+        }
+        if (!write_ists_tree_range(writer, t, block->first_vertex,
+                                   block->vertex_count, writer->scratch)) {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+// Write fully materialized trees (from any engine) to an IST file
+int write_ists_file(const char* path, IndependentSpanningTrees* ists, int dimension) {
+    if (ists->tree_count != dimension - 1) return 0;
+    
+    ISTFileWriter* writer = open_ists_file_writer(path, dimension);
+    if (!writer) return 0;
+    
+    int success = 1;
+    for (int t = 0; t < ists->tree_count && success; t++) {
+        success = write_ists_tree_range(writer, t, 0, ists->trees[t].vertex_count,
+                                        ists->trees[t].parent);
+    }
+    
+    if (!close_ists_file_writer(writer)) success = 0;
+    return success;
+}
+
+// Map an IST file copy-on-write and expose it as IndependentSpanningTrees
+// The parent arrays are used in place, so the page cache is shared by every
+// process mapping the same file; writing a parent copies its page instead of
+// faulting. Returns NULL if the file is invalid
+MappedISTs* map_ists_file(const char* path, int verify_checksum) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ISTFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+    
+    void* mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+    
+    // The header is untrusted: the section extent must not overflow
+    ISTFileHeader* header = (ISTFileHeader*)mapping;
+    int extent_ok = header->tree_count > 0 &&
+                    header->section_stride <= (UINT64_MAX - header->section_offset) / header->tree_count;
+    uint64_t expected_size = extent_ok ? header->section_offset +
+                                         (uint64_t)header->tree_count * header->section_stride : UINT64_MAX;
+    
+    int valid = extent_ok &&
+                memcmp(header->magic, IST_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                header->version == IST_FILE_VERSION &&
+                header->byte_order == IST_FILE_BYTE_ORDER &&
+                header->header_size == sizeof(ISTFileHeader) &&
+                header->dimension >= 3 && header->dimension <= IST_STREAM_MAX_DIMENSION &&
+                header->encoding == IST_ENCODING_INT32 &&
+                header->layout == IST_LAYOUT_TREE_MAJOR &&
+                header->tree_count + 1 == header->dimension &&
+                header->vertex_count == (uint64_t)factorial(header->dimension) &&
+                header->section_offset % IST_FILE_ALIGNMENT == 0 &&
+                header->section_stride >= header->vertex_count * sizeof(int32_t) &&
+                expected_size <= (uint64_t)st.st_size;
+    
+    if (valid && verify_checksum) {
+        uint64_t* tree_hashes = (uint64_t*)malloc(header->tree_count * sizeof(uint64_t));
+        if (!tree_hashes) {
+            valid = 0;
+        } else {
+            for (uint32_t t = 0; t < header->tree_count; t++) {
+                const char* section = (const char*)mapping + header->section_offset +
+                                      t * header->section_stride;
+                tree_hashes[t] = fnv1a_hash(FNV_OFFSET_BASIS, section,
+                                              header->vertex_count * sizeof(int32_t));
+            }
+            valid = combine_tree_hashes(tree_hashes, header->tree_count) == header->checksum;
+            free(tree_hashes);
+        }
+    }
+    
+    MappedISTs* mapped = valid ? (MappedISTs*)malloc(sizeof(MappedISTs)) : NULL;
+    SpanningTree* trees = valid ? (SpanningTree*)malloc(header->tree_count * sizeof(SpanningTree)) : NULL;
+    if (!mapped || !trees) {
+        free(mapped);
+        free(trees);
+        munmap(mapping, st.st_size);
+        return NULL;
+    }
+    
+    for (uint32_t t = 0; t < header->tree_count; t++) {
+        trees[t].vertex_count = (int)header->vertex_count;
+        trees[t].parent = (int*)((char*)mapping + header->section_offset +
+                                 t * header->section_stride);
+    }
+    
+    mapped->ists.tree_count = header->tree_count;
+    mapped->ists.trees = trees;
+    mapped->header = header;
+    mapped->mapping = mapping;
+    mapped->mapping_size = st.st_size;
+    
+    return mapped;
+}
+
+// Release a mapped IST file (do not call free_ists on mapped->ists)
+void unmap_ists_file(MappedISTs* mapped) {
+    if (mapped) {
+        free(mapped->ists.trees);
+        munmap(mapped->mapping, mapped->mapping_size);
+        free(mapped);
+    }
+}
@@ -0,0 +1,395 @@
+#include "ist_server.h"
+#include "bubble_sort_network.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define IST_SERVER_MAX_CONNECTIONS 256     // Connections served at once
+#define IST_SERVER_POLL_MS 200             // How often the accept loop checks stop
+
+static const char* op_names[IST_OP_COUNT] = { "info", "parent", "all_parents", "path" };
+static const char* status_names[IST_STATUS_COUNT] = { "ok", "bad request", "bad tree", "bad vertex", "too large" };
+static const char* source_names[IST_SOURCE_COUNT] = { "mapped", "built", "computed" };
+
+// Parents of vertex in all trees with Parent1, unranking the vertex once
+static void computed_parents(int vertex, int n, int32_t* parents) {
+    Permutation* perm = index_to_permutation(vertex, n);
+    for (int t = 0; t < n - 1; t++) {
+        parents[t] = perm ? adjacent_swap_index(vertex, parent_swap_position(perm, t + 1, n), n) : -1;
+    }
+    free_permutation(perm);
+}
+
+// Parent of vertex in tree (0-based), -1 for the root
+// tree and vertex must be in range
+int ist_source_parent(const ISTQuerySource* source, int tree, int vertex) {
+    if (source->ists) return source->ists->trees[tree].parent[vertex];
+    if (vertex == 0) return -1;     // 0 is the identity permutation
+    
+    Permutation* perm = index_to_permutation(vertex, source->dimension);
+    if (!perm) return -1;
+    int position = parent_swap_position(perm, tree + 1, source->dimension);
+    free_permutation(perm);
+    return adjacent_swap_index(vertex, position, source->dimension);
+}
+
+// Answer one request into words, which must hold IST_QUERY_MAX_WORDS(n)
+// values; the vertices of the request are already read
+// Returns the status of the reply, word_count is set to the words written
+ISTQueryStatus answer_ist_query(const ISTQuerySource* source, const ISTQueryHeader* request,
+                                const int32_t* vertices, int32_t* words, uint32_t* word_count) {
+    int n = source->dimension;
+    int tree = request->tree;
+    uint32_t count = request->count;
+    *word_count = 0;
+    
+    if (request->magic != IST_QUERY_MAGIC || request->op >= IST_OP_COUNT) return IST_STATUS_BAD_REQUEST;
+    if (count > IST_QUERY_MAX_BATCH) return IST_STATUS_TOO_LARGE;
+    if ((request->op == IST_OP_PARENT || request->op == IST_OP_PATH) && tree >= source->tree_count) {
+        return IST_STATUS_BAD_TREE;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (vertices[i] < 0 || vertices[i] >= source->vertex_count) return IST_STATUS_BAD_VERTEX;
+    }
+    
+    uint32_t w = 0;
+    switch ((ISTQueryOp)request->op) {
+    case IST_OP_INFO:
+        words[w++] = n;
+        words[w++] = source->vertex_count;
+        words[w++] = source->tree_count;
+        words[w++] = source->kind;
+        break;
+    
+    case IST_OP_PARENT:
+        for (uint32_t i = 0; i < count; i++) {
+            words[w++] = ist_source_parent(source, tree, vertices[i]);
+        }
+        break;
+    
+    case IST_OP_ALL_PARENTS:
+        for (uint32_t i = 0; i < count; i++) {
+            int v = vertices[i];
+            if (source->ists) {
+                for (int t = 0; t < source->tree_count; t++) {
+                    words[w + t] = source->ists->trees[t].parent[v];
+                }
+            } else if (v == 0) {
+                for (int t = 0; t < source->tree_count; t++) {
+                    words[w + t] = -1;
+                }
+            } else {
+                computed_parents(v, n, words + w);
+            }
+            w += source->tree_count;
+        }
+        break;
+    
+    case IST_OP_PATH:
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t length_word = w++;
+            int length = 0;
+            int reached = 0;
+            int current = vertices[i];
+            while (length <= IST_QUERY_MAX_PATH(n)) {
+                words[w + length++] = current;
+                if (current == 0) {
+                    reached = 1;
+                    break;
+                }
+                current = ist_source_parent(source, tree, current);
+                if (current < 0 || current >= source->vertex_count) break;
+            }
+            
+            // Only a walk that ended at the root is a path
+            if (reached) {
+                words[length_word] = length;
+                w += length;
+            } else {
+                words[length_word] = -1;
+            }
+        }
+        break;
+    
+    default:
+        return IST_STATUS_BAD_REQUEST;
+    }
+    
+    *word_count = w;
+    return IST_STATUS_OK;
+}
+
+// Read exactly size bytes
+// Returns 1 on success, 0 on end of stream or error
+static int read_full(int fd, void* buffer, size_t size) {
+    char* p = (char*)buffer;
+    while (size > 0) {
+        ssize_t got = read(fd, p, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return 0;
+        p += got;
+        size -= (size_t)got;
+    }
+    return 1;
+}
+
+// Write exactly size bytes
+// Returns 1 on success, 0 on error
+static int write_full(int fd, const void* buffer, size_t size) {
+    const char* p = (const char*)buffer;
+    while (size > 0) {
+        ssize_t put = send(fd, p, size, MSG_NOSIGNAL);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return 0;
+        p += put;
+        size -= (size_t)put;
+    }
+    return 1;
+}
+
+// Whether path may be bound: it does not exist, or it is a socket that no
+// server listens on any more, which is then removed
+static int claim_socket_path(const struct sockaddr_un* address) {
+    struct stat info;
+    if (lstat(address->sun_path, &info) != 0) return errno == ENOENT;
+    if (!S_ISSOCK(info.st_mode)) {
+        printf("%s is already in use and is not a socket\n", address->sun_path);
+        return 0;
+    }
+    
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) return 0;
+    int refused = connect(probe, (const struct sockaddr*)address, sizeof(*address)) != 0 && errno == ECONNREFUSED;
+    close(probe);
+    if (!refused) {
+        printf("%s is already in use by a running server\n", address->sun_path);
+        return 0;
+    }
+    return unlink(address->sun_path) == 0;
+}
+
+// Listen on a Unix domain socket at path, replacing a stale socket file
+// Returns the listening descriptor, or -1 on failure
+int open_ist_server(const char* path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) return -1;
+    
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    
+    if (!claim_socket_path(&address)) return -1;
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// State shared by the accept loop and the connection threads
+typedef struct {
+    const ISTQuerySource* source;
+    ISTServerStats* stats;
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    int fds[IST_SERVER_MAX_CONNECTIONS];    // Open connections, -1 for a free slot
+    int active;                             // Connection threads running
+} ServerState;
+
+typedef struct {
+    ServerState* state;
+    int slot;
+} Connection;
+
+// Serve the requests of one connection until the client closes it
+static void* serve_connection(void* arg) {
+    Connection* connection = (Connection*)arg;
+    ServerState* state = connection->state;
+    const ISTQuerySource* source = state->source;
+    int fd = state->fds[connection->slot];
+    
+    int32_t* vertices = (int32_t*)malloc(IST_QUERY_MAX_BATCH * sizeof(int32_t));
+    int32_t* words = (int32_t*)malloc(IST_QUERY_MAX_WORDS(source->dimension) * sizeof(int32_t));
+    
+    ISTQueryHeader request;
+    while (vertices && words && read_full(fd, &request, sizeof(request))) {
+        ISTReplyHeader reply = { IST_QUERY_MAGIC, IST_STATUS_OK, (uint16_t)source->dimension, 0 };
+        int framed = request.magic == IST_QUERY_MAGIC && request.count <= IST_QUERY_MAX_BATCH;
+        if (framed && !read_full(fd, vertices, request.count * sizeof(int32_t))) break;
+        
+        reply.status = answer_ist_query(source, &request, vertices, words, &reply.words);
+        if (!write_full(fd, &reply, sizeof(reply)) ||
+            !write_full(fd, words, reply.words * sizeof(int32_t))) break;
+        
+        __atomic_fetch_add(&state->stats->requests, 1, __ATOMIC_RELAXED);
+        if (reply.status == IST_STATUS_OK) {
+            __atomic_fetch_add(&state->stats->lookups, request.count, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_add(&state->stats->errors, 1, __ATOMIC_RELAXED);
+        }
+        if (!framed) break;
+    }
+    free(vertices);
+    free(words);
+    
+    pthread_mutex_lock(&state->lock);
+    close(fd);
+    state->fds[connection->slot] = -1;
+    state->active--;
+    pthread_cond_signal(&state->idle);
+    pthread_mutex_unlock(&state->lock);
+    free(connection);
+    return NULL;
+}
+
+// Accept connections on listen_fd and serve each from its own thread until
+// *stop is set (from a signal handler); open connections are then shut down
+// and their threads waited for. The connection threads block SIGINT and
+// SIGTERM so that the signals reach the accept loop.
+// Returns 1 after a clean stop, 0 on failure
+int run_ist_server(int listen_fd, const ISTQuerySource* source, const volatile sig_atomic_t* stop, ISTServerStats* stats) {
+    ServerState state;
+    state.source = source;
+    state.stats = stats;
+    state.active = 0;
+    for (int i = 0; i < IST_SERVER_MAX_CONNECTIONS; i++) {
+        state.fds[i] = -1;
+    }
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.idle, NULL);
+    memset(stats, 0, sizeof(ISTServerStats));
+    
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    
+    int ok = 1;
+    while (!*stop) {
+        struct pollfd ready = { listen_fd, POLLIN, 0 };
+        int events = poll(&ready, 1, IST_SERVER_POLL_MS);
+        if (events < 0 && errno != EINTR) {
+            ok = 0;
+            break;
+        }
+        if (events <= 0) continue;
+        
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+        
+        // Take a free slot, or turn the client away when all are busy
+        pthread_mutex_lock(&state.lock);
+        int slot = -1;
+        for (int i = 0; i < IST_SERVER_MAX_CONNECTIONS && slot < 0; i++) {
+            if (state.fds[i] < 0) slot = i;
+        }
+        Connection* connection = slot >= 0 ? (Connection*)malloc(sizeof(Connection)) : NULL;
+        if (!connection) {
+            pthread_mutex_unlock(&state.lock);
+            close(fd);
+            continue;
+        }
+        connection->state = &state;
+        connection->slot = slot;
+        state.fds[slot] = fd;
+        state.active++;
+        
+        pthread_t thread;
+        pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+        int created = pthread_create(&thread, NULL, serve_connection, connection) == 0;
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (created) {
+            pthread_detach(thread);
+            stats->connections++;
+        } else {
+            close(fd);
+            state.fds[slot] = -1;
+            state.active--;
+            free(connection);
+        }
+        pthread_mutex_unlock(&state.lock);
+    }
+    
+    // Wake the connection threads blocked in read and wait for them
+    pthread_mutex_lock(&state.lock);
+    for (int i = 0; i < IST_SERVER_MAX_CONNECTIONS; i++) {
+        if (state.fds[i] >= 0) shutdown(state.fds[i], SHUT_RDWR);
+    }
+    while (state.active > 0) {
+        pthread_cond_wait(&state.idle, &state.lock);
+    }
+    pthread_mutex_unlock(&state.lock);
+    
+    pthread_mutex_destroy(&state.lock);
+    pthread_cond_destroy(&state.idle);
+    return ok;
+}
+
+// Connect to the server listening at path
+// Returns the connected descriptor, or -1 on failure
+int connect_ist_server(const char* path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) return -1;
+    
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Send one request and read its reply; words must hold capacity values
+// Returns 1 if a reply was read (check reply->status), 0 on a connection error
+// or a reply larger than capacity
+int call_ist_server(int fd, ISTQueryOp op, int tree, const int32_t* vertices, uint32_t count,
+                    ISTReplyHeader* reply, int32_t* words, size_t capacity) {
+    ISTQueryHeader request = { IST_QUERY_MAGIC, (uint16_t)op, (uint16_t)tree, count };
+    if (!write_full(fd, &request, sizeof(request)) ||
+        !write_full(fd, vertices, count * sizeof(int32_t))) return 0;
+    
+    if (!read_full(fd, reply, sizeof(ISTReplyHeader)) || reply->magic != IST_QUERY_MAGIC) return 0;
+    if (reply->words > capacity) return 0;
+    return read_full(fd, words, reply->words * sizeof(int32_t));
+}
+
+const char* ist_query_op_name(ISTQueryOp op) {
+    return op >= 0 && op < IST_OP_COUNT ? op_names[op] : "unknown";
+}
+
+// Parse info, parent, all_parents or path
+// Returns 1 on success, 0 for an unknown name
+int parse_ist_query_op(const char* name, ISTQueryOp* op) {
+    for (int o = 0; o < IST_OP_COUNT; o++) {
+        if (strcmp(name, op_names[o]) == 0) {
+            *op = (ISTQueryOp)o;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* ist_query_status_name(ISTQueryStatus status) {
+    return status >= 0 && status < IST_STATUS_COUNT ? status_names[status] : "unknown";
+}
+
+const char* ist_source_kind_name(ISTSourceKind kind) {
+    return kind >= 0 && kind < IST_SOURCE_COUNT ? source_names[kind] : "unknown";
+}
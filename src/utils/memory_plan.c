@@ -0,0 +1,271 @@
+#include "ist_memory.h"
+#include "utils.h"
+#include <limits.h>
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+static const char* storage_mode_names[STORAGE_COUNT] = { "full", "trees", "stream" };
+
+#define MIB (1024.0 * 1024.0)
+
+// Needs of a plain construction: verified, no analyses, no streaming
+void init_memory_needs(MemoryNeeds* needs, int dimension) {
+    needs->dimension = dimension;
+    needs->threads = 0;
+    needs->verify = 1;
+    needs->depth = 0;
+    needs->broadcast = 0;
+    needs->reroot = 0;
+    needs->congestion = 0;
+    needs->stream_block = 0;
+    needs->shared_copy = 0;
+    needs->tree_ranks = 1;
+}
+
+// Largest of the analyses, which run one after the other on the trees
+static uint64_t analysis_bytes(const MemoryNeeds* needs, uint64_t vertices) {
+    uint64_t trees = (uint64_t)(needs->dimension - 1);
+    uint64_t threads = needs->threads > 0 ? (uint64_t)needs->threads : (uint64_t)omp_get_max_threads();
+    
+    // Depth arrays of every tree and one walk buffer per thread
+    uint64_t depth = (trees + threads) * vertices * sizeof(int);
+    // Offsets, children and level order of every tree plus the broadcast values
+    uint64_t broadcast = trees * 3 * vertices * sizeof(int) + vertices * sizeof(uint64_t);
+    // Rerooted copies of the trees, whose depths are then reported
+    uint64_t reroot = trees * vertices * sizeof(int) + depth;
+    // Child lists, level order and subtree sizes of one tree, the vertex
+    // totals and a 32-bit total per link slot
+    uint64_t congestion = 4 * vertices * sizeof(int) + vertices * (sizeof(uint64_t) + 1)
+                        + trees * vertices * sizeof(uint32_t);
+    
+    uint64_t bytes = 0;
+    if (needs->depth && depth > bytes) bytes = depth;
+    if (needs->broadcast && broadcast > bytes) bytes = broadcast;
+    if (needs->reroot && reroot > bytes) bytes = reroot;
+    if (needs->congestion && congestion > bytes) bytes = congestion;
+    return bytes;
+}
+
+// n! in 64 bits, so that too large n are refused rather than wrapped
+static uint64_t vertex_count(int n) {
+    uint64_t vertices = 1;
+    for (int k = 2; k <= n; k++) {
+        vertices *= (uint64_t)k;
+    }
+    return vertices;
+}
+
+// Fill plan->local with the bytes each mode adds to this process
+// No mode is possible when the vertex indices would not fit in an int
+void estimate_memory(const MemoryNeeds* needs, MemoryPlan* plan) {
+    int n = needs->dimension;
+    uint64_t vertices = vertex_count(n);
+    // A rank mapping the node's shared window allocates neither, and one keeping
+    // only its share of the trees builds no edges
+    uint64_t trees = needs->shared_copy ? 0 : (uint64_t)(n - 1) * vertices * sizeof(int) / needs->tree_ranks;
+    uint64_t network = needs->shared_copy || needs->tree_ranks > 1 ? 0
+                     : (uint64_t)(n - 1) * vertices * sizeof(int) + (vertices + 1) * sizeof(int);
+    // verify_spanning_tree marks visited vertices, verify_independence holds two paths
+    uint64_t verify = needs->verify ? 3 * vertices * sizeof(int) : 0;
+    uint64_t analysis = analysis_bytes(needs, vertices);
+    
+    memset(plan, 0, sizeof(MemoryPlan));
+    plan->baseline = current_rss();
+    plan->ranks = 1;
+    plan->mode = STORAGE_FULL;
+    
+    // Analyses run before verification and free their buffers
+    plan->local[STORAGE_FULL] = trees + network + (analysis > verify ? analysis : verify);
+    plan->local[STORAGE_TREES] = trees + analysis;
+    plan->possible[STORAGE_FULL] = 1;
+    plan->possible[STORAGE_TREES] = 1;
+    
+    // Two blocks in flight plus the writer's per-tree scratch
+    if (needs->stream_block > 0 && !needs->depth && !needs->broadcast && !needs->reroot && !needs->congestion) {
+        uint64_t block = (uint64_t)needs->stream_block;
+        plan->local[STORAGE_STREAM] = 2 * block * (n - 1) * sizeof(int) + block * sizeof(int);
+        plan->possible[STORAGE_STREAM] = 1;
+    }
+    if (vertices > INT_MAX) {
+        memset(plan->possible, 0, sizeof(plan->possible));
+    }
+    
+    memcpy(plan->bytes, plan->local, sizeof(plan->bytes));
+}
+
+// Read a "Key: value kB" line of a /proc file
+// Returns the value in bytes, or 0 if the key is missing
+static uint64_t read_proc_kb(const char* path, const char* key) {
+    FILE* in = fopen(path, "r");
+    if (!in) return 0;
+    
+    char line[256];
+    size_t key_length = strlen(key);
+    uint64_t bytes = 0;
+    while (fgets(line, sizeof(line), in)) {
+        if (strncmp(line, key, key_length) == 0 && line[key_length] == ':') {
+            bytes = strtoull(line + key_length + 1, NULL, 10) * 1024;
+            break;
+        }
+    }
+    
+    fclose(in);
+    return bytes;
+}
+
+// Read a file holding a single number (cgroup limits)
+// Returns 0 if it is missing or holds "max"
+static uint64_t read_number_file(const char* path) {
+    FILE* in = fopen(path, "r");
+    if (!in) return 0;
+    
+    unsigned long long value = 0;
+    if (fscanf(in, "%llu", &value) != 1) value = 0;
+    fclose(in);
+    return (uint64_t)value;
+}
+
+// Memory this machine can still give out: MemAvailable, capped by the cgroup
+// (v2) limit minus its current usage
+// Returns 0 if unknown
+uint64_t available_memory(void) {
+    uint64_t available = read_proc_kb("/proc/meminfo", "MemAvailable");
+    
+    uint64_t limit = read_number_file("/sys/fs/cgroup/memory.max");
+    uint64_t usage = read_number_file("/sys/fs/cgroup/memory.current");
+    if (limit > 0) {
+        uint64_t headroom = limit > usage ? limit - usage : 0;
+        if (available == 0 || headroom < available) available = headroom;
+    }
+    return available;
+}
+
+// Resident set size of this process now
+uint64_t current_rss(void) {
+    return read_proc_kb("/proc/self/status", "VmRSS");
+}
+
+// Largest resident set size of this process so far
+uint64_t peak_rss(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (uint64_t)usage.ru_maxrss * 1024;
+}
+
+// Pick requested, or with STORAGE_AUTO the first possible mode that fits (the
+// leanest if none does)
+// Sets plan->mode and plan->fits; an impossible requested mode never fits
+// Returns 1 if the chosen mode can run and fits, 0 otherwise
+int choose_storage_mode(MemoryPlan* plan, StorageMode requested) {
+    if (requested != STORAGE_AUTO) {
+        plan->mode = requested;
+        plan->fits = plan->possible[requested] && plan->bytes[requested] <= plan->available;
+        return plan->fits;
+    }
+    
+    for (int m = 0; m < STORAGE_COUNT; m++) {
+        if (plan->possible[m] && plan->bytes[m] <= plan->available) {
+            plan->mode = (StorageMode)m;
+            plan->fits = 1;
+            return 1;
+        }
+    }
+    
+    // Nothing fits: the leanest possible mode comes closest
+    plan->mode = STORAGE_FULL;
+    for (int m = 0; m < STORAGE_COUNT; m++) {
+        if (plan->possible[m] && plan->bytes[m] < plan->bytes[plan->mode]) plan->mode = (StorageMode)m;
+    }
+    plan->fits = 0;
+    return 0;
+}
+
+// Plan a single process: estimate, compare with limit (0 for the available
+// memory) and choose the mode
+void plan_memory(const MemoryNeeds* needs, StorageMode requested, uint64_t limit, MemoryPlan* plan) {
+    estimate_memory(needs, plan);
+    plan->available = limit > 0 ? limit : available_memory();
+    if (plan->available == 0) plan->available = UINT64_MAX;     // Unknown: do not refuse
+    choose_storage_mode(plan, requested);
+}
+
+// Whether the run can go ahead with the plan, printing why not
+// A requested mode that does not fit only gets a warning; with STORAGE_AUTO
+// the run is refused when no mode fits. Any mode is refused when n! exceeds
+// INT_MAX
+int accept_memory_plan(FILE* out, const MemoryPlan* plan, StorageMode requested, int dimension) {
+    uint64_t vertices = vertex_count(dimension);
+    if (vertices > INT_MAX) {
+        fprintf(out, "B_%d has %llu vertices, more than int vertex indices can address (at most B_12)\n",
+                dimension, (unsigned long long)vertices);
+        return 0;
+    }
+    if (!plan->possible[plan->mode]) {
+        fprintf(out, "The %s mode is not possible for this run\n", storage_mode_names[plan->mode]);
+        return 0;
+    }
+    if (plan->fits) return 1;
+    
+    if (requested == STORAGE_AUTO) {
+        fprintf(out, "Not enough memory for B_%d: the leanest possible mode (%s) needs %.1f MiB, %.1f MiB available\n",
+                dimension, storage_mode_names[plan->mode], plan->bytes[plan->mode] / MIB, plan->available / MIB);
+        return 0;
+    }
+    
+    fprintf(out, "Warning: the %s mode needs %.1f MiB, more than the %.1f MiB available\n",
+            storage_mode_names[plan->mode], plan->bytes[plan->mode] / MIB, plan->available / MIB);
+    return 1;
+}
+
+// Print the estimate of every mode and the choice
+void print_memory_plan(FILE* out, const MemoryPlan* plan) {
+    char available[64];
+    if (plan->available == UINT64_MAX) {
+        snprintf(available, sizeof(available), "available memory unknown");
+    } else {
+        snprintf(available, sizeof(available), "%.1f MiB available", plan->available / MIB);
+    }
+    
+    if (plan->ranks > 1) {
+        fprintf(out, "Memory plan (%d ranks per node, %s per node):\n", plan->ranks, available);
+    } else {
+        fprintf(out, "Memory plan (%s):\n", available);
+    }
+    
+    for (int m = 0; m < STORAGE_COUNT; m++) {
+        if (!plan->possible[m]) {
+            fprintf(out, "  %-7s not possible for this run\n", storage_mode_names[m]);
+            continue;
+        }
+        fprintf(out, "  %-7s %10.1f MiB%s\n", storage_mode_names[m], plan->bytes[m] / MIB,
+                m == (int)plan->mode ? (plan->fits ? "  <- selected" : "  <- selected, does not fit") : "");
+    }
+}
+
+// Compare the peak RSS with the estimate of the chosen mode
+void report_peak_rss(FILE* out, const MemoryPlan* plan, uint64_t peak) {
+    fprintf(out, "\nPeak RSS %.1f MiB (estimated %.1f MiB in %s mode)\n", peak / MIB,
+            (plan->baseline + plan->local[plan->mode]) / MIB, storage_mode_names[plan->mode]);
+}
+
+// Parse auto, full, trees or stream
+// Returns 1 on success, 0 for an unknown name
+int parse_storage_mode(const char* name, StorageMode* mode) {
+    if (strcmp(name, "auto") == 0) {
+        *mode = STORAGE_AUTO;
+        return 1;
+    }
+    for (int m = 0; m < STORAGE_COUNT; m++) {
+        if (strcmp(name, storage_mode_names[m]) == 0) {
+            *mode = (StorageMode)m;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* storage_mode_name(StorageMode mode) {
+    return mode >= 0 && mode < STORAGE_COUNT ? storage_mode_names[mode] : "auto";
+}
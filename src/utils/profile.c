@@ -0,0 +1,120 @@
+#include "ist_profile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Counter block of one thread; blocks are never freed so that the counts of
+// finished threads (e.g. an OpenMP team that has been torn down) still add up
+typedef struct ProfileBlock {
+    uint64_t counts[IST_PROFILE_COUNTERS];
+    struct ProfileBlock* next;
+} ProfileBlock;
+
+static ProfileBlock* profile_blocks = NULL;
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef IST_PROFILE_CASES
+static __thread ProfileBlock* thread_block = NULL;
+
+// Counters of the calling thread, registered on first use
+uint64_t* ist_profile_thread_counters(void) {
+    static uint64_t overflow[IST_PROFILE_COUNTERS];
+    
+    if (!thread_block) {
+        ProfileBlock* block = (ProfileBlock*)calloc(1, sizeof(ProfileBlock));
+        if (!block) return overflow;
+        
+        pthread_mutex_lock(&profile_lock);
+        block->next = profile_blocks;
+        profile_blocks = block;
+        pthread_mutex_unlock(&profile_lock);
+        thread_block = block;
+    }
+    return thread_block->counts;
+}
+#endif
+
+// Whether the counters were compiled in
+int ist_profile_enabled(void) {
+#ifdef IST_PROFILE_CASES
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Sum the counters of every thread of this process into totals
+// Returns the number of threads that have counted anything
+int ist_profile_collect(uint64_t* totals) {
+    int threads = 0;
+    memset(totals, 0, IST_PROFILE_COUNTERS * sizeof(uint64_t));
+    
+    pthread_mutex_lock(&profile_lock);
+    for (ProfileBlock* block = profile_blocks; block; block = block->next) {
+        for (int i = 0; i < IST_PROFILE_COUNTERS; i++) {
+            totals[i] += block->counts[i];
+        }
+        threads++;
+    }
+    pthread_mutex_unlock(&profile_lock);
+    
+    return threads;
+}
+
+// Zero the counters of every thread (call while no thread is counting)
+void ist_profile_reset(void) {
+    pthread_mutex_lock(&profile_lock);
+    for (ProfileBlock* block = profile_blocks; block; block = block->next) {
+        memset(block->counts, 0, sizeof(block->counts));
+    }
+    pthread_mutex_unlock(&profile_lock);
+}
+
+// Name of a counter slot
+const char* ist_profile_counter_name(int slot) {
+    if (slot == IST_PROFILE_IS_SWAP_IDENTITY) return "is_swap_identity";
+    if (slot == IST_PROFILE_RIGHT_POSITION) return "right_position";
+    return parent_case_name((ParentCase)slot);
+}
+
+// Number of Parent1 calls, i.e. the sum over all cases
+static uint64_t parent1_calls(const uint64_t* totals) {
+    uint64_t calls = 0;
+    for (int c = 0; c < PARENT_CASE_COUNT; c++) {
+        calls += totals[c];
+    }
+    return calls;
+}
+
+// Print the case frequencies and helper call counts
+void ist_profile_print(FILE* out, const uint64_t* totals) {
+    uint64_t calls = parent1_calls(totals);
+    
+    fprintf(out, "Parent1 case profile (%llu calls):\n", (unsigned long long)calls);
+    for (int c = 0; c < PARENT_CASE_COUNT; c++) {
+        fprintf(out, "  %-8s %14llu  %6.2f%%\n", parent_case_name((ParentCase)c),
+                (unsigned long long)totals[c], calls ? 100.0 * totals[c] / calls : 0.0);
+    }
+    fprintf(out, "  is_swap_identity calls: %llu\n", (unsigned long long)totals[IST_PROFILE_IS_SWAP_IDENTITY]);
+    fprintf(out, "  right_position calls:   %llu\n", (unsigned long long)totals[IST_PROFILE_RIGHT_POSITION]);
+}
+
+// Write the counters as a JSON object
+// Returns 1 on success, 0 on failure
+int ist_profile_write_json(const char* path, const uint64_t* totals, int dimension,
+                           int ranks, int threads) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    fprintf(out, "{\n  \"dimension\": %d,\n  \"ranks\": %d,\n  \"threads\": %d,\n", dimension, ranks, threads);
+    fprintf(out, "  \"parent1_calls\": %llu,\n  \"cases\": {\n", (unsigned long long)parent1_calls(totals));
+    for (int c = 0; c < PARENT_CASE_COUNT; c++) {
+        fprintf(out, "    \"%s\": %llu%s\n", parent_case_name((ParentCase)c),
+                (unsigned long long)totals[c], c + 1 < PARENT_CASE_COUNT ? "," : "");
+    }
+    fprintf(out, "  },\n  \"is_swap_identity\": %llu,\n  \"right_position\": %llu\n}\n",
+            (unsigned long long)totals[IST_PROFILE_IS_SWAP_IDENTITY],
+            (unsigned long long)totals[IST_PROFILE_RIGHT_POSITION]);
+    
+    return fclose(out) == 0;
+}
@@ -0,0 +1,226 @@
+#include "ist_reroot.h"
+#include "ist_depth.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Vertices per block of materialize_rooted_tree; each block walks its
+// vertices in index order from a single unranked permutation
+#define REROOT_BLOCK 4096
+
+// Advance elements to the next permutation in index order, as next_permutation
+// Returns the first position (0-based) that changed, or -1 after the last one
+static int advance_elements(int* elements, int n) {
+    int i = n - 2;
+    while (i >= 0 && elements[i] > elements[i + 1]) {
+        i--;
+    }
+    if (i < 0) return -1;
+    
+    int j = n - 1;
+    while (elements[j] < elements[i]) {
+        j--;
+    }
+    swap(&elements[i], &elements[j]);
+    for (int l = i + 1, r = n - 1; l < r; l++, r--) {
+        swap(&elements[l], &elements[r]);
+    }
+    return i;
+}
+
+// Change of index when swapping the positions with Lehmer digits d0, d1
+// f0 and f1 are the place values of the two digits (see adjacent_swap_index)
+static inline int swap_delta(int d0, int d1, int f0, int f1) {
+    if (d0 <= d1) return (d1 + 1 - d0) * f0 + (d0 - d1) * f1;
+    return (d1 - d0) * f0 + (d0 - 1 - d1) * f1;
+}
+
+// The vertex r^-1 * v: every symbol of v replaced by its position in root
+// It is the identity exactly when v is the root
+Permutation* relabel_permutation(Permutation* root, Permutation* v) {
+    Permutation* w = copy_permutation(v);
+    if (!w) return NULL;
+    
+    for (int i = 0; i < v->n; i++) {
+        w->elements[i] = root->inverse[v->elements[i] - 1];
+    }
+    update_inverse(w);
+    return w;
+}
+
+// Parent1 for the trees rooted at root: v with the two positions swapped that
+// Parent1 swaps in the relabeled vertex (t is 1-based as in Parent1)
+// Returns NULL for the root itself or on failure
+Permutation* Parent1_rooted(Permutation* v, Permutation* root, int t, int n) {
+    Permutation* w = relabel_permutation(root, v);
+    if (!w) return NULL;
+    
+    int position = is_identity_permutation(w) ? 0 : parent_swap_position(w, t, n);
+    free_permutation(w);
+    if (position == 0) return NULL;
+    
+    Permutation* parent = copy_permutation(v);
+    if (parent) swap_adjacent(parent, position);
+    return parent;
+}
+
+// Parent of vertex in ists->trees[t] rerooted at root, read from the stored
+// identity-rooted tree
+// Returns -1 for the root, where the stored tree has no valid parent, or on failure
+int rooted_parent(IndependentSpanningTrees* ists, int dimension, int root, int vertex, int t) {
+    Permutation* r = index_to_permutation(root, dimension);
+    Permutation* v = index_to_permutation(vertex, dimension);
+    Permutation* w = r && v ? relabel_permutation(r, v) : NULL;
+    
+    int parent = -1;
+    if (w) {
+        int w_index = permutation_to_index(w, dimension);
+        int position = adjacent_swap_position(w_index, ists->trees[t].parent[w_index], dimension);
+        if (position) parent = adjacent_swap_index(vertex, position, dimension);
+    }
+    
+    free_permutation(r);
+    free_permutation(v);
+    free_permutation(w);
+    return parent;
+}
+
+// Fill parent with ists->trees[t] rerooted at root, in parallel (OpenMP)
+// Vertices are walked in index order, so parent is written sequentially and
+// the stored tree is read at the relabeled indices
+// Returns 1 on success, 0 on failure
+int materialize_rooted_tree(IndependentSpanningTrees* ists, int dimension, int root, int t, int* parent) {
+    int vertex_count = ists->trees[t].vertex_count;
+    const int* stored = ists->trees[t].parent;
+    if (dimension > IST_REROOT_MAX_DIMENSION || root < 0 || root >= vertex_count) return 0;
+    
+    Permutation* r = index_to_permutation(root, dimension);
+    if (!r) return 0;
+    const int* root_inverse = r->inverse;
+    
+    int fact[IST_REROOT_MAX_DIMENSION + 1];
+    fact[0] = 1;
+    for (int i = 1; i <= dimension; i++) {
+        fact[i] = fact[i - 1] * i;
+    }
+    
+    int block_count = (vertex_count + REROOT_BLOCK - 1) / REROOT_BLOCK;
+    int ok = 1;
+    
+    #pragma omp parallel for schedule(dynamic, 1) reduction(&&:ok)
+    for (int b = 0; b < block_count; b++) {
+        int first = b * REROOT_BLOCK;
+        int last = first + REROOT_BLOCK < vertex_count ? first + REROOT_BLOCK : vertex_count;
+        Permutation* start = index_to_permutation(first, dimension);
+        if (!start) {
+            ok = 0;
+            continue;
+        }
+        
+        // w = r^-1 * v is ranked incrementally: advancing v only changes a
+        // suffix, and with it only the Lehmer digits of that suffix of v and w
+        int v[IST_REROOT_MAX_DIMENSION];
+        int w[IST_REROOT_MAX_DIMENSION];
+        int v_digits[IST_REROOT_MAX_DIMENSION];
+        int digits[IST_REROOT_MAX_DIMENSION] = {0};
+        int w_index = 0;
+        int changed = 0;
+        memcpy(v, start->elements, dimension * sizeof(int));
+        free_permutation(start);
+        
+        for (int vertex = first; vertex < last; vertex++) {
+            for (int j = changed; j < dimension; j++) {
+                w[j] = root_inverse[v[j] - 1];
+            }
+            for (int j = changed; j < dimension; j++) {
+                int smaller = 0;
+                int v_smaller = 0;
+                for (int k = j + 1; k < dimension; k++) {
+                    smaller += w[k] < w[j];
+                    v_smaller += v[k] < v[j];
+                }
+                v_digits[j] = v_smaller;
+                w_index += (smaller - digits[j]) * fact[dimension - 1 - j];
+                digits[j] = smaller;
+            }
+            int target = stored[w_index];
+            
+            // The swap position is the one whose neighbor of w is the stored parent
+            int i = 0;
+            if (target >= 0) {
+                while (i < dimension - 1 &&
+                       w_index + swap_delta(digits[i], digits[i + 1], fact[dimension - i - 1],
+                                            fact[dimension - i - 2]) != target) {
+                    i++;
+                }
+            }
+            
+            if (target < 0 || i == dimension - 1) {
+                parent[vertex] = -1;
+            } else {
+                // Swap the same positions in v
+                parent[vertex] = vertex + swap_delta(v_digits[i], v_digits[i + 1], fact[dimension - i - 1],
+                                                     fact[dimension - i - 2]);
+            }
+            changed = advance_elements(v, dimension);
+        }
+    }
+    
+    free_permutation(r);
+    return ok;
+}
+
+// All trees of ists rerooted at root, in newly allocated trees
+// Returns NULL on failure
+IndependentSpanningTrees* reroot_ists(IndependentSpanningTrees* ists, int dimension, int root) {
+    IndependentSpanningTrees* rooted = (IndependentSpanningTrees*)malloc(sizeof(IndependentSpanningTrees));
+    if (!rooted) return NULL;
+    
+    rooted->tree_count = ists->tree_count;
+    rooted->trees = (SpanningTree*)calloc(ists->tree_count, sizeof(SpanningTree));
+    if (!rooted->trees) {
+        free(rooted);
+        return NULL;
+    }
+    
+    for (int t = 0; t < ists->tree_count; t++) {
+        int vertex_count = ists->trees[t].vertex_count;
+        rooted->trees[t].vertex_count = vertex_count;
+        rooted->trees[t].parent = (int*)malloc(vertex_count * sizeof(int));
+        if (!rooted->trees[t].parent ||
+            !materialize_rooted_tree(ists, dimension, root, t, rooted->trees[t].parent)) {
+            free_ists(rooted);
+            return NULL;
+        }
+    }
+    return rooted;
+}
+
+// Reroot all trees at root and print the time and the depths of the new trees
+// Relabeling is an automorphism, so the depths match those of the identity-rooted trees
+// Returns 1 on success, 0 on failure
+int report_reroot(FILE* out, IndependentSpanningTrees* ists, int dimension, int root) {
+    if (root < 0 || root >= ists->trees[0].vertex_count) {
+        fprintf(out, "Root %d is not a vertex of B_%d\n", root, dimension);
+        return 0;
+    }
+    
+    double start_time = measure_time();
+    IndependentSpanningTrees* rooted = reroot_ists(ists, dimension, root);
+    double end_time = measure_time();
+    if (!rooted) {
+        fprintf(out, "Failed to reroot ISTs at vertex %d\n", root);
+        return 0;
+    }
+    
+    fprintf(out, "\nTrees rerooted at vertex %d in %.6f seconds\n", root, end_time - start_time);
+    
+    TreeDepths* depths = compute_ists_depths(rooted, root);
+    if (depths) {
+        print_depth_stats(out, depths, rooted->tree_count);
+        free_ists_depths(depths, rooted->tree_count);
+    }
+    
+    free_ists(rooted);
+    return depths != NULL;
+}
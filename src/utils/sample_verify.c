@@ -0,0 +1,282 @@
+#include "ist_sample.h"
+#include "bubble_sort_network.h"
+#include "utils.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* verify_mode_names[VERIFY_COUNT] = { "full", "sample", "none" };
+
+// IST_SAMPLE_DEFAULT random vertices from seed 1 plus the built-in edge cases
+void init_sample_options(SampleOptions* options) {
+    options->samples = IST_SAMPLE_DEFAULT;
+    options->seed = 1;
+    options->edge_cases = 1;
+    options->vertex_count = 0;
+}
+
+// Add a vertex that is always checked
+// Returns 1 on success, 0 if IST_SAMPLE_MAX_VERTICES are already given
+int add_sample_vertex(SampleOptions* options, int vertex) {
+    if (options->vertex_count == IST_SAMPLE_MAX_VERTICES) return 0;
+    
+    options->vertices[options->vertex_count++] = vertex;
+    return 1;
+}
+
+// splitmix64, which spreads any seed (0 included) over the whole state
+static uint64_t next_sample(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Parent of vertex in tree t (0-based) as Parent1 gives it
+// Returns -1 if Parent1 gives no adjacent swap
+static int rule_parent(int vertex, int t, int n) {
+    Permutation* perm = index_to_permutation(vertex, n);
+    if (!perm) return -1;
+    
+    int position = parent_swap_position(perm, t + 1, n);
+    free_permutation(perm);
+    if (position < 1 || position > n - 1) return -1;
+    return adjacent_swap_index(vertex, position, n);
+}
+
+// Path vertices are keyed by vertex and tree so that sorting groups equal vertices
+static int compare_keys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Check the paths from vertex to the root in all trees, computing the parents
+// on the fly if ists is NULL; the first problem found is printed to out unless
+// out is NULL
+// Returns 1 if the vertex passes, 0 otherwise
+int check_sampled_vertex(IndependentSpanningTrees* ists, int dimension, int vertex, FILE* out) {
+    int n = dimension;
+    int vertex_count = factorial(n);
+    if (vertex < 0 || vertex >= vertex_count) {
+        if (out) fprintf(out, "Vertex %d is not a vertex of B_%d\n", vertex, n);
+        return 0;
+    }
+    
+    int max_path = IST_SAMPLE_MAX_PATH(n);
+    uint64_t* keys = (uint64_t*)malloc((size_t)(n - 1) * max_path * sizeof(uint64_t));
+    if (!keys) return 0;
+    
+    int key_count = 0;
+    int valid = 1;
+    for (int t = 0; t < n - 1 && valid; t++) {
+        int current = vertex;
+        int steps = 0;
+        while (current != 0) {     // 0 is the identity permutation
+            if (steps == max_path) {
+                if (out) fprintf(out, "Vertex %d: the path in tree %d does not reach the root within %d steps\n",
+                                 vertex, t + 1, max_path);
+                valid = 0;
+                break;
+            }
+            
+            int expected = rule_parent(current, t, n);
+            int parent = ists ? ists->trees[t].parent[current] : expected;
+            if (parent < 0 || parent >= vertex_count) {
+                if (out) fprintf(out, "Vertex %d: invalid parent %d of vertex %d in tree %d\n",
+                                 vertex, parent, current, t + 1);
+                valid = 0;
+                break;
+            }
+            if (!adjacent_swap_position(current, parent, n)) {
+                if (out) fprintf(out, "Vertex %d: parent %d of vertex %d in tree %d is not a neighbor\n",
+                                 vertex, parent, current, t + 1);
+                valid = 0;
+                break;
+            }
+            if (parent != expected) {
+                if (out) fprintf(out, "Vertex %d: parent %d of vertex %d in tree %d differs from Parent1 (%d)\n",
+                                 vertex, parent, current, t + 1, expected);
+                valid = 0;
+                break;
+            }
+            
+            // The paths must share nothing but vertex and the root
+            if (current != vertex) keys[key_count++] = (uint64_t)current << 8 | (uint64_t)t;
+            current = parent;
+            steps++;
+        }
+    }
+    
+    if (valid) {
+        qsort(keys, key_count, sizeof(uint64_t), compare_keys);
+        for (int i = 1; i < key_count; i++) {
+            if (keys[i] >> 8 == keys[i - 1] >> 8) {
+                if (out) fprintf(out, "Vertex %d: trees %d and %d share vertex %d on their paths to the root\n",
+                                 vertex, (int)(keys[i - 1] & 0xff) + 1, (int)(keys[i] & 0xff) + 1,
+                                 (int)(keys[i] >> 8));
+                valid = 0;
+                break;
+            }
+        }
+    }
+    
+    free(keys);
+    return valid;
+}
+
+// Built-in edge cases of B_n, see ist_sample.h
+// Returns the number of vertices written to vertices (at most 2n)
+static int edge_case_vertices(int n, int* vertices) {
+    int count = 0;
+    
+    // Neighbors of the root: paths of length one
+    for (int position = 1; position < n; position++) {
+        vertices[count++] = adjacent_swap_index(0, position, n);
+    }
+    
+    // The reversal, the last vertex in Lehmer order
+    vertices[count++] = factorial(n) - 1;
+    
+    // Each last symbol with the other symbols in order, which covers the
+    // branches of Parent1 on the last symbol
+    Permutation* perm = create_permutation(n);
+    if (!perm) return count;
+    for (int s = 1; s <= n; s++) {
+        int k = 0;
+        for (int symbol = 1; symbol <= n; symbol++) {
+            if (symbol != s) perm->elements[k++] = symbol;
+        }
+        perm->elements[n - 1] = s;
+        update_inverse(perm);
+        vertices[count++] = permutation_to_index(perm, n);
+    }
+    free_permutation(perm);
+    
+    return count;
+}
+
+// Check the edge cases, the given vertices and options->samples random vertices
+// The first failure is printed to out unless out is NULL
+// Returns 1 if every checked vertex passes, 0 otherwise
+int sample_verify(IndependentSpanningTrees* ists, int dimension, const SampleOptions* options,
+                  SampleReport* report, FILE* out) {
+    memset(report, 0, sizeof(SampleReport));
+    report->first_failure = -1;
+    double start_time = measure_time();
+    int vertex_count = factorial(dimension);
+    
+    // Fixed vertices, each checked once
+    int* fixed = (int*)malloc((2 * dimension + options->vertex_count) * sizeof(int));
+    if (!fixed) return 0;
+    int fixed_count = options->edge_cases ? edge_case_vertices(dimension, fixed) : 0;
+    for (int i = 0; i < options->vertex_count; i++) {
+        fixed[fixed_count++] = options->vertices[i];
+    }
+    
+    for (int i = 0; i < fixed_count; i++) {
+        int duplicate = 0;
+        for (int j = 0; j < i; j++) {
+            if (fixed[j] == fixed[i]) duplicate = 1;
+        }
+        if (duplicate) continue;
+        
+        report->fixed_checked++;
+        if (!check_sampled_vertex(ists, dimension, fixed[i], report->first_failure < 0 ? out : NULL)) {
+            report->fixed_failed++;
+            if (report->first_failure < 0) report->first_failure = fixed[i];
+        }
+    }
+    free(fixed);
+    
+    // Uniform random vertices other than the root, with replacement
+    uint64_t state = options->seed;
+    for (int k = 0; k < options->samples; k++) {
+        int vertex = 1 + (int)(next_sample(&state) % (uint64_t)(vertex_count - 1));
+        report->random_checked++;
+        if (!check_sampled_vertex(ists, dimension, vertex, report->first_failure < 0 ? out : NULL)) {
+            report->random_failed++;
+            if (report->first_failure < 0) report->first_failure = vertex;
+        }
+    }
+    
+    // With no failure among K random vertices, fractions above the bound
+    // would have shown one with probability IST_SAMPLE_CONFIDENCE
+    report->failure_bound = 1.0;
+    if (report->random_checked > 0 && report->random_failed == 0) {
+        report->failure_bound = 1.0 - pow(1.0 - IST_SAMPLE_CONFIDENCE, 1.0 / report->random_checked);
+    }
+    
+    report->seconds = measure_time() - start_time;
+    return report->random_failed == 0 && report->fixed_failed == 0;
+}
+
+// Sample the trees, printing the progress and the confidence bound
+// Returns 1 if every checked vertex passes, 0 otherwise
+int report_sample_verification(FILE* out, IndependentSpanningTrees* ists, int dimension,
+                               const SampleOptions* options) {
+    fprintf(out, "\nVerifying %d random vertices%s by sampling%s...\n", options->samples,
+            options->edge_cases || options->vertex_count ? " and the edge cases" : "",
+            ists ? "" : " (parents computed on the fly)");
+    
+    SampleReport report;
+    int valid = sample_verify(ists, dimension, options, &report, out);
+    int checked = report.random_checked + report.fixed_checked;
+    
+    if (!valid) {
+        fprintf(out, "%d of %d random vertices and %d of %d edge cases fail (first: vertex %d)\n",
+                report.random_failed, report.random_checked, report.fixed_failed, report.fixed_checked,
+                report.first_failure);
+        return 0;
+    }
+    
+    fprintf(out, "All %d sampled vertices pass (%.6f seconds)\n", checked, report.seconds);
+    if (report.random_checked > 0) {
+        int vertex_count = factorial(dimension);
+        fprintf(out, "At %.0f%% confidence at most %.4f%% of the vertices (about %.0f of %d) fail\n",
+                100.0 * IST_SAMPLE_CONFIDENCE, 100.0 * report.failure_bound,
+                ceil(report.failure_bound * vertex_count), vertex_count);
+    }
+    return 1;
+}
+
+// Verify the trees as mode asks: in full if the trees and the network edges are
+// in memory (VERIFY_AUTO or VERIFY_FULL), by sampling otherwise; ists may be
+// NULL and network NULL or without edges
+// Returns 1 if the trees pass (or are not verified), 0 otherwise
+int verify_ists(FILE* out, VerifyMode mode, IndependentSpanningTrees* ists, BubbleSortNetwork* network,
+                int dimension, const SampleOptions* options) {
+    if (mode == VERIFY_NONE) {
+        fprintf(out, "\nThe trees are not verified\n");
+        return 1;
+    }
+    
+    int complete = ists && network && network->adjacency;
+    if (mode != VERIFY_SAMPLE && complete) {
+        return report_verification(ists, network);
+    }
+    if (mode == VERIFY_FULL) {
+        fprintf(out, "\nFull verification needs the trees and the network edges in memory; sampling instead\n");
+    }
+    return report_sample_verification(out, ists, dimension, options);
+}
+
+// Parse auto, full, sample or none
+// Returns 1 on success, 0 for an unknown name
+int parse_verify_mode(const char* name, VerifyMode* mode) {
+    if (strcmp(name, "auto") == 0) {
+        *mode = VERIFY_AUTO;
+        return 1;
+    }
+    for (int m = 0; m < VERIFY_COUNT; m++) {
+        if (strcmp(name, verify_mode_names[m]) == 0) {
+            *mode = (VerifyMode)m;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* verify_mode_name(VerifyMode mode) {
+    return mode >= 0 && mode < VERIFY_COUNT ? verify_mode_names[mode] : "auto";
+}
@@ -0,0 +1,269 @@
+#include "ist_timeline.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// Span buffer of one thread, registered on first use and kept for reuse
+typedef struct TimelineThread {
+    int thread;
+    int dropped;
+    double totals[SPAN_KIND_COUNT];
+    TimelineSpan* spans;
+    int span_count;
+    int span_capacity;
+    struct TimelineThread* next;
+} TimelineThread;
+
+static TimelineThread* timeline_threads = NULL;
+static int timeline_thread_count = 0;
+static pthread_mutex_t timeline_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread TimelineThread* thread_timeline = NULL;
+static double timeline_origin = 0.0;
+static int timeline_active = 0;
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Buffer of the calling thread, NULL if it cannot be allocated
+static TimelineThread* current_thread(void) {
+    if (!thread_timeline) {
+        TimelineThread* block = (TimelineThread*)calloc(1, sizeof(TimelineThread));
+        if (!block) return NULL;
+        
+        pthread_mutex_lock(&timeline_lock);
+        block->thread = timeline_thread_count++;
+        block->next = timeline_threads;
+        timeline_threads = block;
+        pthread_mutex_unlock(&timeline_lock);
+        thread_timeline = block;
+    }
+    return thread_timeline;
+}
+
+// Clear all buffers and start recording; times are relative to this call
+void timeline_start(void) {
+    pthread_mutex_lock(&timeline_lock);
+    for (TimelineThread* block = timeline_threads; block; block = block->next) {
+        block->span_count = 0;
+        block->dropped = 0;
+        memset(block->totals, 0, sizeof(block->totals));
+    }
+    pthread_mutex_unlock(&timeline_lock);
+    
+    current_thread();   // The calling thread is thread 0
+    timeline_origin = monotonic_seconds();
+    timeline_active = 1;
+}
+
+// Stop recording; the spans stay available for collection
+void timeline_stop(void) {
+    timeline_active = 0;
+}
+
+int timeline_enabled(void) {
+    return timeline_active;
+}
+
+// Seconds since timeline_start
+double timeline_now(void) {
+    return monotonic_seconds() - timeline_origin;
+}
+
+// Append a span to the calling thread's buffer
+static TimelineSpan* add_span(SpanKind kind, double start, double end) {
+    TimelineThread* block = current_thread();
+    if (!block) return NULL;
+    
+    block->totals[kind] += end - start;
+    
+    if (block->span_count == block->span_capacity) {
+        if (block->span_capacity == TIMELINE_MAX_SPANS) {
+            block->dropped++;
+            return NULL;
+        }
+        int capacity = block->span_capacity ? 2 * block->span_capacity : 64;
+        TimelineSpan* spans = (TimelineSpan*)realloc(block->spans, capacity * sizeof(TimelineSpan));
+        if (!spans) {
+            block->dropped++;
+            return NULL;
+        }
+        block->spans = spans;
+        block->span_capacity = capacity;
+    }
+    
+    TimelineSpan* span = &block->spans[block->span_count++];
+    memset(span, 0, sizeof(TimelineSpan));
+    span->thread = block->thread;
+    span->kind = kind;
+    span->start = start;
+    span->end = end;
+    return span;
+}
+
+// Record a span of the calling thread (no-op while stopped)
+void timeline_span(SpanKind kind, double start, double end) {
+    if (timeline_active) add_span(kind, start, end);
+}
+
+// Record a chunk of vertices together with its unrank/parent breakdown
+void timeline_compute_span(double start, double end, int vertices, double unrank, double parent) {
+    if (!timeline_active) return;
+    
+    TimelineThread* block = current_thread();
+    if (!block) return;
+    block->totals[SPAN_UNRANK] += unrank;
+    block->totals[SPAN_PARENT] += parent;
+    
+    TimelineSpan* span = add_span(SPAN_COMPUTE, start, end);
+    if (span) {
+        span->vertices = vertices;
+        span->unrank = unrank;
+        span->parent = parent;
+    }
+}
+
+// Printable name of a span kind
+const char* timeline_kind_name(SpanKind kind) {
+    static const char* names[SPAN_KIND_COUNT] = {
+        "compute", "unrank", "parent", "allgather", "checkpoint", "verify"
+    };
+    return kind >= 0 && kind < SPAN_KIND_COUNT ? names[kind] : "unknown";
+}
+
+// Copy the workers and spans of this process into new arrays, tagged with rank
+// Returns 1 on success, 0 on failure (the caller frees both arrays)
+int timeline_collect(int rank, TimelineWorker** workers, int* worker_count,
+                     TimelineSpan** spans, int* span_count) {
+    pthread_mutex_lock(&timeline_lock);
+    
+    int total_spans = 0;
+    for (TimelineThread* block = timeline_threads; block; block = block->next) {
+        total_spans += block->span_count;
+    }
+    
+    *workers = (TimelineWorker*)calloc(timeline_thread_count ? timeline_thread_count : 1, sizeof(TimelineWorker));
+    *spans = (TimelineSpan*)malloc((total_spans ? total_spans : 1) * sizeof(TimelineSpan));
+    if (!*workers || !*spans) {
+        pthread_mutex_unlock(&timeline_lock);
+        free(*workers);
+        free(*spans);
+        *workers = NULL;
+        *spans = NULL;
+        return 0;
+    }
+    
+    int w = 0;
+    int s = 0;
+    for (TimelineThread* block = timeline_threads; block; block = block->next) {
+        TimelineWorker* worker = &(*workers)[w++];
+        worker->rank = rank;
+        worker->thread = block->thread;
+        worker->dropped = block->dropped;
+        memcpy(worker->totals, block->totals, sizeof(worker->totals));
+        
+        for (int i = 0; i < block->span_count; i++) {
+            (*spans)[s] = block->spans[i];
+            (*spans)[s].rank = rank;
+            s++;
+        }
+    }
+    
+    pthread_mutex_unlock(&timeline_lock);
+    *worker_count = w;
+    *span_count = s;
+    return 1;
+}
+
+// Print min/mean/max of every kind over the workers that spent time on it,
+// with the load imbalance max/mean, then the per-rank compute totals
+void timeline_print_stats(FILE* out, const TimelineWorker* workers, int worker_count) {
+    fprintf(out, "Timeline (seconds per rank/thread):\n");
+    fprintf(out, "  %-10s %7s %10s %10s %10s %9s\n", "span", "workers", "min", "mean", "max", "imbalance");
+    
+    for (int kind = 0; kind < SPAN_KIND_COUNT; kind++) {
+        int count = 0;
+        double min = 0.0, max = 0.0, sum = 0.0;
+        for (int w = 0; w < worker_count; w++) {
+            double value = workers[w].totals[kind];
+            if (value <= 0.0) continue;
+            if (count == 0 || value < min) min = value;
+            if (count == 0 || value > max) max = value;
+            sum += value;
+            count++;
+        }
+        if (count == 0) continue;
+        
+        double mean = sum / count;
+        fprintf(out, "  %-10s %7d %10.6f %10.6f %10.6f %9.3f\n",
+                timeline_kind_name((SpanKind)kind), count, min, mean, max, max / mean);
+    }
+    
+    // Compute time of each rank (sum over its threads) exposes slow ranks
+    int ranks = 0;
+    for (int w = 0; w < worker_count; w++) {
+        if (workers[w].rank + 1 > ranks) ranks = workers[w].rank + 1;
+    }
+    double* per_rank = (double*)calloc(ranks ? ranks : 1, sizeof(double));
+    if (per_rank && ranks > 1) {
+        int dropped = 0;
+        for (int w = 0; w < worker_count; w++) {
+            per_rank[workers[w].rank] += workers[w].totals[SPAN_COMPUTE];
+            dropped += workers[w].dropped;
+        }
+        
+        int slowest = 0;
+        double sum = 0.0;
+        for (int r = 0; r < ranks; r++) {
+            sum += per_rank[r];
+            if (per_rank[r] > per_rank[slowest]) slowest = r;
+        }
+        double mean = sum / ranks;
+        fprintf(out, "  Slowest rank: %d (%.6f s compute, imbalance %.3f)\n",
+                slowest, per_rank[slowest], mean > 0 ? per_rank[slowest] / mean : 0.0);
+        if (dropped) fprintf(out, "  %d spans dropped (buffer full)\n", dropped);
+    }
+    free(per_rank);
+}
+
+// Write the spans in Chrome trace format (chrome://tracing, ui.perfetto.dev)
+// Each rank is a process and each thread a track
+// Returns 1 on success, 0 on failure
+int timeline_write_trace(const char* path, const TimelineWorker* workers, int worker_count,
+                         const TimelineSpan* spans, int span_count) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    
+    int first = 1;
+    for (int w = 0; w < worker_count; w++) {
+        if (workers[w].thread == 0) {
+            fprintf(out, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}",
+                    first ? "" : ",\n", workers[w].rank, workers[w].rank);
+            first = 0;
+        }
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", workers[w].rank, workers[w].thread, workers[w].thread);
+        first = 0;
+    }
+    
+    for (int i = 0; i < span_count; i++) {
+        const TimelineSpan* span = &spans[i];
+        fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"ist\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                first ? "" : ",\n", timeline_kind_name((SpanKind)span->kind), span->rank, span->thread,
+                span->start * 1e6, (span->end - span->start) * 1e6);
+        if (span->kind == SPAN_COMPUTE) {
+            fprintf(out, ",\"args\":{\"vertices\":%d,\"unrank_us\":%.3f,\"parent_us\":%.3f}",
+                    span->vertices, span->unrank * 1e6, span->parent * 1e6);
+        }
+        fprintf(out, "}");
+        first = 0;
+    }
+    
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
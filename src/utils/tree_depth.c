@@ -0,0 +1,197 @@
+#include "ist_depth.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Marks in depth[] while the walk is running
+#define DEPTH_UNKNOWN -2
+#define DEPTH_ON_PATH -3
+
+// Depth of every vertex of tree, with the height, mean and histogram
+// Returns 1 on success, 0 on failure (depths is left empty)
+int compute_tree_depths(SpanningTree* tree, int root, TreeDepths* depths) {
+    int vertex_count = tree->vertex_count;
+    const int* parent = tree->parent;
+    
+    memset(depths, 0, sizeof(TreeDepths));
+    if (root < 0 || root >= vertex_count) return 0;
+    
+    depths->depth = (int*)malloc(vertex_count * sizeof(int));
+    int* path = (int*)malloc(vertex_count * sizeof(int));
+    if (!depths->depth || !path) {
+        free(path);
+        free_tree_depths(depths);
+        return 0;
+    }
+    depths->vertex_count = vertex_count;
+    depths->root = root;
+    int* depth = depths->depth;
+    
+    for (int v = 0; v < vertex_count; v++) {
+        depth[v] = DEPTH_UNKNOWN;
+    }
+    depth[root] = 0;
+    
+    // Walk up from every vertex not seen yet until a vertex of known depth,
+    // then assign the depths on the way back; each vertex is walked once
+    for (int v = 0; v < vertex_count; v++) {
+        if (depth[v] != DEPTH_UNKNOWN) continue;
+        
+        int length = 0;
+        int current = v;
+        while (current >= 0 && current < vertex_count && depth[current] == DEPTH_UNKNOWN) {
+            depth[current] = DEPTH_ON_PATH;
+            path[length++] = current;
+            current = parent[current];
+        }
+        
+        // An invalid parent, a cycle (back on this path) or an unreachable vertex
+        int base = current >= 0 && current < vertex_count && depth[current] >= 0
+                   ? depth[current] : IST_DEPTH_UNREACHABLE;
+        while (length > 0) {
+            if (base != IST_DEPTH_UNREACHABLE) base++;
+            depth[path[--length]] = base;
+        }
+    }
+    free(path);
+    
+    long long depth_sum = 0;
+    for (int v = 0; v < vertex_count; v++) {
+        if (depth[v] == IST_DEPTH_UNREACHABLE) continue;
+        if (depth[v] > depths->height) depths->height = depth[v];
+        depth_sum += depth[v];
+        depths->reachable++;
+    }
+    depths->mean_depth = (double)depth_sum / depths->reachable;
+    
+    depths->histogram = (int*)calloc(depths->height + 1, sizeof(int));
+    if (!depths->histogram) {
+        free_tree_depths(depths);
+        return 0;
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        if (depth[v] != IST_DEPTH_UNREACHABLE) depths->histogram[depth[v]]++;
+    }
+    
+    return 1;
+}
+
+// Release the arrays of one tree
+void free_tree_depths(TreeDepths* depths) {
+    if (depths) {
+        free(depths->depth);
+        free(depths->histogram);
+        depths->depth = NULL;
+        depths->histogram = NULL;
+    }
+}
+
+// Depths of every tree, all rooted at root; the trees are done in parallel
+// Returns an array of ists->tree_count entries, or NULL on failure
+TreeDepths* compute_ists_depths(IndependentSpanningTrees* ists, int root) {
+    TreeDepths* depths = (TreeDepths*)calloc(ists->tree_count, sizeof(TreeDepths));
+    if (!depths) return NULL;
+    
+    int ok = 1;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(&&:ok)
+    for (int t = 0; t < ists->tree_count; t++) {
+        ok = compute_tree_depths(&ists->trees[t], root, &depths[t]) && ok;
+    }
+    
+    if (!ok) {
+        free_ists_depths(depths, ists->tree_count);
+        return NULL;
+    }
+    return depths;
+}
+
+void free_ists_depths(TreeDepths* depths, int tree_count) {
+    if (!depths) return;
+    for (int t = 0; t < tree_count; t++) {
+        free_tree_depths(&depths[t]);
+    }
+    free(depths);
+}
+
+// Print height, mean depth and histogram of every tree
+void print_depth_stats(FILE* out, const TreeDepths* depths, int tree_count) {
+    fprintf(out, "Tree depths (root-path lengths):\n");
+    fprintf(out, "  %-6s %7s %11s %12s\n", "tree", "height", "mean depth", "unreachable");
+    
+    int max_height = 0;
+    for (int t = 0; t < tree_count; t++) {
+        const TreeDepths* d = &depths[t];
+        fprintf(out, "  T_%-4d %7d %11.3f %12d\n", t + 1, d->height, d->mean_depth,
+                d->vertex_count - d->reachable);
+        if (d->height > max_height) max_height = d->height;
+    }
+    fprintf(out, "  Max height: %d\n", max_height);
+    
+    for (int t = 0; t < tree_count; t++) {
+        fprintf(out, "  T_%d histogram:", t + 1);
+        for (int level = 0; level <= depths[t].height; level++) {
+            fprintf(out, " %d", depths[t].histogram[level]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// Write the per-tree statistics as a JSON array
+void write_depths_json(FILE* out, const TreeDepths* depths, int tree_count) {
+    fprintf(out, "[");
+    for (int t = 0; t < tree_count; t++) {
+        const TreeDepths* d = &depths[t];
+        fprintf(out, "%s{\"tree\": %d, \"height\": %d, \"mean_depth\": %.6f, \"reachable\": %d, "
+                "\"unreachable\": %d, \"histogram\": [", t ? ", " : "", t + 1, d->height,
+                d->mean_depth, d->reachable, d->vertex_count - d->reachable);
+        for (int level = 0; level <= d->height; level++) {
+            fprintf(out, "%s%d", level ? ", " : "", d->histogram[level]);
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "]");
+}
+
+// Write the statistics of all trees to a JSON file
+// Returns 1 on success, 0 on failure
+int write_depth_json(const char* path, const TreeDepths* depths, int tree_count, int dimension) {
+    FILE* out = fopen(path, "w");
+    if (!out) return 0;
+    
+    int max_height = 0;
+    for (int t = 0; t < tree_count; t++) {
+        if (depths[t].height > max_height) max_height = depths[t].height;
+    }
+    
+    fprintf(out, "{\n  \"dimension\": %d,\n  \"vertices\": %d,\n  \"root\": %d,\n  \"max_height\": %d,\n",
+            dimension, tree_count ? depths[0].vertex_count : 0, tree_count ? depths[0].root : 0, max_height);
+    fprintf(out, "  \"trees\": ");
+    write_depths_json(out, depths, tree_count);
+    fprintf(out, "\n}\n");
+    
+    return fclose(out) == 0;
+}
+
+// Compute, print and optionally write the depth statistics of all trees
+// rooted at the identity; returns 1 on success, 0 on failure
+int report_tree_depths(FILE* out, IndependentSpanningTrees* ists, int dimension, const char* json_path) {
+    double start_time = measure_time();
+    TreeDepths* depths = compute_ists_depths(ists, 0);  // 0 is the identity permutation
+    if (!depths) {
+        fprintf(out, "Failed to compute tree depths\n");
+        return 0;
+    }
+    
+    fprintf(out, "\n");
+    print_depth_stats(out, depths, ists->tree_count);
+    fprintf(out, "Depths computed in %.6f seconds\n", measure_time() - start_time);
+    
+    int ok = 1;
+    if (json_path && !write_depth_json(json_path, depths, ists->tree_count, dimension)) {
+        fprintf(out, "Failed to write depths to %s\n", json_path);
+        ok = 0;
+    }
+    
+    free_ists_depths(depths, ists->tree_count);
+    return ok;
+}
@@ -72,6 +72,16 @@ double measure_time() {
     return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+// Continue an FNV-1a hash over a byte range
+uint64_t fnv1a_hash(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
 // Print a permutation
 void print_permutation(Permutation* perm) {
     printf("(");
@@ -243,4 +253,78 @@ void print_spanning_tree(SpanningTree* tree, BubbleSortNetwork* network) {
         free_permutation(perm);
         free_permutation(parent_perm);
     }
-}
\ No newline at end of file
+}
+
+// Verify that the trees are spanning trees and independent, printing the progress
+// Returns 1 if all checks pass, 0 otherwise
+int report_verification(IndependentSpanningTrees* ists, BubbleSortNetwork* network) {
+    printf("\nVerifying spanning trees...\n");
+    int valid = 1;
+    for (int t = 0; t < ists->tree_count; t++) {
+        if (!verify_spanning_tree(&ists->trees[t], network)) {
+            printf("Tree %d is not a valid spanning tree\n", t + 1);
+            valid = 0;
+            break;
+        }
+    }
+    
+    if (valid) {
+        printf("All trees are valid spanning trees\n");
+        
+        // Verify independence
+        printf("\nVerifying independence...\n");
+        if (!verify_independence(ists, network)) {
+            printf("Trees are not independent\n");
+            valid = 0;
+        } else {
+            printf("All trees are independent\n");
+        }
+    }
+    
+    if (valid) {
+        printf("\nSuccessfully constructed %d valid independent spanning trees\n", ists->tree_count);
+    }
+    return valid;
+}
+
+// Print the path from vertex 4231 (Fig. 3 of the paper) to the root in each tree of B_4
+void print_example_paths(IndependentSpanningTrees* ists, int dimension) {
+    if (dimension != 4) return;
+    
+    // Find the example vertex
+    int example_index = -1;
+    for (int i = 0; i < factorial(dimension); i++) {
+        Permutation* perm = index_to_permutation(i, dimension);
+        if (perm->elements[0] == 4 && perm->elements[1] == 2 && 
+            perm->elements[2] == 3 && perm->elements[3] == 1) {
+            example_index = i;
+            free_permutation(perm);
+            break;
+        }
+        free_permutation(perm);
+    }
+    
+    if (example_index == -1) return;
+    
+    printf("\nExample paths from vertex 4231 to root in each tree:\n");
+    for (int t = 0; t < dimension - 1; t++) {
+        printf("Tree T_%d: ", t+1);
+        
+        // Trace path to root
+        int current = example_index;
+        while (current != 0) {  // 0 is the identity permutation
+            Permutation* perm = index_to_permutation(current, dimension);
+            print_permutation(perm);
+            printf(" -> ");
+            free_permutation(perm);
+            
+            current = ists->trees[t].parent[current];
+        }
+        
+        // Print root
+        Permutation* root = index_to_permutation(0, dimension);
+        print_permutation(root);
+        printf("\n");
+        free_permutation(root);
+    }
+}